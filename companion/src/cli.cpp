@@ -0,0 +1,386 @@
+/*
+ * Copyright (C) OpenTX
+ *
+ * Based on code named
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QString>
+#include <QTextStream>
+
+#include "appdata.h"
+#include "eeprominterface.h"
+#include "modelconverter.h"
+#include "modeldiff.h"
+#include "simulatorinterface.h"
+#include "simulatorrunner.h"
+#include "storage.h"
+#include "version.h"
+
+// Headless tools built on the simulator libraries
+
+QTextStream out(stdout);
+QTextStream err(stderr);
+
+#define TR(text)    QCoreApplication::translate("CliMain", text)
+
+void showHelp(QCommandLineParser & parser, const QString & addMsg = QString())
+{
+  if (!addMsg.isEmpty())
+    err << addMsg << endl << endl;
+  err << parser.helpText();
+  err << endl << TR("Available radios:") << endl;
+  foreach(QString name, SimulatorLoader::getAvailableSimulators()) {
+    err << "\t" << name << endl;
+  }
+}
+
+SimulatorInterface * loadSimulator(const QString & radio)
+{
+  SimulatorInterface * simulator = SimulatorLoader::loadSimulator(radio);
+  if (!simulator) {
+    err << TR("ERROR: simulator library for radio %1 not found.").arg(radio) << endl;
+  }
+  return simulator;
+}
+
+void unloadSimulator(SimulatorInterface * simulator, const QString & radio)
+{
+  delete simulator;
+  SimulatorLoader::unloadSimulator(radio);
+}
+
+int convertCommand(const QStringList & args)
+{
+  QCommandLineParser parser;
+  parser.setApplicationDescription(TR("Converts the radio settings and models of a SD card folder or .otx archive to the current version."));
+  parser.addHelpOption();
+
+  const QCommandLineOption optRadio(QStringList() << "radio" << "r", TR("Radio type (simulator library) to use."), TR("radio"));
+  const QCommandLineOption optJobs(QStringList() << "jobs" << "j", TR("Number of threads (default: number of cores)."), TR("count"));
+  const QCommandLineOption optOutput(QStringList() << "output" << "o", TR("Output folder or archive (default: convert in place)."), TR("path"));
+  parser.addOption(optRadio);
+  parser.addOption(optJobs);
+  parser.addOption(optOutput);
+  parser.addPositionalArgument("convert", TR("Command"));
+  parser.addPositionalArgument(TR("source"), TR("SD card folder, MODELS folder or .otx archive."));
+
+  if (!parser.parse(args)) {
+    showHelp(parser, parser.errorText());
+    return 1;
+  }
+  if (parser.isSet("help")) {
+    showHelp(parser);
+    return 0;
+  }
+  if (!parser.isSet(optRadio) || parser.positionalArguments().size() != 2) {
+    showHelp(parser, TR("ERROR: missing radio or source."));
+    return 1;
+  }
+
+  QString radio = parser.value(optRadio);
+  SimulatorInterface * simulator = loadSimulator(radio);
+  if (!simulator)
+    return 1;
+
+  ModelConverter converter(simulator);
+  if (parser.isSet(optJobs))
+    converter.setThreadCount(parser.value(optJobs).toInt());
+
+  QObject::connect(&converter, &ModelConverter::progress, [](int done, int total) {
+    err << "\r" << done << "/" << total << flush;
+  });
+
+  QString source = parser.positionalArguments().at(1);
+  bool result;
+  if (QFileInfo(source).isDir())
+    result = converter.convertFolder(source, parser.value(optOutput));
+  else
+    result = converter.convertArchive(source, parser.value(optOutput));
+  err << endl;
+
+  foreach (const ModelConverter::Result & file, converter.results()) {
+    out << file.filename << ": ";
+    if (!file.error.isEmpty())
+      out << TR("ERROR %1").arg(file.error);
+    else if (file.changed)
+      out << TR("converted from version %1").arg(file.version);
+    else
+      out << TR("up to date");
+    out << endl;
+  }
+
+  if (!result)
+    err << TR("ERROR: %1").arg(converter.errorString()) << endl;
+
+  int errors = converter.errorsCount();
+  unloadSimulator(simulator, radio);
+  return (!result || errors) ? 2 : 0;
+}
+
+int runCommand(const QStringList & args)
+{
+  QCommandLineParser parser;
+  parser.setApplicationDescription(TR("Runs the simulator without GUI, faster than real time, and captures its outputs."));
+  parser.addHelpOption();
+
+  const QCommandLineOption optRadio(QStringList() << "radio" << "r", TR("Radio type (simulator library) to use."), TR("radio"));
+  const QCommandLineOption optSdPath(QStringList() << "sd-path", TR("Path to the SD card folder."), TR("path"));
+  const QCommandLineOption optData(QStringList() << "data" << "d", TR("Radio data: eeprom file, or settings folder for radios with SD card storage."), TR("path"));
+  const QCommandLineOption optDuration(QStringList() << "time" << "t", TR("Simulated time in ms from power on (default: 10000)."), TR("ms"), "10000");
+  const QCommandLineOption optScript(QStringList() << "script" << "s", TR("Script or recording of the inputs."), TR("file"));
+  const QCommandLineOption optOutputs(QStringList() << "outputs", TR("Channel outputs capture (CSV)."), TR("file"));
+  const QCommandLineOption optSample(QStringList() << "sample", TR("Channel outputs sample interval in ms (default: 10)."), TR("ms"), "10");
+  const QCommandLineOption optLcd(QStringList() << "lcd", TR("LCD frames capture."), TR("file"));
+  const QCommandLineOption optAudio(QStringList() << "audio", TR("Audio events capture."), TR("file"));
+  const QCommandLineOption optCheckpoints(QStringList() << "checkpoints", TR("Folder of the checkpoints of the firmware state saved during the run."), TR("path"));
+  const QCommandLineOption optCheckpointInterval(QStringList() << "checkpoint-interval", TR("Checkpoints interval in ms (default: 10000)."), TR("ms"), "10000");
+  const QCommandLineOption optFrom(QStringList() << "from", TR("Start the run from a checkpoint instead of power on."), TR("file"));
+  parser.addOptions(QList<QCommandLineOption>() << optRadio << optSdPath << optData << optDuration << optScript << optOutputs << optSample << optLcd << optAudio
+                                                << optCheckpoints << optCheckpointInterval << optFrom);
+  parser.addPositionalArgument("run", TR("Command"));
+
+  if (!parser.parse(args)) {
+    showHelp(parser, parser.errorText());
+    return 1;
+  }
+  if (parser.isSet("help")) {
+    showHelp(parser);
+    return 0;
+  }
+  if (!parser.isSet(optRadio)) {
+    showHelp(parser, TR("ERROR: missing radio."));
+    return 1;
+  }
+
+  QString radio = parser.value(optRadio);
+  Firmware * firmware = Firmware::getFirmwareForId(radio);
+  SimulatorInterface * simulator = loadSimulator(radio);
+  if (!simulator)
+    return 1;
+
+  SimulatorRunner runner(simulator);
+  bool result = true;
+  if (parser.isSet(optScript))
+    result = runner.loadScript(parser.value(optScript));
+  if (result && parser.isSet(optOutputs))
+    result = runner.captureOutputs(parser.value(optOutputs), parser.value(optSample).toUInt());
+  if (result && parser.isSet(optLcd))
+    result = runner.captureLcd(parser.value(optLcd), firmware->getCapability(LcdWidth), firmware->getCapability(LcdHeight), firmware->getCapability(LcdDepth));
+  if (result && parser.isSet(optAudio))
+    result = runner.captureAudio(parser.value(optAudio));
+  if (result && parser.isSet(optCheckpoints))
+    result = runner.saveCheckpoints(parser.value(optCheckpoints), parser.value(optCheckpointInterval).toUInt());
+  if (result && parser.isSet(optFrom))
+    result = runner.startFromCheckpoint(parser.value(optFrom));
+  if (result)
+    result = runner.run(parser.value(optSdPath), parser.value(optData), parser.value(optDuration).toUInt());
+
+  if (result)
+    out << TR("%1ms simulated").arg(runner.time()) << endl;
+  else
+    err << TR("ERROR: %1").arg(runner.errorString()) << endl;
+
+  unloadSimulator(simulator, radio);
+  return result ? 0 : 2;
+}
+
+// diffs the models of two backups, the models are matched by name then by
+// slot, returns the number of models which differ or -1 on error
+int diffBackups(const QString & first, const QString & second, bool summary)
+{
+  RadioData radioData1, radioData2;
+  Storage storage1(first), storage2(second);
+  if (!storage1.load(radioData1)) {
+    err << TR("ERROR: %1: %2").arg(first).arg(storage1.error()) << endl;
+    return -1;
+  }
+  if (!storage2.load(radioData2)) {
+    err << TR("ERROR: %1: %2").arg(second).arg(storage2.error()) << endl;
+    return -1;
+  }
+
+  const std::vector<ModelData> & models1 = radioData1.models;
+  const std::vector<ModelData> & models2 = radioData2.models;
+  QVector<int> match1(models1.size(), -1);
+  QVector<int> match2(models2.size(), -1);
+  QHash<QString, QList<int>> names;
+  for (unsigned j=0; j<models2.size(); j++) {
+    if (!models2[j].isEmpty())
+      names[models2[j].name].append(j);
+  }
+  for (unsigned i=0; i<models1.size(); i++) {
+    if (models1[i].isEmpty())
+      continue;
+    QList<int> & sameName = names[models1[i].name];
+    if (!sameName.isEmpty()) {
+      match1[i] = sameName.takeFirst();
+      match2[match1[i]] = i;
+    }
+  }
+  for (unsigned i=0; i<models1.size() && i<models2.size(); i++) {
+    if (match1[i] < 0 && match2[i] < 0 && !models1[i].isEmpty() && !models2[i].isEmpty()) {
+      match1[i] = i;
+      match2[i] = i;
+    }
+  }
+
+  int differences = 0;
+  out << "--- " << first << endl << "+++ " << second << endl;
+  for (unsigned i=0; i<models1.size(); i++) {
+    if (models1[i].isEmpty())
+      continue;
+    if (match1[i] < 0) {
+      out << TR("Model %1 \"%2\": only in %3").arg(i+1).arg(models1[i].name).arg(first) << endl;
+      differences++;
+      continue;
+    }
+    const ModelData & model2 = models2[match1[i]];
+    ModelDiff diff(models1[i], radioData1.generalSettings, model2, radioData2.generalSettings);
+    if (diff.isEmpty())
+      continue;
+    differences++;
+    out << TR("Model %1 \"%2\": %3 differences").arg(i+1).arg(model2.name).arg(diff.changes().size()) << endl;
+    if (!summary)
+      out << diff.toText();
+  }
+  for (unsigned j=0; j<models2.size(); j++) {
+    if (!models2[j].isEmpty() && match2[j] < 0) {
+      out << TR("Model %1 \"%2\": only in %3").arg(j+1).arg(models2[j].name).arg(second) << endl;
+      differences++;
+    }
+  }
+
+  return differences;
+}
+
+int diffCommand(const QStringList & args)
+{
+  QCommandLineParser parser;
+  parser.setApplicationDescription(TR("Compares the models of two backups (eeprom, .otx archive or SD card folder) mix by mix and field by field.\n"
+                                      "Exit status is 0 if the models are identical, 1 if they differ, 2 on error."));
+  parser.addHelpOption();
+
+  const QCommandLineOption optRadio(QStringList() << "radio" << "r", TR("Radio type of the backups."), TR("radio"));
+  const QCommandLineOption optFolders(QStringList() << "folders", TR("Compare each backup of the first folder with the backup of the same name in the second folder."));
+  const QCommandLineOption optSummary(QStringList() << "summary", TR("Only list the models which differ."));
+  parser.addOptions(QList<QCommandLineOption>() << optRadio << optFolders << optSummary);
+  parser.addPositionalArgument("diff", TR("Command"));
+  parser.addPositionalArgument(TR("first"), TR("First backup (or folder of backups)."));
+  parser.addPositionalArgument(TR("second"), TR("Second backup (or folder of backups)."));
+
+  if (!parser.parse(args)) {
+    showHelp(parser, parser.errorText());
+    return 2;
+  }
+  if (parser.isSet("help")) {
+    showHelp(parser);
+    return 0;
+  }
+  if (!parser.isSet(optRadio) || parser.positionalArguments().size() != 3) {
+    showHelp(parser, TR("ERROR: missing radio or backups."));
+    return 2;
+  }
+
+  Firmware::setCurrentVariant(Firmware::getFirmwareForId(parser.value(optRadio)));
+
+  QString first = parser.positionalArguments().at(1);
+  QString second = parser.positionalArguments().at(2);
+  int differences = 0;
+  bool errors = false;
+
+  if (parser.isSet(optFolders)) {
+    QDir dir1(first), dir2(second);
+    QStringList filters = QStringList() << "*.bin" << "*.eepe" << "*.hex" << "*.otx";
+    foreach (const QString & filename, dir1.entryList(filters, QDir::Files, QDir::Name)) {
+      if (!dir2.exists(filename)) {
+        out << TR("%1: only in %2").arg(filename).arg(first) << endl;
+        differences++;
+        continue;
+      }
+      int result = diffBackups(dir1.filePath(filename), dir2.filePath(filename), parser.isSet(optSummary));
+      if (result < 0)
+        errors = true;
+      else
+        differences += result;
+    }
+    foreach (const QString & filename, dir2.entryList(filters, QDir::Files, QDir::Name)) {
+      if (!dir1.exists(filename)) {
+        out << TR("%1: only in %2").arg(filename).arg(second) << endl;
+        differences++;
+      }
+    }
+  }
+  else {
+    int result = diffBackups(first, second, parser.isSet(optSummary));
+    if (result < 0)
+      errors = true;
+    else
+      differences = result;
+  }
+
+  return errors ? 2 : (differences ? 1 : 0);
+}
+
+int main(int argc, char *argv[])
+{
+  QCoreApplication app(argc, argv);
+  app.setApplicationName(APP_COMPANION);
+  app.setApplicationVersion(VERSION);
+  app.setOrganizationName(COMPANY);
+  app.setOrganizationDomain(COMPANY_DOMAIN);
+
+  registerStorageFactories();
+  registerOpenTxFirmwares();
+  SimulatorLoader::registerSimulators();
+
+  QStringList args = app.arguments();
+  QString command = (args.size() > 1 ? args.at(1) : QString());
+  int result;
+
+  if (command == "convert") {
+    result = convertCommand(args);
+  }
+  else if (command == "run") {
+    result = runCommand(args);
+  }
+  else if (command == "diff") {
+    result = diffCommand(args);
+  }
+  else if (command == "--version" || command == "-v") {
+    out << APP_COMPANION << " v" VERSION " " __DATE__ << endl;
+    result = 0;
+  }
+  else {
+    err << TR("Usage: %1 <command> [options]").arg(QFileInfo(args.at(0)).fileName()) << endl << endl;
+    err << TR("Commands:") << endl;
+    err << "\tconvert\t" << TR("Convert radio settings and models to the current version") << endl;
+    err << "\trun\t" << TR("Run the simulator without GUI on a script of inputs") << endl;
+    err << "\tdiff\t" << TR("Compare the models of two backups") << endl;
+    err << endl << TR("Use <command> --help for the command options.") << endl;
+    result = (command.isEmpty() || command == "--help" || command == "-h") ? 0 : 1;
+  }
+
+  SimulatorLoader::unregisterSimulators();
+  unregisterOpenTxFirmwares();
+  unregisterStorageFactories();
+  return result;
+}
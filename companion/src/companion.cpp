@@ -261,6 +261,9 @@ int main(int argc, char *argv[])
     mainWin->show();
   }
 
+  // warm start of the simulator of the current radio
+  SimulatorLoader::preloadSimulator(getCurrentFirmware()->getId());
+
   int result = app.exec();
 
   delete splash;
@@ -22,6 +22,7 @@
 #include "ui_comparedialog.h"
 #include "appdata.h"
 #include "helpers.h"
+#include "modeldiff.h"
 #include "modelslist.h"
 #include "styleeditdialog.h"
 #include <QPrinter>
@@ -134,8 +135,15 @@ void CompareDialog::compare()
 
     ui->layout_modelNames->addWidget(hdr);
   }
-  if (modelsList.size())
-    ui->textEdit->setHtml(multimodelprinter->print(ui->textEdit->document()));
+  if (modelsList.size()) {
+    QString html = multimodelprinter->print(ui->textEdit->document());
+    // summary of the differences when comparing two models
+    if (modelsList.size() == 2) {
+      ModelDiff diff(modelsList[0].model, modelsList[0].gs, modelsList[1].model, modelsList[1].gs);
+      html.prepend(diff.toHtml());
+    }
+    ui->textEdit->setHtml(html);
+  }
 }
 
 void CompareDialog::removeModel(int idx)
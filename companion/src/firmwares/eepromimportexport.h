@@ -23,8 +23,147 @@
 
 #include "customdebug.h"
 #include <QtCore>
-#include <QBitArray>
+#include <string.h>
 #include <utility>
+#include <vector>
+
+// Bit stream written LSB first, as the radio bitfields, on 64 bits words;
+// whole bytes are copied at once when the stream is byte aligned
+class BitWriter {
+  public:
+    BitWriter():
+      length(0)
+    {
+    }
+
+    void write(quint64 value, unsigned int count)
+    {
+      if (count > 64) {
+        write(value, 64);
+        skip(count - 64);
+        return;
+      }
+      if (count < 64)
+        value &= ((quint64)1 << count) - 1;
+      unsigned int index = length / 64;
+      unsigned int shift = length % 64;
+      skip(count);
+      words[index] |= value << shift;
+      if (shift && shift + count > 64)
+        words[index + 1] |= value >> (64 - shift);
+    }
+
+    void writeBytes(const char * data, unsigned int count)
+    {
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+      if (length % 8 == 0) {
+        unsigned int offset = length / 8;
+        skip(8 * count);
+        memcpy((char *)words.data() + offset, data, count);
+        return;
+      }
+#endif
+      for (unsigned int i=0; i<count; i++)
+        write((quint8)data[i], 8);
+    }
+
+    // zeros
+    void skip(unsigned int count)
+    {
+      length += count;
+      if (words.size() * 64 < length)
+        words.resize((length + 63) / 64, 0);
+    }
+
+    void padTo(unsigned int position)
+    {
+      if (length < position)
+        skip(position - length);
+    }
+
+    unsigned int size() const
+    {
+      return length;
+    }
+
+    QByteArray toByteArray() const
+    {
+      QByteArray result((length + 7) / 8, 0);
+      for (int i=0; i<result.size(); i++)
+        result[i] = (char)(words[i / 8] >> (8 * (i % 8)));
+      return result;
+    }
+
+  protected:
+    std::vector<quint64> words;
+    unsigned int length;
+};
+
+class BitReader {
+  public:
+    explicit BitReader(const QByteArray & data):
+      data(data),
+      position(0)
+    {
+    }
+
+    // bits after the end of the data read as zeros
+    quint64 read(unsigned int count)
+    {
+      if (count > 64) {
+        quint64 value = read(64);
+        skip(count - 64);
+        return value;
+      }
+      if (count > 32) {
+        quint64 low = read(32);
+        return low | (read(count - 32) << 32);
+      }
+      quint64 value = 0;
+      unsigned int first = position / 8;
+      unsigned int last = qMin<unsigned int>((position + count + 7) / 8, data.size());
+      for (unsigned int i=first; i<last; i++)
+        value |= (quint64)(quint8)data.at(i) << (8 * (i - first));
+      value = (value >> (position % 8)) & (((quint64)1 << count) - 1);
+      position += count;
+      return value;
+    }
+
+    void readBytes(char * dest, unsigned int count)
+    {
+      if (position % 8 == 0 && position / 8 + count <= (unsigned int)data.size()) {
+        memcpy(dest, data.constData() + position / 8, count);
+        position += 8 * count;
+        return;
+      }
+      for (unsigned int i=0; i<count; i++)
+        dest[i] = (char)read(8);
+    }
+
+    void skip(unsigned int count)
+    {
+      position += count;
+    }
+
+    void seek(unsigned int pos)
+    {
+      position = pos;
+    }
+
+    unsigned int pos() const
+    {
+      return position;
+    }
+
+    unsigned int size() const
+    {
+      return 8 * data.size();
+    }
+
+  protected:
+    const QByteArray data;
+    unsigned int position;
+};
 
 class DataField {
   Q_DECLARE_TR_FUNCTIONS(DataField)
@@ -45,42 +184,21 @@ class DataField {
     }
 
     virtual unsigned int size() = 0; // size in bits
-    virtual void ExportBits(QBitArray & output) = 0;
-    virtual void ImportBits(const QBitArray & input) = 0;
-
-    static QBitArray bytesToBits(QByteArray bytes)
-    {
-      QBitArray bits(bytes.count()*8);
-      // Convert from QByteArray to QBitArray
-      for (int i=0; i<bytes.count(); ++i)
-        for (int b=0; b<8; ++b)
-          bits.setBit(i*8+b, bytes.at(i)&(1<<b));
-      return bits;
-    }
-
-    static QByteArray bitsToBytes(QBitArray bits, int offset=0)
-    {
-      QByteArray bytes;
-      bytes.resize((offset+bits.count()+7)/8);
-      bytes.fill(0);
-      // Convert from QBitArray to QByteArray
-      for (int b=0; b<bits.count(); ++b)
-        bytes[(b+offset)/8] = ( bytes.at((b+offset)/8) | ((bits[b]?1:0)<<((b+offset)%8)));
-      return bytes;
-    }
+    virtual void ExportBits(BitWriter & output) = 0;
+    virtual void ImportBits(BitReader & input) = 0;
 
     int Export(QByteArray & output)
     {
-      QBitArray result;
+      BitWriter result;
       ExportBits(result);
-      output = bitsToBytes(result);
+      output = result.toByteArray();
       return 0;
     }
 
     int Import(const QByteArray & input)
     {
-      QBitArray bits = bytesToBits(input);
-      if (unsigned(bits.size()) < size()) {
+      BitReader bits(input);
+      if (bits.size() < size()) {
         qDebug() << QString("Error importing %1: size too small %2 bits / %3 bits").arg(getName()).arg(bits.size()).arg(size());
         return -1;
       }
@@ -90,15 +208,15 @@ class DataField {
 
     virtual int dump(int level=0, int offset=0)
     {
-      QBitArray bits;
+      BitWriter bits;
       ExportBits(bits);
-      QByteArray bytes = bitsToBytes(bits);
-      int result = (offset+bits.count()) % 8;
+      QByteArray bytes = bits.toByteArray();
+      int result = (offset+bits.size()) % 8;
       for (int i=0; i<level; i++) printf("  ");
-      if (bits.count() % 8 == 0)
+      if (bits.size() % 8 == 0)
         printf("%s (%dbytes) ", getName().toLatin1().constData(), bytes.count());
       else
-        printf("%s (%dbits) ", getName().toLatin1().constData(), bits.count());
+        printf("%s (%dbits) ", getName().toLatin1().constData(), bits.size());
       for (int i=0; i<bytes.count(); i++) {
         unsigned char c = bytes[i];
         if ((i==0 && offset) || (i==bytes.count()-1 && result!=0))
@@ -165,27 +283,21 @@ class BaseUnsignedField: public DataField {
 
     BaseUnsignedField() = delete;
 
-    void ExportBits(QBitArray & output) override
+    void ExportBits(BitWriter & output) override
     {
       container value = field;
       if (value > max) value = max;
       if (value < min) value = min;
 
-      output.resize(N);
-      for (int i=0; i<N; i++) {
-        if (value & ((container)1<<i)) {
-          output.setBit(i);
-        }
-      }
+      output.write(value, N);
     }
 
-    void ImportBits(const QBitArray & input) override
+    void ImportBits(BitReader & input) override
     {
-      field = 0;
-      for (int i=0; i<N; i++) {
-        if (input[i])
-          field |= ((container)1<<i);
-      }
+      // bits above the container width are spare
+      const unsigned int width = qMin<unsigned int>(N, 8 * sizeof(container));
+      field = (container)input.read(width);
+      input.skip(N - width);
       qCDebug(eepromImport) << QString("\timported %1<%2>: 0x%3(%4)").arg(name).arg(N).arg(field, 0, 16).arg(field);
     }
 
@@ -231,17 +343,15 @@ class BoolField: public DataField {
 
     BoolField() = delete;
 
-    void ExportBits(QBitArray & output) override
+    void ExportBits(BitWriter & output) override
     {
-      output.resize(N);
-      if (field) {
-        output.setBit(0);
-      }
+      output.write(field ? 1 : 0, N);
     }
 
-    void ImportBits(const QBitArray & input) override
+    void ImportBits(BitReader & input) override
     {
-      field = input[0];
+      field = input.read(1);
+      input.skip(N - 1);
       qCDebug(eepromImport) << QString("\timported %1<%2>: 0x%3(%4)").arg(name).arg(N).arg(field, 0, 16).arg(field);
     }
 
@@ -277,31 +387,21 @@ class SignedField: public DataField {
     {
     }
 
-    void ExportBits(QBitArray & output) override
+    void ExportBits(BitWriter & output) override
     {
       int value = field;
       if (value > max) value = max;
       if (value < min) value = min;
 
-      output.resize(N);
-      for (int i=0; i<N; i++) {
-        if (((unsigned int)value) & (1<<i))
-          output.setBit(i);
-      }
+      output.write((unsigned int)value, N);
     }
 
-    void ImportBits(const QBitArray & input) override
+    void ImportBits(BitReader & input) override
     {
-      unsigned int value = 0;
-      for (int i=0; i<N; i++) {
-        if (input[i])
-          value |= (1<<i);
-      }
+      unsigned int value = input.read(N);
 
-      if (input[N-1]) {
-        for (unsigned int i=N; i<8*sizeof(int); i++) {
-          value |= (1<<i);
-        }
+      if (N < 8*sizeof(int) && (value & (1u << (N-1)))) {
+        value |= ~0u << N;
       }
 
       field = (int)value;
@@ -342,31 +442,18 @@ class CharField: public DataField {
     {
     }
 
-    void ExportBits(QBitArray & output) override
+    void ExportBits(BitWriter & output) override
     {
-      output.resize(N*8);
-      int b = 0;
       int len = truncate ? strlen(field) : N;
-      for (int i=0; i<N; i++) {
-        int idx = (i>=len ? 0 : field[i]);
-        for (int j=0; j<8; j++, b++) {
-          if (idx & (1<<j))
-            output.setBit(b);
-        }
-      }
+      if (len > N)
+        len = N;
+      output.writeBytes(field, len);
+      output.skip(8 * (N - len));
     }
 
-    void ImportBits(const QBitArray & input) override
+    void ImportBits(BitReader & input) override
     {
-      unsigned int b = 0;
-      for (int i=0; i<N; i++) {
-        int8_t idx = 0;
-        for (int j=0; j<8; j++) {
-          if (input[b++])
-            idx |= (1<<j);
-        }
-        field[i] = idx;
-      }
+      input.readBytes(field, N);
       qCDebug(eepromImport) << QString("\timported %1<%2>: '%3'").arg(name).arg(N).arg(field);
     }
 
@@ -417,30 +504,22 @@ class ZCharField: public DataField {
     {
     }
 
-    void ExportBits(QBitArray & output) override
+    void ExportBits(BitWriter & output) override
     {
-      output.resize(N*8);
-      int b = 0;
+      char zchars[N];
       int len = strlen(field);
       for (int i=0; i<N; i++) {
-        int idx = i>=len ? 0 : char2zchar(field[i]);
-        for (int j=0; j<8; j++, b++) {
-          if (idx & (1<<j))
-            output.setBit(b);
-        }
+        zchars[i] = i>=len ? 0 : char2zchar(field[i]);
       }
+      output.writeBytes(zchars, N);
     }
 
-    void ImportBits(const QBitArray & input) override
+    void ImportBits(BitReader & input) override
     {
-      unsigned int b = 0;
+      char zchars[N];
+      input.readBytes(zchars, N);
       for (int i=0; i<N; i++) {
-        int8_t idx = 0;
-        for (int j=0; j<8; j++) {
-          if (input[b++])
-            idx |= (1<<j);
-        }
-        field[i] = zchar2char(idx);
+        field[i] = zchar2char(zchars[i]);
       }
 
       field[N] = '\0';
@@ -480,29 +559,25 @@ class StructField: public DataField {
       fields.append(field);
     }
 
-    void ExportBits(QBitArray & output) override
+    void ExportBits(BitWriter & output) override
     {
-      int offset = 0;
-      output.resize(size());
+      unsigned int end = output.size() + size();
       foreach(DataField *field, fields) {
-        QBitArray bits;
-        field->ExportBits(bits);
-        for (int i=0; i<bits.size(); i++)
-          output[offset++] = bits[i];
+        field->ExportBits(output);
       }
+      output.padTo(end);
     }
 
-    void ImportBits(const QBitArray & input) override
+    void ImportBits(BitReader & input) override
     {
       qCDebug(eepromImport) << QString("\timporting %1[%2]:").arg(name).arg(fields.size());
-      int offset = 0;
+      // each field gets exactly its size, whatever it reads
+      unsigned int offset = input.pos();
       foreach(DataField *field, fields) {
         unsigned int size = field->size();
-        QBitArray bits(size);
-        for (unsigned int i=0; i<size; i++) {
-          bits[i] = input[offset++];
-        }
-        field->ImportBits(bits);
+        field->ImportBits(input);
+        offset += size;
+        input.seek(offset);
       }
     }
 
@@ -540,13 +615,13 @@ class TransformedField: public DataField {
     ~TransformedField() override
     = default;
 
-    void ExportBits(QBitArray & output) override
+    void ExportBits(BitWriter & output) override
     {
       beforeExport();
       field.ExportBits(output);
     }
 
-    void ImportBits(const QBitArray & input) override
+    void ImportBits(BitReader & input) override
     {
       qCDebug(eepromImport) << QString("\timporting TransformedField %1:").arg(field.getName());
       field.ImportBits(input);
@@ -619,18 +694,19 @@ class UnionField: public DataField {
         maxSize = member->getField()->size();
     }
 
-    void ExportBits(QBitArray & output) override
+    void ExportBits(BitWriter & output) override
     {
+      unsigned int start = output.size();
       foreach(UnionMember *member, members) {
         if (member->select(selectField)) {
           member->getField()->ExportBits(output);
           break;
         }
       }
-      output.resize(maxSize);
+      output.padTo(start + maxSize);
     }
 
-    void ImportBits(const QBitArray & input) override
+    void ImportBits(BitReader & input) override
     {
       foreach(UnionMember *member, members) {
         if (member->select(selectField)) {
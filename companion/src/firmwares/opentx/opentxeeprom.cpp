@@ -20,6 +20,7 @@
 
 #include <cstdlib>
 #include <algorithm>
+#include <QMutex>
 #include "boards.h"
 #include "helpers.h"
 #include "opentxeeprom.h"
@@ -243,11 +244,14 @@ class SwitchesConversionTable: public ConversionTable {
     };
 
     static std::list<Cache> internalCache;
+    static QMutex internalCacheMutex;
 
   public:
 
     static SwitchesConversionTable * getInstance(Board::Type board, unsigned int version, unsigned long flags=0)
     {
+      // the models may be imported / exported by several threads
+      QMutexLocker locker(&internalCacheMutex);
       for (auto & element : internalCache) {
         if (element.board == board && element.version == version && element.flags == flags)
           return element.table;
@@ -267,6 +271,7 @@ class SwitchesConversionTable: public ConversionTable {
 };
 
 std::list<SwitchesConversionTable::Cache> SwitchesConversionTable::internalCache;
+QMutex SwitchesConversionTable::internalCacheMutex;
 
 #define FLAG_NONONE       0x01
 #define FLAG_NOSWITCHES   0x02
@@ -372,11 +377,13 @@ class SourcesConversionTable: public ConversionTable {
         SourcesConversionTable * table;
     };
     static std::list<Cache> internalCache;
+    static QMutex internalCacheMutex;
 
   public:
 
     static SourcesConversionTable * getInstance(Board::Type board, unsigned int version, unsigned int variant, unsigned long flags=0)
     {
+      QMutexLocker locker(&internalCacheMutex);
       for (std::list<Cache>::iterator it=internalCache.begin(); it!=internalCache.end(); it++) {
         Cache & element = *it;
         if (element.board == board && element.version == version && element.variant == variant && element.flags == flags)
@@ -399,6 +406,7 @@ class SourcesConversionTable: public ConversionTable {
 };
 
 std::list<SourcesConversionTable::Cache> SourcesConversionTable::internalCache;
+QMutex SourcesConversionTable::internalCacheMutex;
 
 void OpenTxEepromCleanup(void)
 {
@@ -1665,7 +1673,7 @@ class FrskyScreenField: public DataField {
         none.Append(new SpareBitsField<20*8>(this));
     }
 
-    void ExportBits(QBitArray & output) override
+    void ExportBits(BitWriter & output) override
     {
       if (screen.type == TELEMETRY_SCREEN_SCRIPT)
         script.ExportBits(output);
@@ -1677,7 +1685,7 @@ class FrskyScreenField: public DataField {
         none.ExportBits(output);
     }
 
-    void ImportBits(const QBitArray & input) override
+    void ImportBits(BitReader & input) override
     {
       qCDebug(eepromImport) << QString("importing %1: type: %2").arg(name).arg(screen.type);
 
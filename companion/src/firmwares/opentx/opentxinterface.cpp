@@ -183,10 +183,40 @@ bool OpenTxEepromInterface::loadFromByteArray(T & dest, const QByteArray & data)
   }
   qDebug() << QString().sprintf("%s: OK", getName());
   uint8_t version = data[4];
-  QByteArray raw = data.right(data.size() - 8);
+  int size = qMin<int>(*((uint16_t*)&data.data()[6]), data.size() - 8);
+  QByteArray raw = data.mid(8, size);
+  applyModelJournal(raw, data.mid(8 + size));
   return loadFromByteArray<T, M>(dest, raw, version);
 }
 
+static uint8_t journalCrc8(const uint8_t * ptr, int len, uint8_t crc)
+{
+  for (int i = 0; i < len; i++) {
+    crc ^= ptr[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x80) ? (crc << 1) ^ 0xD5 : (crc << 1);
+    }
+  }
+  return crc;
+}
+
+void applyModelJournal(QByteArray & data, const QByteArray & journal)
+{
+  const int headerSize = 4;   // offset (16 bits), size, crc
+  int pos = 0;
+  while (pos + headerSize <= journal.size()) {
+    const uint8_t * record = (const uint8_t *)journal.constData() + pos;
+    int offset = record[0] + (record[1] << 8);
+    int size = record[2];
+    if (size > 64 || pos + headerSize + size > journal.size() || offset + size > data.size())
+      break;
+    if (journalCrc8(record + headerSize, size, journalCrc8(record, 3, 0)) != record[3])
+      break;
+    memcpy(data.data() + offset, record + headerSize, size);
+    pos += headerSize + size;
+  }
+}
+
 unsigned long OpenTxEepromInterface::load(RadioData &radioData, const uint8_t * eeprom, int size)
 {
   QDebug dbg = qDebug();
@@ -135,6 +135,11 @@ void unregisterOpenTxFirmwares();
 
 extern QList<OpenTxEepromInterface *> opentxEEpromInterfaces;
 
+// The radio appends the changes of the current model after the model data, as records of
+// offset (16 bits), size and crc8 followed by the changed bytes (radio/src/storage/sdcard_raw.cpp).
+// They are applied until the first invalid one, like the radio does
+void applyModelJournal(QByteArray & data, const QByteArray & journal);
+
 OpenTxEepromInterface * loadModelFromByteArray(ModelData & model, const QByteArray & data);
 OpenTxEepromInterface * loadRadioSettingsFromByteArray(GeneralSettings & settings, const QByteArray & data);
 
@@ -97,6 +97,12 @@ QString RadioData::getNextModelFilename()
         break;
       }
     }
+    foreach (const ModelErrorData & error, modelErrors) {
+      if (error.filename == filename) {
+        found = true;
+        break;
+      }
+    }
   }
   return filename;
 }
@@ -16,6 +16,20 @@ class CategoryData {
     char name[15+1];
 };
 
+// a model which could not be loaded, its file is saved back unchanged
+class ModelErrorData {
+  public:
+    ModelErrorData():
+      category(0)
+    {
+    }
+
+    QString filename;
+    int category;
+    QByteArray data;
+    QString error;
+};
+
 class RadioData {
   Q_DECLARE_TR_FUNCTIONS(RadioData)
 
@@ -25,6 +39,7 @@ class RadioData {
     GeneralSettings generalSettings;
     std::vector<CategoryData> categories;
     std::vector<ModelData> models;
+    QMap<int, ModelErrorData> modelErrors; // models which could not be loaded, by slot
 
     void convert(RadioDataConversionState & cstate);
 
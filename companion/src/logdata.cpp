@@ -0,0 +1,434 @@
+/*
+ * Copyright (C) OpenTX
+ *
+ * Based on code named
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "logdata.h"
+
+#include <QVarLengthArray>
+#include <algorithm>
+#include <cstring>
+
+#define SESSION_BREAK_SECS     60
+#define PROGRESS_LINES         4096
+#define LOD_FACTOR             4
+
+static inline bool isBlank(char c)
+{
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+static bool parseNumber(const char * s, int len, int & value)
+{
+  value = 0;
+  for (int i=0; i<len; i++) {
+    if (s[i] < '0' || s[i] > '9')
+      return false;
+    value = value * 10 + (s[i] - '0');
+  }
+  return len > 0;
+}
+
+// "yyyy-MM-dd" date and "HH:mm:ss[.zzz]" time, in local time like QDateTime::fromString()
+class TimestampParser
+{
+  public:
+    TimestampParser():
+      lastDate(-1),
+      lastDateMsecs(LOG_INVALID_TIMESTAMP)
+    {
+    }
+
+    qint64 parse(const char * date, int dateLen, const char * time, int timeLen)
+    {
+      int year, month, day, hours, minutes, seconds, msecs = 0;
+      if (dateLen != 10 || date[4] != '-' || date[7] != '-' || timeLen < 8 || time[2] != ':' || time[5] != ':')
+        return LOG_INVALID_TIMESTAMP;
+      if (!parseNumber(date, 4, year) || !parseNumber(date+5, 2, month) || !parseNumber(date+8, 2, day))
+        return LOG_INVALID_TIMESTAMP;
+      if (!parseNumber(time, 2, hours) || !parseNumber(time+3, 2, minutes) || !parseNumber(time+6, 2, seconds) || hours > 23 || minutes > 59 || seconds > 59)
+        return LOG_INVALID_TIMESTAMP;
+      if (timeLen > 8) {
+        // fractional part, with a milliseconds resolution
+        if (time[8] != '.' || timeLen == 9)
+          return LOG_INVALID_TIMESTAMP;
+        int scale = 100;
+        for (int i=9; i<timeLen; i++) {
+          if (time[i] < '0' || time[i] > '9')
+            return LOG_INVALID_TIMESTAMP;
+          msecs += (time[i] - '0') * scale;
+          scale /= 10;
+        }
+      }
+
+      // the date conversion is the slow part, it changes at most once a day
+      int key = (year * 100 + month) * 100 + day;
+      if (key != lastDate) {
+        QDate qdate(year, month, day);
+        lastDate = key;
+        lastDateMsecs = qdate.isValid() ? QDateTime(qdate, QTime(0, 0)).toMSecsSinceEpoch() : LOG_INVALID_TIMESTAMP;
+      }
+      if (lastDateMsecs == LOG_INVALID_TIMESTAMP)
+        return LOG_INVALID_TIMESTAMP;
+      return lastDateMsecs + ((hours * 60 + minutes) * 60 + seconds) * 1000 + msecs;
+    }
+
+  protected:
+    int lastDate;
+    qint64 lastDateMsecs;
+};
+
+// same result as QString::toDouble(), 0 when the text is not a number
+static double parseValue(const char * s, int len)
+{
+  static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18 };
+
+  // plain decimal numbers: the mantissa and the power of ten are exact,
+  // so is the division
+  const char * p = s;
+  const char * end = s + len;
+  while (p < end && isBlank(*p)) p++;
+  while (end > p && isBlank(end[-1])) end--;
+  bool negative = (p < end && *p == '-');
+  if (p < end && (*p == '-' || *p == '+')) p++;
+  quint64 mantissa = 0;
+  int digits = 0;
+  int decimals = -1;
+  for (; p < end; p++) {
+    if (*p >= '0' && *p <= '9') {
+      mantissa = mantissa * 10 + (*p - '0');
+      if (++digits > 15)
+        break;
+      if (decimals >= 0)
+        decimals++;
+    }
+    else if (*p == '.' && decimals < 0) {
+      decimals = 0;
+    }
+    else {
+      break;
+    }
+  }
+
+  if (p == end && digits > 0) {
+    double value = (double)mantissa;
+    if (decimals > 0)
+      value /= powers[decimals];
+    return negative ? -value : value;
+  }
+
+  return QByteArray(s, len).toDouble();
+}
+
+LogData::LogData():
+  data(nullptr),
+  headerLength(0),
+  m_invalidLines(0),
+  m_sorted(false)
+{
+}
+
+LogData::~LogData()
+{
+  clear();
+}
+
+void LogData::clear()
+{
+  if (file.isOpen()) {
+    if (contents.isEmpty())
+      file.unmap((uchar *)data);
+    file.close();
+  }
+  contents.clear();
+  data = nullptr;
+  headerLength = 0;
+  m_header.clear();
+  rowStart.clear();
+  rowLength.clear();
+  timestamps.clear();
+  columns.clear();
+  lods.clear();
+  m_sessions.clear();
+  m_sorted = false;
+  m_invalidLines = 0;
+}
+
+bool LogData::load(const QString & filename, ProgressCallback progress)
+{
+  clear();
+
+  file.setFileName(filename);
+  if (!file.open(QIODevice::ReadOnly) || file.size() == 0) {
+    file.close();
+    return false;
+  }
+
+  qint64 size = file.size();
+  data = (const char *)file.map(0, size);
+  if (!data) {
+    contents = file.readAll();
+    data = contents.constData();
+  }
+
+  const char * end = data + size;
+  const char * eol = (const char *)memchr(data, '\n', size);
+  if (!eol)
+    eol = end;
+  headerLength = eol - data;
+  while (headerLength > 0 && isBlank(data[headerLength-1]))
+    headerLength--;
+  QString header = QString::fromUtf8(data, headerLength);
+  if (!header.startsWith("Date,Time")) {
+    clear();
+    return false;
+  }
+  m_header = header.split(',');
+
+  int numfields = m_header.size();
+  columns.resize(numfields);
+  // the number of rows is estimated from the first one, it only saves reallocations
+  int estimate = (eol - data) > 0 ? qMin<qint64>(size / (eol - data + 1), std::numeric_limits<int>::max() / 2) : 0;
+  rowStart.reserve(estimate);
+  rowLength.reserve(estimate);
+  timestamps.reserve(estimate);
+  for (int i=2; i<numfields; i++) {
+    columns[i].reserve(estimate);
+  }
+
+  TimestampParser timestampParser;
+  QVarLengthArray<const char *, 64> fields(numfields + 1);
+  qint64 lastTimestamp = LOG_INVALID_TIMESTAMP;
+  int lines = 0;
+  int percent = -1;
+
+  for (const char * line = eol + 1; line < end; line = eol + 1) {
+    eol = (const char *)memchr(line, '\n', end - line);
+    if (!eol)
+      eol = end;
+
+    if (progress && (++lines % PROGRESS_LINES) == 0 && (line - data) * 100 / size != percent) {
+      percent = (line - data) * 100 / size;
+      if (!progress(percent)) {
+        clear();
+        return false;
+      }
+    }
+
+    const char * start = line;
+    const char * stop = eol;
+    while (start < stop && isBlank(*start)) start++;
+    while (stop > start && isBlank(stop[-1])) stop--;
+
+    // fields[i] is the start of field i, fields[numfields] the end of the line + 1
+    int count = 0;
+    fields[count++] = start;
+    for (const char * p = start; p < stop; p++) {
+      if (*p == ',') {
+        if (count == numfields) {
+          count++;
+          break;
+        }
+        fields[count++] = p + 1;
+      }
+    }
+    if (count != numfields) {
+      m_invalidLines++;
+      continue;
+    }
+    fields[numfields] = stop + 1;
+
+    qint64 timestamp = timestampParser.parse(fields[0], fields[1] - fields[0] - 1, fields[1], numfields > 2 ? fields[2] - fields[1] - 1 : stop - fields[1]);
+    if (lastTimestamp == LOG_INVALID_TIMESTAMP || (timestamp != LOG_INVALID_TIMESTAMP && (timestamp - lastTimestamp) / 1000 > SESSION_BREAK_SECS)) {
+      m_sessions.append(rowStart.size());
+    }
+    lastTimestamp = timestamp;
+
+    rowStart.append(start - data);
+    rowLength.append(stop - start);
+    timestamps.append(timestamp);
+    for (int i=2; i<numfields; i++) {
+      columns[i].append(parseValue(fields[i], fields[i+1] - fields[i] - 1));
+    }
+  }
+
+  m_sorted = !timestamps.contains(LOG_INVALID_TIMESTAMP) && std::is_sorted(timestamps.begin(), timestamps.end());
+  lods.resize(numfields);
+  for (int i=2; i<numfields; i++) {
+    buildLod(i);
+  }
+
+  if (progress)
+    progress(100);
+
+  return true;
+}
+
+void LogData::buildLod(int column)
+{
+  const QVector<double> & values = columns[column];
+  QVector<LodLevel> & levels = lods[column];
+  int count = values.size();
+
+  // each level is built from the previous one, the first one from the samples
+  for (int size = LOD_FACTOR; size < count; size *= LOD_FACTOR) {
+    const LodLevel * previous = levels.isEmpty() ? nullptr : &levels.last();
+    int children = previous ? previous->minRows.size() : count;
+    int blocks = (children + LOD_FACTOR - 1) / LOD_FACTOR;
+    LodLevel level;
+    level.minRows.resize(blocks);
+    level.maxRows.resize(blocks);
+    for (int b=0; b<blocks; b++) {
+      int minRow = previous ? previous->minRows[b * LOD_FACTOR] : b * LOD_FACTOR;
+      int maxRow = previous ? previous->maxRows[b * LOD_FACTOR] : b * LOD_FACTOR;
+      for (int c=b*LOD_FACTOR+1; c<qMin(children, (b+1)*LOD_FACTOR); c++) {
+        int row = previous ? previous->minRows[c] : c;
+        if (values[row] < values[minRow])
+          minRow = row;
+        row = previous ? previous->maxRows[c] : c;
+        if (values[row] > values[maxRow])
+          maxRow = row;
+      }
+      level.minRows[b] = minRow;
+      level.maxRows[b] = maxRow;
+    }
+    levels.append(level);
+  }
+}
+
+int LogData::findRow(qint64 timestamp) const
+{
+  return std::lower_bound(timestamps.begin(), timestamps.end(), timestamp) - timestamps.begin();
+}
+
+void LogData::samples(int column, int first, int last, int maxPoints, QVector<int> & rows) const
+{
+  const QVector<double> & values = columns[column];
+  const QVector<LodLevel> & levels = lods[column];
+  int count = last - first + 1;
+
+  rows.clear();
+  if (count <= 0)
+    return;
+
+  // the highest level which still gives maxPoints / 2 blocks (2 points per block)
+  int level = 0;
+  int size = 1;
+  while (level < levels.size() && count / (size * LOD_FACTOR) >= maxPoints / 2) {
+    size *= LOD_FACTOR;
+    level++;
+  }
+
+  if (level == 0) {
+    rows.reserve(count);
+    for (int row=first; row<=last; row++) {
+      rows.append(row);
+    }
+    return;
+  }
+
+  const LodLevel & lod = levels[level - 1];
+  rows.reserve(2 * (last / size - first / size + 1));
+  for (int b=first/size; b<=last/size; b++) {
+    int start = qMax(first, b * size);
+    int end = qMin(last, (b + 1) * size - 1);
+    int minRow, maxRow;
+    if (start == b * size && (end == (b + 1) * size - 1 || end == values.size() - 1)) {
+      minRow = lod.minRows[b];
+      maxRow = lod.maxRows[b];
+    }
+    else {
+      // partial block at the ends of the range
+      minRow = maxRow = start;
+      for (int row=start+1; row<=end; row++) {
+        if (values[row] < values[minRow])
+          minRow = row;
+        if (values[row] > values[maxRow])
+          maxRow = row;
+      }
+    }
+    rows.append(qMin(minRow, maxRow));
+    if (minRow != maxRow)
+      rows.append(qMax(minRow, maxRow));
+  }
+}
+
+QByteArray LogData::headerLine() const
+{
+  return QByteArray(data, headerLength);
+}
+
+QByteArray LogData::line(int row) const
+{
+  return QByteArray(data + rowStart[row], rowLength[row]);
+}
+
+QString LogData::text(int row, int column) const
+{
+  const char * p = data + rowStart[row];
+  const char * end = p + rowLength[row];
+  for (int i=0; i<column; i++) {
+    p = (const char *)memchr(p, ',', end - p) + 1;
+  }
+  const char * comma = (const char *)memchr(p, ',', end - p);
+  return QString::fromUtf8(p, (comma ? comma : end) - p);
+}
+
+QDateTime LogData::dateTime(int row) const
+{
+  if (timestamps[row] == LOG_INVALID_TIMESTAMP)
+    return QDateTime();
+  return QDateTime::fromMSecsSinceEpoch(timestamps[row]);
+}
+
+LogTableModel::LogTableModel(QObject * parent):
+  QAbstractTableModel(parent),
+  log(nullptr)
+{
+}
+
+void LogTableModel::setLog(const LogData * log)
+{
+  beginResetModel();
+  this->log = log;
+  endResetModel();
+}
+
+int LogTableModel::rowCount(const QModelIndex & parent) const
+{
+  return (log && !parent.isValid()) ? log->rowCount() : 0;
+}
+
+int LogTableModel::columnCount(const QModelIndex & parent) const
+{
+  return (log && !parent.isValid()) ? log->columnCount() : 0;
+}
+
+QVariant LogTableModel::data(const QModelIndex & index, int role) const
+{
+  if (!log || !index.isValid() || role != Qt::DisplayRole)
+    return QVariant();
+  return log->text(index.row(), index.column());
+}
+
+QVariant LogTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+  if (!log || orientation != Qt::Horizontal || role != Qt::DisplayRole)
+    return QAbstractTableModel::headerData(section, orientation, role);
+  return log->header().value(section);
+}
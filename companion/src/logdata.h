@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) OpenTX
+ *
+ * Based on code named
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef _LOGDATA_H_
+#define _LOGDATA_H_
+
+#include <QAbstractTableModel>
+#include <QDateTime>
+#include <QFile>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+#include <limits>
+
+#define LOG_INVALID_TIMESTAMP    std::numeric_limits<qint64>::min()
+
+// A telemetry log (CSV file written by the radio), memory mapped and parsed
+// in one pass: the values of the data columns and the timestamps are stored
+// in typed arrays, the texts are read from the mapped file on demand.
+class LogData
+{
+  public:
+    // returns false to cancel the load
+    typedef std::function<bool(int percent)> ProgressCallback;
+
+    LogData();
+    ~LogData();
+
+    bool load(const QString & filename, ProgressCallback progress = nullptr);
+    void clear();
+
+    int rowCount() const { return rowStart.size(); }
+    int columnCount() const { return m_header.size(); }
+    const QStringList & header() const { return m_header; }
+    int invalidLines() const { return m_invalidLines; }
+
+    QString text(int row, int column) const;
+    QByteArray headerLine() const;
+    QByteArray line(int row) const;
+
+    // msecs since epoch, LOG_INVALID_TIMESTAMP when the date / time can't be parsed
+    qint64 timestamp(int row) const { return timestamps[row]; }
+    QDateTime dateTime(int row) const;
+    // values of a data column (the first two columns are the date and the time)
+    const QVector<double> & column(int column) const { return columns[column]; }
+    // first row of each flight session
+    const QVector<int> & sessions() const { return m_sessions; }
+
+    // true when all the timestamps are valid and in order
+    bool isSorted() const { return m_sorted; }
+    // first row at or after a timestamp, only for sorted logs
+    int findRow(qint64 timestamp) const;
+    // rows of the samples of a data column between first and last (included)
+    // to be plotted with about maxPoints points: the rows of the min and of
+    // the max of each block of rows of the level of detail pyramid
+    void samples(int column, int first, int last, int maxPoints, QVector<int> & rows) const;
+
+  protected:
+    // rows of the min and of the max of the blocks of a level of detail
+    struct LodLevel {
+      QVector<int> minRows;
+      QVector<int> maxRows;
+    };
+
+    void buildLod(int column);
+
+    QFile file;
+    QByteArray contents;  // when the file can't be mapped
+    const char * data;
+    qint64 headerLength;
+    QStringList m_header;
+    QVector<qint64> rowStart;
+    QVector<int> rowLength;
+    QVector<qint64> timestamps;
+    QVector<QVector<double>> columns;
+    QVector<QVector<LodLevel>> lods;
+    QVector<int> m_sessions;
+    int m_invalidLines;
+    bool m_sorted;
+};
+
+// Read only model of a LogData for the log table
+class LogTableModel : public QAbstractTableModel
+{
+  Q_OBJECT
+
+  public:
+    LogTableModel(QObject * parent = nullptr);
+
+    // the log must not be modified while it is set
+    void setLog(const LogData * log);
+
+    virtual int rowCount(const QModelIndex & parent = QModelIndex()) const;
+    virtual int columnCount(const QModelIndex & parent = QModelIndex()) const;
+    virtual QVariant data(const QModelIndex & index, int role = Qt::DisplayRole) const;
+    virtual QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+
+  protected:
+    const LogData * log;
+};
+
+#endif // _LOGDATA_H_
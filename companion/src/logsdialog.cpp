@@ -23,6 +23,7 @@
 #include "appdata.h"
 #include "ui_logsdialog.h"
 #include "helpers.h"
+#include <QProgressDialog>
 #if defined _MSC_VER || !defined __GNUC__
 #include <windows.h>
 #else
@@ -32,16 +33,21 @@
 LogsDialog::LogsDialog(QWidget *parent) :
   QDialog(parent, Qt::WindowTitleHint | Qt::WindowSystemMenuHint),
   ui(new Ui::LogsDialog),
+  plotLod(false),
+  plotFirstRow(0),
+  plotLastRow(-1),
+  cursorsCoords(-1),
   tracerMaxAlt(0),
   cursorA(0),
   cursorB(0),
   cursorLine(0)
 {
-  csvlog.clear();
-
   ui->setupUi(this);
   setWindowIcon(CompanionIcon("logs.png"));
 
+  logModel = new LogTableModel(this);
+  ui->logTable->setModel(logModel);
+
   plotLock=false;
 
   colors.append(Qt::green);
@@ -110,13 +116,15 @@ LogsDialog::LogsDialog(QWidget *parent) :
 
   // make left axes transfer its range to right axes:
   connect(axisRect->axis(QCPAxis::atLeft), SIGNAL(rangeChanged(QCPRange)), this, SLOT(yAxisChangeRanges(QCPRange)));
+  // the samples plotted depend on the time range
+  connect(axisRect->axis(QCPAxis::atBottom), SIGNAL(rangeChanged(QCPRange)), this, SLOT(xAxisChangeRange()));
 
   // connect some interaction slots:
   connect(ui->customPlot, SIGNAL(titleDoubleClick(QMouseEvent*, QCPPlotTitle*)), this, SLOT(titleDoubleClick(QMouseEvent*, QCPPlotTitle*)));
   connect(ui->customPlot, SIGNAL(axisDoubleClick(QCPAxis*,QCPAxis::SelectablePart,QMouseEvent*)), this, SLOT(axisLabelDoubleClick(QCPAxis*,QCPAxis::SelectablePart)));
   connect(ui->customPlot, SIGNAL(legendDoubleClick(QCPLegend*,QCPAbstractLegendItem*,QMouseEvent*)), this, SLOT(legendDoubleClick(QCPLegend*,QCPAbstractLegendItem*)));
   connect(ui->FieldsTW, SIGNAL(itemSelectionChanged()), this, SLOT(plotLogs()));
-  connect(ui->logTable, SIGNAL(itemSelectionChanged()), this, SLOT(plotLogs()));
+  connect(ui->logTable->selectionModel(), SIGNAL(selectionChanged(QItemSelection, QItemSelection)), this, SLOT(plotLogs()));
   connect(ui->Reset_PB, SIGNAL(clicked()), this, SLOT(plotLogs()));
   connect(ui->SaveSession_PB, SIGNAL(clicked()), this, SLOT(saveSession()));
 }
@@ -236,84 +244,76 @@ void LogsDialog::selectionChanged()
   }
 }
 
-QList<QStringList> LogsDialog::filterGePoints(const QList<QStringList> & input)
+QList<int> LogsDialog::filterGePoints()
 {
-  QList<QStringList> result;
-
-  int n = input.count();
-  if (n == 0) {
-    return result;
-  }
+  QList<int> result;
 
-  int gpscol = 0;
-  for (int i=1; i<input.at(0).count(); i++) {
-    if (input.at(0).at(i) == "GPS") {
-      gpscol=i;
-    }
-  }
-  if (gpscol == 0) {
+  int gpscol = logData.header().indexOf("GPS");
+  if (gpscol <= 0) {
     QMessageBox::critical(this, tr("Error: no GPS data found"),
       tr("The column containing GPS coordinates must be named \"GPS\".\n\n\
 The columns for altitude \"GAlt\" and for speed \"GSpd\" are optional"));
     return result;
   }
 
-  result.append(input.at(0));
-  bool rangeSelected = ui->logTable->selectionModel()->selectedRows().length() > 0;
+  QItemSelectionModel * selection = ui->logTable->selectionModel();
+  bool rangeSelected = selection->selectedRows().length() > 0;
 
   GpsGlitchFilter glitchFilter;
   GpsLatLonFilter latLonFilter;
 
-  for (int i = 1; i < n; i++) {
-    if ((ui->logTable->item(i-1, 1)->isSelected() && rangeSelected) || !rangeSelected) {
+  for (int row = 0; row < logData.rowCount(); row++) {
+    if ((selection->isRowSelected(row, QModelIndex()) && rangeSelected) || !rangeSelected) {
 
-      GpsCoord coord = extractGpsCoordinates(input.at(i).at(gpscol));
+      GpsCoord coord = extractGpsCoordinates(logData.text(row, gpscol));
 
       // glitch filter
       if ( glitchFilter.isGlitch(coord) ) {
-        // qDebug() << "filterGePoints(): GPS glitch detected at" << i << coord.latitude << coord.longitude;
+        // qDebug() << "filterGePoints(): GPS glitch detected at" << row << coord.latitude << coord.longitude;
         continue;
       }
 
       // lat long pair filter
       if ( !latLonFilter.isValid(coord) ) {
-        // qDebug() << "filterGePoints(): Lat-Lon pair wrong, skipping at" << i << coord.latitude << coord.longitude;
+        // qDebug() << "filterGePoints(): Lat-Lon pair wrong, skipping at" << row << coord.latitude << coord.longitude;
         continue;
       }
 
       // qDebug() << "point " << latitude << longitude;
-      result.append(input.at(i));
+      result.append(row);
     }
   }
 
-  // qDebug() << "filterGePoints(): filtered from" << input.count() << "to " << result.count() << "points";
+  // qDebug() << "filterGePoints(): filtered from" << logData.rowCount() << "to " << result.count() << "points";
   return result;
 }
 
 void LogsDialog::exportToGoogleEarth()
 {
   // filter data points
-  QList<QStringList> dataPoints = filterGePoints(csvlog);
+  QList<int> dataPoints = filterGePoints();
   int n = dataPoints.count(); // number of points to export
   if (n==0) return;
 
+  const QStringList & header = logData.header();
+
   int gpscol=0, altcol=0, speedcol=0;
   double altMultiplier = 1.0;
 
   QSet<int> nondataCols;
-  for (int i=1; i<dataPoints.at(0).count(); i++) {
+  for (int i=1; i<header.count(); i++) {
     // Long,Lat,Course,GPS Speed,GPS Alt
-    if (dataPoints.at(0).at(i) == "GPS") {
+    if (header.at(i) == "GPS") {
       gpscol=i;
     }
-    if (dataPoints.at(0).at(i).contains("GAlt")) {
+    if (header.at(i).contains("GAlt")) {
       altcol = i;
       nondataCols << i;
-      if (dataPoints.at(0).at(i).contains("(ft)")) {
+      if (header.at(i).contains("(ft)")) {
         altMultiplier = 0.3048;    // feet to meters
       }
     }
-    if (dataPoints.at(0).at(i).contains("GSpd")) {
+    if (header.at(i).contains("GSpd")) {
       speedcol = i;
       nondataCols << i;
     }
@@ -353,9 +353,9 @@ void LogsDialog::exportToGoogleEarth()
   outputStream << "\t\t\t<gx:SimpleArrayField name=\"GPSSpeed\" type=\"float\">\n\t\t\t\t<displayName>GPS Speed</displayName>\n\t\t\t</gx:SimpleArrayField>\n";
 
   // declare additional fields
-  for (int i=0; i<dataPoints.at(0).count()-2; i++) {
+  for (int i=0; i<header.count()-2; i++) {
     if (ui->FieldsTW->item(i, 0) && ui->FieldsTW->item(i, 0)->isSelected() && !nondataCols.contains(i+2)) {
-      QString origName = dataPoints.at(0).at(i+2);
+      QString origName = header.at(i+2);
       QString safeName = origName;
       safeName.replace(" ","_");
       outputStream << "\t\t\t<gx:SimpleArrayField name=\""<< safeName <<"\" ";
@@ -378,17 +378,17 @@ void LogsDialog::exportToGoogleEarth()
   outputStream << "\n\t\t\t\t\t<altitudeMode>absolute</altitudeMode>\n";
 
   // time data points
-  for (int i=1; i<n; i++) {
-    QString tstamp=dataPoints.at(i).at(0)+QString("T")+dataPoints.at(i).at(1)+QString("Z");
+  for (int i=0; i<n; i++) {
+    QString tstamp=logData.text(dataPoints.at(i), 0)+QString("T")+logData.text(dataPoints.at(i), 1)+QString("Z");
     outputStream << "\t\t\t\t\t<when>"<< tstamp <<"</when>\n";
   }
 
   // coordinate data points
   outputStream.setRealNumberNotation(QTextStream::FixedNotation);
   outputStream.setRealNumberPrecision(8);
-  for (int i=1; i<n; i++) {
-    GpsCoord coord = extractGpsCoordinates(dataPoints.at(i).at(gpscol));
-    int altitude = altcol ? (dataPoints.at(i).at(altcol).toFloat() * altMultiplier) : 0;
+  for (int i=0; i<n; i++) {
+    GpsCoord coord = extractGpsCoordinates(logData.text(dataPoints.at(i), gpscol));
+    int altitude = altcol ? (logData.text(dataPoints.at(i), altcol).toFloat() * altMultiplier) : 0;
     outputStream << "\t\t\t\t\t<gx:coord>" << coord.longitude << " " << coord.latitude << " " << altitude << " </gx:coord>\n" ;
   }
 
@@ -398,20 +398,20 @@ void LogsDialog::exportToGoogleEarth()
   if (speedcol) {
     // gps speed data points
     outputStream << "\t\t\t\t\t\t\t<gx:SimpleArrayData name=\"GPSSpeed\">\n";
-    for (int i=1; i<n; i++) {
-      outputStream << "\t\t\t\t\t\t\t\t<gx:value>"<< dataPoints.at(i).at(speedcol) <<"</gx:value>\n";
+    for (int i=0; i<n; i++) {
+      outputStream << "\t\t\t\t\t\t\t\t<gx:value>"<< logData.text(dataPoints.at(i), speedcol) <<"</gx:value>\n";
     }
     outputStream << "\t\t\t\t\t\t\t</gx:SimpleArrayData>\n";
   }
 
   // add values for additional fields
-  for (int i=0; i<dataPoints.at(0).count()-2; i++) {
+  for (int i=0; i<header.count()-2; i++) {
     if (ui->FieldsTW->item(i, 0) && ui->FieldsTW->item(i, 0)->isSelected() && !nondataCols.contains(i+2)) {
-      QString safeName = dataPoints.at(0).at(i+2);;
+      QString safeName = header.at(i+2);;
       safeName.replace(" ","_");
       outputStream << "\t\t\t\t\t\t\t<gx:SimpleArrayData name=\""<< safeName <<"\">\n";
-      for (int j=1; j<n; j++) {
-        outputStream << "\t\t\t\t\t\t\t\t<gx:value>"<< dataPoints.at(j).at(i+2) <<"</gx:value>\n";
+      for (int j=0; j<n; j++) {
+        outputStream << "\t\t\t\t\t\t\t\t<gx:value>"<< logData.text(dataPoints.at(j), i+2) <<"</gx:value>\n";
       }
       outputStream << "\t\t\t\t\t\t\t</gx:SimpleArrayData>\n";
     }
@@ -465,8 +465,9 @@ void LogsDialog::placeCursor(double x, bool second)
   QCPItemTracer * cursor = second ? cursorB : cursorA;
 
   if (cursor) {
-    cursor->setGraphKey(x);
-    cursor->updatePosition();
+    const coords_t & c = plots.coords.at(cursorsCoords);
+    int row = findPlotRow(x);
+    cursor->position->setCoords(logData.timestamp(row) / 1000.0, c.factor * (logData.column(c.column).at(row) - c.offset));
     cursor->setVisible(true);
   }
 
@@ -571,40 +572,29 @@ void LogsDialog::on_fileOpen_BT_clicked()
   if (!fileName.isEmpty()) {
     g.logDir(fileName);
     ui->FileName_LE->setText(fileName);
+    ui->FieldsTW->clear();
+    ui->FieldsTW->setRowCount(0);
+    logModel->setLog(nullptr);
     if (cvsFileParse()) {
-      ui->FieldsTW->clear();
-      ui->logTable->clear();
       ui->FieldsTW->setShowGrid(false);
       ui->FieldsTW->setContentsMargins(0,0,0,0);
-      ui->FieldsTW->setRowCount(csvlog.at(0).count()-2);
+      ui->FieldsTW->setRowCount(logData.columnCount()-2);
       ui->FieldsTW->setColumnCount(1);
       ui->FieldsTW->setHorizontalHeaderLabels(QStringList(tr("Available fields")));
       ui->logTable->setSelectionBehavior(QAbstractItemView::SelectRows);
-      for (int i=2; i<csvlog.at(0).count(); i++) {
-        QTableWidgetItem* item= new QTableWidgetItem(csvlog.at(0).at(i));
+      for (int i=2; i<logData.columnCount(); i++) {
+        QTableWidgetItem* item= new QTableWidgetItem(logData.header().at(i));
         ui->FieldsTW->setItem(i-2, 0, item);
       }
       ui->FieldsTW->resizeRowsToContents();
-      ui->logTable->setColumnCount(csvlog.at(0).count());
-      ui->logTable->setRowCount(csvlog.count()-1);
-      ui->logTable->setHorizontalHeaderLabels(csvlog.at(0));
-
-      QAbstractItemModel *model = ui->logTable->model();
-      for (int i=1; i<csvlog.count(); i++) {
-        for (int j=0; j<csvlog.at(0).count(); j++) {
-          model->setData(model->index(i - 1, j, QModelIndex()), csvlog.at(i).at(j));
-        }
-      }
 
-      ui->logTable->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
-      QVarLengthArray<int> sizes;
-      for (int i = 0; i < ui->logTable->columnCount(); i++) {
-        sizes.append(ui->logTable->columnWidth(i));
-      }
-      ui->logTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
-      for (int i = 0; i < ui->logTable->columnCount(); i++) {
-        ui->logTable->setColumnWidth(i, sizes.at(i));
-      }
+      // the cells are read from the log file when they are displayed
+      logModel->setLog(&logData);
+      ui->logTable->resizeColumnsToContents();
+
+      plotLock = true;
+      setFlightSessions();
+      plotLock = false;
     }
   }
 }
@@ -614,115 +604,55 @@ void LogsDialog::saveSession()
   int index = ui->sessions_CB->currentIndex();
   // ignore index 0 is its all sessions combined
   if(index > 0) {
-    int n = csvlog.count();
-    QList<QStringList> sessionCsvLog;
-    // add CSV headers from first row of source file
-    sessionCsvLog.push_back(csvlog[0]);
-    // find session breaks
-    int currentSession = 0;
-    QDateTime lastvalue;
-    for (int i = 1; i < n; i++) {
-      QDateTime tmp = getRecordTimeStamp(i);
-      if (!lastvalue.isValid() || lastvalue.secsTo(tmp) > 60) {
-        currentSession++;
-      }
-      lastvalue = tmp;
-      if(currentSession == index) {
-        // add records to filtered list
-        sessionCsvLog.push_back(csvlog[i]);
-      }
-      else if (currentSession > index) {
-        break;
-      }
-    }
-    // save the filtered records to a new file
+    const QVector<int> & sessions = logData.sessions();
+    int first = sessions.at(index-1);
+    int last = (index < sessions.size() ? sessions.at(index) : logData.rowCount());
+    // save the session records to a new file
     QString newFilename = logFilename;
     newFilename.append(QString("-Session%1.csv").arg(index));
     QString filename = QFileDialog::getSaveFileName(this, "Save log", newFilename, "CSV files (.csv);", 0, 0); // getting the filename (full path)
     QFile data(filename);
     if(data.open(QFile::WriteOnly |QFile::Truncate)) {
-      QTextStream output(&data);
-      int numRecords = sessionCsvLog.count();
-      for(int i = 0; i < numRecords; i++){
-        output << sessionCsvLog[i].join(",") << '\n';
+      // add CSV headers from first row of source file
+      data.write(logData.headerLine() + '\n');
+      for (int i = first; i < last; i++) {
+        data.write(logData.line(i) + '\n');
       }
     }
-    sessionCsvLog.clear();
   }
 }
 
 bool LogsDialog::cvsFileParse()
 {
-  QFile file(ui->FileName_LE->text());
-  int errors=0;
-  int lines=-1;
+  logFilename.clear();
+
+  QProgressDialog progress(tr("Loading %1...").arg(QFileInfo(ui->FileName_LE->text()).fileName()), tr("Cancel"), 0, 100, this);
+  progress.setWindowModality(Qt::WindowModal);
+  progress.setMinimumDuration(500);
 
-  if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) { // reading HEX TEXT file
+  bool result = logData.load(ui->FileName_LE->text(), [&progress](int percent) {
+    progress.setValue(percent);
+    return !progress.wasCanceled();
+  });
+  if (!result) {
     return false;
   }
-  else {
-    csvlog.clear();
-    logFilename.clear();
-    QTextStream inputStream(&file);
-    QString buffer = file.readLine();
-
-    if (buffer.startsWith("Date,Time")) {
-      file.reset();
-    }
-    else {
-      return false;
-    }
-
-    int numfields=-1;
-    while (!file.atEnd()) {
-      QString line = file.readLine().trimmed();
-      QStringList columns = line.split(',');
-      if (numfields==-1) {
-        numfields=columns.count();
-      }
-      if (columns.count()==numfields) {
-        csvlog.append(columns);
-      }
-      else {
-        errors++;
-      }
-      lines++;
-    }
 
-    logFilename = QFileInfo(file.fileName()).baseName();
-  }
+  logFilename = QFileInfo(ui->FileName_LE->text()).baseName();
 
-  file.close();
+  int errors = logData.invalidLines();
   if (errors > 1) {
-    QMessageBox::warning(this, CPN_STR_APP_NAME, tr("The selected logfile contains %1 invalid lines out of  %2 total lines").arg(errors).arg(lines));
+    QMessageBox::warning(this, CPN_STR_APP_NAME, tr("The selected logfile contains %1 invalid lines out of  %2 total lines").arg(errors).arg(errors + logData.rowCount()));
   }
 
-  int n = csvlog.count();
-  if (n == 1) {
-    csvlog.clear();
+  if (logData.rowCount() == 0) {
+    logData.clear();
     return false;
   }
 
-  plotLock = true;
-  setFlightSessions();
-  plotLock = false;
-
   return true;
 }
 
-struct FlightSession {
-  QDateTime start;
-  QDateTime end;
-};
-
-QDateTime LogsDialog::getRecordTimeStamp(int index)
-{
-  QString tstamp = csvlog.at(index).at(0) + " " + csvlog.at(index).at(1);
-  if (csvlog.at(index).at(1).contains("."))
-    return QDateTime::fromString(tstamp, "yyyy-MM-dd HH:mm:ss.zzz");
-  return QDateTime::fromString(tstamp, "yyyy-MM-dd HH:mm:ss");
-}
-
 QString LogsDialog::generateDuration(const QDateTime & start, const QDateTime & end)
 {
   int secs = start.secsTo(end);
@@ -740,38 +670,26 @@ void LogsDialog::setFlightSessions()
   ui->sessions_CB->clear();
   ui->SaveSession_PB->setEnabled(false);
 
-  int n = csvlog.count();
-  // qDebug() << "records" << n;
-
-  // find session breaks
-  QList<int> sessions;
-  QDateTime lastvalue;
-  for (int i = 1; i < n; i++) {
-    QDateTime tmp = getRecordTimeStamp(i);
-    if (!lastvalue.isValid() || lastvalue.secsTo(tmp) > 60) {
-      sessions.push_back(i-1);
-      // qDebug() << "session index" << i-1;
-    }
-    lastvalue = tmp;
-  }
-  sessions.push_back(n-1);
+  // the session breaks are found when the log is loaded
+  const QVector<int> & sessions = logData.sessions();
+  int n = logData.rowCount();
 
   //now construct a list of sessions with their times
   //total time
-  int noSesions = sessions.size()-1;
+  int noSesions = sessions.size();
   QString label = QString("%1 ").arg(noSesions);
   label += tr(noSesions > 1 ? "sessions" : "session");
-  label += " <" + tr("total duration ") + generateDuration(getRecordTimeStamp(1), getRecordTimeStamp(n-1)) + ">";
+  label += " <" + tr("total duration ") + generateDuration(logData.dateTime(0), logData.dateTime(n-1)) + ">";
   ui->sessions_CB->addItem(label);
 
   // add individual sessions
-  if (sessions.size() > 2) {
-    for (int i = 1; i < sessions.size(); i++) {
-      QDateTime sessionStart = getRecordTimeStamp(sessions.at(i-1)+1);
-      QDateTime sessionEnd = getRecordTimeStamp(sessions.at(i));
+  if (sessions.size() > 1) {
+    for (int i = 0; i < sessions.size(); i++) {
+      QDateTime sessionStart = logData.dateTime(sessions.at(i));
+      QDateTime sessionEnd = logData.dateTime(i < sessions.size() - 1 ? sessions.at(i+1) - 1 : n - 1);
       QString label = sessionStart.toString("HH:mm:ss") + " <" + tr("duration ") + generateDuration(sessionStart, sessionEnd) + ">";
-      ui->sessions_CB->addItem(label, sessions.at(i-1));
-      // qDebug() << "added label" << label << sessions.at(i-1);
+      ui->sessions_CB->addItem(label, sessions.at(i));
+      // qDebug() << "added label" << label << sessions.at(i);
     }
   }
 }
@@ -788,13 +706,13 @@ void LogsDialog::on_sessions_CB_currentIndexChanged(int index)
     if (index < ui->sessions_CB->count() - 1) {
       bottom = ui->sessions_CB->itemData(index + 1, Qt::UserRole).toInt();
     } else {
-      bottom = ui->logTable->rowCount();
+      bottom = logModel->rowCount();
     }
 
-    QModelIndex topLeft = ui->logTable->model()->index(
+    QModelIndex topLeft = logModel->index(
       ui->sessions_CB->itemData(index, Qt::UserRole).toInt(), 0 , QModelIndex());
-    QModelIndex bottomRight = ui->logTable->model()->index(
-      bottom - 1, ui->logTable->columnCount() - 1, QModelIndex());
+    QModelIndex bottomRight = logModel->index(
+      bottom - 1, logModel->columnCount() - 1, QModelIndex());
 
     QItemSelection selection(topLeft, bottomRight);
     ui->logTable->selectionModel()->select(selection, QItemSelectionModel::Select);
@@ -818,7 +736,7 @@ void LogsDialog::plotLogs()
     return;
   }
 
-  plotsCollection plots;
+  plots.coords.clear();
 
   QModelIndexList selection = ui->logTable->selectionModel()->selectedRows();
   int rowCount = selection.length();
@@ -833,7 +751,20 @@ void LogsDialog::plotLogs()
     std::sort(selectedRows.begin(), selectedRows.end());
   } else {
     hasLogSelection = false;
-    rowCount = ui->logTable->rowCount();
+    rowCount = logData.rowCount();
+  }
+
+  // a range of rows of a log in order is plotted through the level of
+  // detail pyramid, other selections sample by sample
+  plotFirstRow = hasLogSelection ? selectedRows.first() : 0;
+  plotLastRow = hasLogSelection ? selectedRows.last() : logData.rowCount() - 1;
+  plotLod = logData.isSorted() && plotLastRow - plotFirstRow + 1 == rowCount;
+  plotRows.clear();
+  if (!plotLod) {
+    plotRows.reserve(rowCount);
+    for (int row = 0; row < rowCount; row++) {
+      plotRows.append(hasLogSelection ? selectedRows.at(row) : row);
+    }
   }
 
   plots.min_x = QDateTime::currentDateTime().toTime_t();
@@ -843,42 +774,24 @@ void LogsDialog::plotLogs()
     coords_t plotCoords;
     int plotColumn = plot->row() + 2; // Date and Time first
 
+    plotCoords.column = plotColumn;
+    plotCoords.factor = 1;
+    plotCoords.offset = 0;
     plotCoords.min_y = INVALID_MIN;
     plotCoords.max_y = INVALID_MAX;
     plotCoords.yaxis = firstLeft;
     plotCoords.name = plot->text();
 
-    for (int row = 0; row < rowCount; row++) {
-      QTableWidgetItem *logValue;
-      double y;
-      double time;
-      QString time_str;
-
-      if (hasLogSelection) {
-        logValue = ui->logTable->item(selectedRows.at(row), plotColumn);
-        time_str = ui->logTable->item(selectedRows.at(row), 0)->text() +
-          QString(" ") + ui->logTable->item(selectedRows.at(row), 1)->text();
-      } else {
-        logValue = ui->logTable->item(row, plotColumn);
-        time_str = ui->logTable->item(row, 0)->text() + QString(" ") +
-          ui->logTable->item(row, 1)->text();
-      }
+    const QVector<double> & values = logData.column(plotColumn);
 
-      y = logValue->text().toDouble();
-      plotCoords.y.push_back(y);
+    for (int row = 0; row < rowCount; row++) {
+      int index = hasLogSelection ? selectedRows.at(row) : row;
+      double y = values.at(index);
 
       if (plotCoords.min_y > y) plotCoords.min_y = y;
       if (plotCoords.max_y < y) plotCoords.max_y = y;
 
-      if (time_str.contains('.')) {
-        time = QDateTime::fromString(time_str, "yyyy-MM-dd HH:mm:ss.zzz")
-          .toTime_t();
-        time += time_str.mid(time_str.indexOf('.')).toDouble();
-      } else {
-        time = QDateTime::fromString(time_str, "yyyy-MM-dd HH:mm:ss")
-          .toTime_t();
-      }
-      plotCoords.x.push_back(time);
+      double time = logData.timestamp(index) / 1000.0;
 
       if (plots.min_x > time) plots.min_x = time;
       if (plots.max_x < time) plots.max_x = time;
@@ -957,10 +870,8 @@ void LogsDialog::plotLogs()
     for (int i = 0; i < plots.coords.size(); i++) {
       plots.coords[i].yaxis = firstLeft;
 
-      double factor = 100 / (plots.coords.at(i).max_y - plots.coords.at(i).min_y);
-      for (int j = 0; j < plots.coords.at(i).y.count(); j++) {
-        plots.coords[i].y[j] = factor * (plots.coords.at(i).y.at(j) - plots.coords.at(i).min_y);
-      }
+      plots.coords[i].factor = 100 / (plots.coords.at(i).max_y - plots.coords.at(i).min_y);
+      plots.coords[i].offset = plots.coords.at(i).min_y;
     }
   } else {
     for (int i = firstRight; i < AXES_LIMIT; i++) {
@@ -1045,14 +956,13 @@ void LogsDialog::plotLogs()
         break;
     }
 
-    ui->customPlot->graph(i)->setData(plots.coords.at(i).x,
-      plots.coords.at(i).y);
     pen.setColor(colors.at(i % colors.size()));
     ui->customPlot->graph(i)->setPen(pen);
 
     if (!tracerMaxAlt && (plots.coords.at(i).name.endsWith("(m)") ||
         plots.coords.at(i).name.endsWith(" Alt") ||
         plots.coords.at(i).name.endsWith("(ft)"))) {
+      cursorsCoords = i;
       addMaxAltitudeMarker(plots.coords.at(i), ui->customPlot->graph(i));
       countNumberOfThrows(plots.coords.at(i), ui->customPlot->graph(i));
       addCursor(&cursorA, ui->customPlot->graph(i), Qt::blue);
@@ -1062,10 +972,80 @@ void LogsDialog::plotLogs()
     }
   }
 
+  setGraphsData();
+
   ui->customPlot->legend->setVisible(true);
   ui->customPlot->replot();
 }
 
+void LogsDialog::setGraphsData()
+{
+  int count = qMin(plots.coords.size(), ui->customPlot->graphCount());
+  QVector<int> rows;
+
+  for (int i = 0; i < count; i++) {
+    const coords_t & c = plots.coords.at(i);
+    const QVector<double> & values = logData.column(c.column);
+
+    if (plotLod) {
+      // the visible samples, and one more on each side for the lines to the borders
+      QCPRange range = axisRect->axis(QCPAxis::atBottom)->range();
+      double lower = qBound<double>(logData.timestamp(plotFirstRow), range.lower * 1000, logData.timestamp(plotLastRow));
+      double upper = qBound<double>(logData.timestamp(plotFirstRow), range.upper * 1000, logData.timestamp(plotLastRow));
+      int first = qMax(plotFirstRow, logData.findRow((qint64)lower) - 1);
+      int last = qMin(plotLastRow, logData.findRow((qint64)upper));
+      logData.samples(c.column, first, last, qMax(axisRect->width(), 100), rows);
+    }
+    else {
+      rows = plotRows;
+    }
+
+    QVector<double> x(rows.size());
+    QVector<double> y(rows.size());
+    for (int j = 0; j < rows.size(); j++) {
+      x[j] = logData.timestamp(rows.at(j)) / 1000.0;
+      y[j] = c.factor * (values.at(rows.at(j)) - c.offset);
+    }
+    ui->customPlot->graph(i)->setData(x, y);
+  }
+}
+
+void LogsDialog::xAxisChangeRange()
+{
+  if (plotLod) {
+    setGraphsData();
+  }
+}
+
+int LogsDialog::plotRow(int index) const
+{
+  return plotLod ? plotFirstRow + index : plotRows.at(index);
+}
+
+int LogsDialog::plotRowsCount() const
+{
+  return plotLod ? plotLastRow - plotFirstRow + 1 : plotRows.size();
+}
+
+int LogsDialog::findPlotRow(double x) const
+{
+  qint64 timestamp = x * 1000;
+
+  if (plotLod) {
+    int row = qBound(plotFirstRow, logData.findRow(timestamp), plotLastRow);
+    if (row > plotFirstRow && timestamp - logData.timestamp(row - 1) < logData.timestamp(row) - timestamp)
+      row--;
+    return row;
+  }
+
+  int result = plotRows.first();
+  for (int index = 1; index < plotRows.size(); index++) {
+    if (qAbs(logData.timestamp(plotRows.at(index)) - timestamp) < qAbs(logData.timestamp(result) - timestamp))
+      result = plotRows.at(index);
+  }
+  return result;
+}
+
 void LogsDialog::yAxisChangeRanges(QCPRange range)
 {
   if (axisRect->axis(QCPAxis::atRight)->visible()) {
@@ -1111,30 +1091,30 @@ void LogsDialog::yAxisChangeRanges(QCPRange range)
 
 void LogsDialog::addMaxAltitudeMarker(const coords_t & c, QCPGraph * graph) {
   // find max altitude
-  int positionIndex = 0;
+  int positionRow = plotRow(0);
   double maxAlt = -100000;
 
-  for(int i=0; i<c.x.count(); ++i) {
-    double alt = c.y.at(i);
+  // on the log samples, the graph may only have a part of them
+  const QVector<double> & values = logData.column(c.column);
+  for(int i=0; i<plotRowsCount(); ++i) {
+    double alt = c.factor * (values.at(plotRow(i)) - c.offset);
     if (alt > maxAlt) {
       maxAlt = alt;
-      positionIndex = i;
+      positionRow = plotRow(i);
       // qDebug() << "max alt: " << maxAlt << "@" << result;
     }
   }
-  // qDebug() << "max alt: " << maxAlt << "@" << positionIndex;
+  // qDebug() << "max alt: " << maxAlt << "@" << positionRow;
 
   // add max altitude marker
   tracerMaxAlt = new QCPItemTracer(ui->customPlot);
   ui->customPlot->addItem(tracerMaxAlt);
-  tracerMaxAlt->setGraph(graph);
-  tracerMaxAlt->setInterpolating(true);
+  tracerMaxAlt->position->setAxes(graph->keyAxis(), graph->valueAxis());
   tracerMaxAlt->setStyle(QCPItemTracer::tsSquare);
   tracerMaxAlt->setPen(QPen(Qt::blue));
   tracerMaxAlt->setBrush(Qt::NoBrush);
   tracerMaxAlt->setSize(7);
-  tracerMaxAlt->setGraphKey(c.x.at(positionIndex));
-  tracerMaxAlt->updatePosition();
+  tracerMaxAlt->position->setCoords(logData.timestamp(positionRow) / 1000.0, maxAlt);
 }
 
 void LogsDialog::countNumberOfThrows(const coords_t & c, QCPGraph * graph)
@@ -1154,8 +1134,8 @@ void LogsDialog::countNumberOfThrows(const coords_t & c, QCPGraph * graph)
 void LogsDialog::addCursor(QCPItemTracer ** cursor, QCPGraph * graph, const QColor & color) {
   QCPItemTracer * c = new QCPItemTracer(ui->customPlot);
   ui->customPlot->addItem(c);
-  c->setGraph(graph);
-  c->setInterpolating(false);
+  // placed on the log samples by placeCursor(), not on the graph points
+  c->position->setAxes(graph->keyAxis(), graph->valueAxis());
   c->setStyle(QCPItemTracer::tsCrosshair);
   QPen pen(color);
   pen.setStyle(Qt::DashLine);
@@ -24,6 +24,7 @@
 #include <QtCore>
 #include <QDialog>
 #include "qcustomplot.h"
+#include "logdata.h"
 
 #define INVALID_MIN 999999
 #define INVALID_MAX -999999
@@ -45,7 +46,8 @@ class LogsDialog : public QDialog
   };
 
   struct coords_t {
-    QVector<double> x, y;
+    int column;
+    double factor, offset; // y = factor * (value - offset)
     double min_y;
     double max_y;
     yaxes_t yaxis;
@@ -82,13 +84,21 @@ private slots:
   void on_sessions_CB_currentIndexChanged(int index);
   void on_mapsButton_clicked();
   void yAxisChangeRanges(QCPRange range);
+  void xAxisChangeRange();
 
 private:
-  QList<QStringList> csvlog;
+  LogData logData;
+  LogTableModel * logModel;
   Ui::LogsDialog *ui;
   QCPAxisRect *axisRect;
   QCPLegend *rightLegend;
   bool plotLock;
+  plotsCollection plots;
+  bool plotLod;
+  int plotFirstRow;
+  int plotLastRow;
+  QVector<int> plotRows;
+  int cursorsCoords;
   QString logFilename;
 
   QVarLengthArray<Qt::GlobalColor> colors;
@@ -103,9 +113,8 @@ private:
   QCPItemStraightLine * cursorLine;
 
   bool cvsFileParse();
-  QList<QStringList> filterGePoints(const QList<QStringList> & input);
+  QList<int> filterGePoints();
   void exportToGoogleEarth();
-  QDateTime getRecordTimeStamp(int index);
   QString generateDuration(const QDateTime & start, const QDateTime & end);
   void setFlightSessions();
 
@@ -114,6 +123,10 @@ private:
   void addCursor(QCPItemTracer ** cursor, QCPGraph * graph, const QColor & color);
   void addCursorLine(QCPItemStraightLine ** line, QCPGraph * graph, const QColor & color);
   void placeCursor(double x, bool second);
+  void setGraphsData();
+  int plotRow(int index) const;
+  int plotRowsCount() const;
+  int findPlotRow(double x) const;
   QString formatTimeDelta(double timeDelta);
   void updateCursorsLabel();
 
@@ -207,6 +207,7 @@ void MdiChild::setupNavigation()
   addAct(ACT_GEN_CPY, "copy.png",     SLOT(copyGeneralSettings()),  tr("Ctrl+Alt+C"));
   addAct(ACT_GEN_PST, "paste.png",    SLOT(pasteGeneralSettings()), tr("Ctrl+Alt+V"));
   addAct(ACT_GEN_SIM, "simulate.png", SLOT(radioSimulate()),        tr("Alt+Shift+S"));
+  addAct(ACT_GEN_PRT, "print.png",    SLOT(printAll()),             tr("Alt+Shift+P"));
 
   addAct(ACT_ITM_EDT, "edit.png",  SLOT(edit()),          Qt::Key_Enter);
   addAct(ACT_ITM_DEL, "clear.png", SLOT(confirmDelete()), QKeySequence::Delete);
@@ -378,6 +379,7 @@ void MdiChild::retranslateUi()
   action[ACT_GEN_CPY]->setText(tr("Copy Radio Settings"));
   action[ACT_GEN_PST]->setText(tr("Paste Radio Settings"));
   action[ACT_GEN_SIM]->setText(tr("Simulate Radio"));
+  action[ACT_GEN_PRT]->setText(tr("Print All Models to File"));
 
   action[ACT_CAT_ADD]->setText(tr("Add Category"));
   action[ACT_CAT_ADD]->setIconText(tr("Category"));
@@ -406,6 +408,7 @@ QList<QAction *> MdiChild::getGeneralActions()
   actGrp.append(getAction(ACT_GEN_EDT));
   actGrp.append(getAction(ACT_GEN_CPY));
   actGrp.append(getAction(ACT_GEN_PST));
+  actGrp.append(getAction(ACT_GEN_PRT));
   return actGrp;
 }
 
@@ -1294,6 +1297,44 @@ void MdiChild::print(int model, const QString & filename)
   }
 }
 
+void MdiChild::printAll()
+{
+  QString filename = QFileDialog::getSaveFileName(this, tr("Select HTML output file"), QString(), tr("HTML files (*.htm *.html)"));
+  if (filename.isEmpty())
+    return;
+  if (!(filename.endsWith(".htm", Qt::CaseInsensitive) || filename.endsWith(".html", Qt::CaseInsensitive)))
+    filename += ".html";
+
+  QVector<const ModelData *> models;
+  for (unsigned i=0; i<radioData.models.size(); i++) {
+    if (!radioData.models[i].isEmpty())
+      models << &radioData.models[i];
+  }
+
+  // the models are printed in background, the progress dialog doesn't block the other windows
+  BatchModelPrinter * printer = new BatchModelPrinter(firmware, this);
+  QProgressDialog * progress = new QProgressDialog(tr("Printing models to %1...").arg(QFileInfo(filename).fileName()), tr("Cancel"), 0, models.size(), this);
+  progress->setWindowModality(Qt::WindowModal);
+  progress->setAutoReset(false);
+  progress->setMinimumDuration(500);
+  connect(printer, &BatchModelPrinter::progress, progress, &QProgressDialog::setValue);
+  connect(progress, &QProgressDialog::canceled, printer, &BatchModelPrinter::cancel);
+  connect(printer, &BatchModelPrinter::finished, [this, printer, progress, filename](bool success) {
+    if (success)
+      emit newStatusMessage(tr("Models printed to %1").arg(filename), 5000);
+    else if (!printer->errorString().isEmpty())
+      QMessageBox::critical(this, CPN_STR_TTL_ERROR, printer->errorString());
+    progress->deleteLater();
+    printer->deleteLater();
+  });
+
+  if (!printer->start(models, radioData.generalSettings, filename)) {
+    QMessageBox::critical(this, CPN_STR_TTL_ERROR, printer->errorString());
+    delete progress;
+    delete printer;
+  }
+}
+
 void MdiChild::setDefault()
 {
   int row = getCurrentModel();
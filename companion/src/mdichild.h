@@ -46,6 +46,7 @@ class MdiChild : public QWidget
       ACT_GEN_CPY,
       ACT_GEN_PST,
       ACT_GEN_SIM,
+      ACT_GEN_PRT,  // print all models to a file
       ACT_ITM_EDT,  // edit model/rename category
       ACT_ITM_DEL,  // delete model or cat
       ACT_CAT_ADD,  // category actions...
@@ -89,6 +90,7 @@ class MdiChild : public QWidget
     void closeFile(bool force = false);
     void writeEeprom();
     void print(int model=-1, const QString & filename="");
+    void printAll();
     void onFirmwareChanged();
 
   signals:
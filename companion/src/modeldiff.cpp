@@ -0,0 +1,536 @@
+/*
+ * Copyright (C) OpenTX
+ *
+ * Based on code named
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "modeldiff.h"
+#include "constants.h"
+#include "helpers.h"
+
+#include <QHash>
+
+// indices of the elements of a sequence which are part of a longest
+// increasing subsequence (patience sorting, n log n)
+static QVector<bool> longestIncreasingSubsequence(const QVector<int> & sequence)
+{
+  int count = sequence.size();
+  QVector<int> tails;         // index of the last element of the subsequences of each length
+  QVector<int> previous(count, -1);
+  QVector<bool> result(count, false);
+
+  for (int i=0; i<count; i++) {
+    int low = 0, high = tails.size();
+    while (low < high) {
+      int middle = (low + high) / 2;
+      if (sequence[tails[middle]] < sequence[i])
+        low = middle + 1;
+      else
+        high = middle;
+    }
+    if (low > 0)
+      previous[i] = tails[low - 1];
+    if (low == tails.size())
+      tails.append(i);
+    else
+      tails[low] = i;
+  }
+
+  for (int i = (tails.isEmpty() ? -1 : tails.last()); i >= 0; i = previous[i]) {
+    result[i] = true;
+  }
+
+  return result;
+}
+
+static void logicalSwitchValues(const LogicalSwitchData & ls, const ModelData & model, const GeneralSettings & settings, QString & v1, QString & v2, QString & v3)
+{
+  Board::Type board = getCurrentBoard();
+
+  switch (ls.getFunctionFamily()) {
+    case LS_FAMILY_EDGE:
+      v1 = RawSwitch(ls.val1).toString(board, &settings, &model);
+      v2 = QString::number(ValToTim(ls.val2));
+      v3 = (ls.val3 < 0 ? ModelDiff::tr("instant") : QString::number(ValToTim(ls.val2 + ls.val3)));
+      break;
+    case LS_FAMILY_STICKY:
+    case LS_FAMILY_VBOOL:
+      v1 = RawSwitch(ls.val1).toString(board, &settings, &model);
+      v2 = RawSwitch(ls.val2).toString(board, &settings, &model);
+      break;
+    case LS_FAMILY_TIMER:
+      v1 = QString::number(ValToTim(ls.val1));
+      v2 = QString::number(ValToTim(ls.val2));
+      break;
+    case LS_FAMILY_VOFS: {
+      RawSource source = RawSource(ls.val1);
+      RawSourceRange range = source.getRange(&model, settings);
+      v1 = (ls.val1 ? source.toString(&model, &settings) : "0");
+      v2 = QString::number(range.step * ls.val2 + range.offset);
+      break;
+    }
+    case LS_FAMILY_VCOMP:
+      v1 = (ls.val1 ? RawSource(ls.val1).toString(&model, &settings) : "0");
+      v2 = (ls.val2 ? RawSource(ls.val2).toString(&model, &settings) : "0");
+      break;
+    default:
+      break;
+  }
+}
+
+ModelDiff::ModelDiff(const ModelData & model1, const GeneralSettings & settings1, const ModelData & model2, const GeneralSettings & settings2)
+{
+  typedef void (*ItemsFunction)(const ModelData &, const GeneralSettings &, ItemList &);
+  const struct {
+    QString section;
+    ItemsFunction items;
+  } sections[] = {
+    { tr("Model"), &ModelDiff::modelItems },
+    { tr("Timers"), &ModelDiff::timerItems },
+    { tr("Flight modes"), &ModelDiff::flightModeItems },
+    { tr("Inputs"), &ModelDiff::inputItems },
+    { tr("Mixes"), &ModelDiff::mixItems },
+    { tr("Outputs"), &ModelDiff::outputItems },
+    { tr("Curves"), &ModelDiff::curveItems },
+    { tr("Logical switches"), &ModelDiff::logicalSwitchItems },
+    { tr("Special functions"), &ModelDiff::customFunctionItems },
+  };
+
+  for (unsigned i=0; i<DIM(sections); i++) {
+    ItemList items1, items2;
+    sections[i].items(model1, settings1, items1);
+    sections[i].items(model2, settings2, items2);
+    compare(sections[i].section, items1, items2);
+  }
+}
+
+QString ModelDiff::changeTypeToString(ChangeType type)
+{
+  switch (type) {
+    case ITEM_ADDED:
+      return tr("added");
+    case ITEM_REMOVED:
+      return tr("removed");
+    case ITEM_CHANGED:
+      return tr("changed");
+    case ITEM_MOVED:
+      return tr("moved");
+    default:
+      return CPN_STR_UNKNOWN_ITEM;
+  }
+}
+
+// the items are matched by key in one pass, the items with the same key are
+// matched in order. Among the matched items those out of the longest run
+// kept in the same order are reported as moved, the changes are reported in
+// the order of the second model, the removed items after their predecessor
+void ModelDiff::compare(const QString & section, const ItemList & items1, const ItemList & items2)
+{
+  int count1 = items1.size();
+  int count2 = items2.size();
+
+  QHash<qint64, QVector<int>> positions;
+  positions.reserve(count2);
+  for (int j=0; j<count2; j++) {
+    positions[items2[j].key].append(j);
+  }
+
+  QHash<qint64, int> used;
+  QVector<int> match1(count1, -1);
+  QVector<int> match2(count2, -1);
+  QVector<int> sequence;
+  for (int i=0; i<count1; i++) {
+    QHash<qint64, QVector<int>>::const_iterator it = positions.constFind(items1[i].key);
+    if (it != positions.constEnd()) {
+      int & next = used[items1[i].key];
+      if (next < it->size()) {
+        int j = it->at(next++);
+        match1[i] = j;
+        match2[j] = i;
+        sequence.append(j);
+      }
+    }
+  }
+
+  QVector<bool> kept = longestIncreasingSubsequence(sequence);
+  QVector<bool> moved(count2, false);
+  for (int k=0; k<sequence.size(); k++) {
+    moved[sequence[k]] = !kept[k];
+  }
+
+  auto addRemoved = [&](int i) {
+    Change change;
+    change.type = ITEM_REMOVED;
+    change.section = section;
+    change.item = items1[i].label;
+    change.before = summary(items1[i].fields);
+    m_changes.append(change);
+  };
+
+  int next1 = 0;
+  for (int j=0; j<count2; j++) {
+    Change change;
+    change.section = section;
+    change.item = items2[j].label;
+    int i = match2[j];
+    if (i < 0) {
+      change.type = ITEM_ADDED;
+      change.after = summary(items2[j].fields);
+      m_changes.append(change);
+      continue;
+    }
+    if (!moved[j]) {
+      for (; next1 < i; next1++) {
+        if (match1[next1] < 0)
+          addRemoved(next1);
+      }
+      next1 = i + 1;
+    }
+    change.type = (moved[j] ? ITEM_MOVED : ITEM_CHANGED);
+    compareFields(change, items1[i].fields, items2[j].fields);
+    if (change.type == ITEM_MOVED || !change.fields.isEmpty())
+      m_changes.append(change);
+  }
+
+  for (; next1 < count1; next1++) {
+    if (match1[next1] < 0)
+      addRemoved(next1);
+  }
+}
+
+// the fields of the items of a section are always listed in the same order
+void ModelDiff::compareFields(Change & change, const ItemFields & fields1, const ItemFields & fields2)
+{
+  int count = qMin(fields1.size(), fields2.size());
+  for (int i=0; i<count; i++) {
+    if (fields1[i].second != fields2[i].second) {
+      Field field;
+      field.name = fields2[i].first;
+      field.before = fields1[i].second;
+      field.after = fields2[i].second;
+      change.fields.append(field);
+    }
+  }
+}
+
+QString ModelDiff::summary(const ItemFields & fields)
+{
+  QStringList result;
+  foreach (const ItemFields::value_type & field, fields) {
+    if (!field.second.isEmpty())
+      result << QString("%1: %2").arg(field.first, field.second);
+  }
+  return result.join(", ");
+}
+
+QString ModelDiff::boolToString(bool value)
+{
+  return value ? tr("Yes") : tr("No");
+}
+
+QString ModelDiff::flightModesToString(const ModelData & model, unsigned int flightModes)
+{
+  int numFlightModes = getCurrentFirmware()->getCapability(FlightModes);
+  if (!numFlightModes || !flightModes)
+    return "";
+  if (flightModes == (unsigned int)(1<<numFlightModes) - 1)
+    return tr("None");
+  QStringList list;
+  for (int i=0; i<numFlightModes; i++) {
+    if (!(flightModes & (1<<i)))
+      list << model.flightModeData[i].nameToString(i);
+  }
+  return list.join(" ");
+}
+
+QString ModelDiff::trimToString(const ModelData & model, const GeneralSettings & settings, int carryTrim)
+{
+  if (carryTrim > 0)
+    return tr("No trim");
+  else if (carryTrim < 0)
+    return RawSource(SOURCE_TYPE_TRIM, -carryTrim - 1).toString(&model, &settings);
+  else
+    return "";
+}
+
+void ModelDiff::modelItems(const ModelData & model, const GeneralSettings & settings, ItemList & items)
+{
+  Item item;
+  item.key = 0;
+  item.label = tr("Setup");
+  item.fields << qMakePair(tr("Name"), QString(model.name));
+  item.fields << qMakePair(tr("Throttle trim"), boolToString(model.thrTrim));
+  item.fields << qMakePair(tr("Trim increment"), QString::number(model.trimInc));
+  item.fields << qMakePair(tr("Extended limits"), boolToString(model.extendedLimits));
+  item.fields << qMakePair(tr("Extended trims"), boolToString(model.extendedTrims));
+  item.fields << qMakePair(tr("Throttle warning"), boolToString(!model.disableThrottleWarning));
+  item.fields << qMakePair(tr("Global functions"), boolToString(!model.noGlobalFunctions));
+  items.append(item);
+}
+
+void ModelDiff::timerItems(const ModelData & model, const GeneralSettings & settings, ItemList & items)
+{
+  int count = getCurrentFirmware()->getCapability(Timers);
+  for (int i=0; i<count && i<CPN_MAX_TIMERS; i++) {
+    const TimerData & timer = model.timers[i];
+    Item item;
+    item.key = i;
+    item.label = tr("Timer %1").arg(i+1);
+    item.fields << qMakePair(tr("Name"), QString(timer.name));
+    item.fields << qMakePair(tr("Mode"), timer.mode.toString(getCurrentBoard(), &settings, &model));
+    item.fields << qMakePair(tr("Start"), QString("%1:%2").arg(timer.val / 60, 2, 10, QChar('0')).arg(timer.val % 60, 2, 10, QChar('0')));
+    item.fields << qMakePair(tr("Countdown"), QString::number(timer.countdownBeep));
+    item.fields << qMakePair(tr("Minute call"), boolToString(timer.minuteBeep));
+    item.fields << qMakePair(tr("Persistent"), QString::number(timer.persistent));
+    items.append(item);
+  }
+}
+
+void ModelDiff::flightModeItems(const ModelData & model, const GeneralSettings & settings, ItemList & items)
+{
+  int count = getCurrentFirmware()->getCapability(FlightModes);
+  int trims = getBoardCapability(getCurrentBoard(), Board::NumTrims);
+  int scale = getCurrentFirmware()->getCapability(SlowScale);
+  if (scale == 0)
+    scale = 1;
+
+  for (int i=0; i<count && i<CPN_MAX_FLIGHT_MODES; i++) {
+    const FlightModeData & fm = model.flightModeData[i];
+    Item item;
+    item.key = i;
+    item.label = tr("FM%1").arg(i);
+    item.fields << qMakePair(tr("Name"), QString(fm.name));
+    item.fields << qMakePair(tr("Switch"), (i ? fm.swtch.toString(getCurrentBoard(), &settings, &model) : QString()));
+    item.fields << qMakePair(tr("Fade in"), QString::number((double)fm.fadeIn / scale));
+    item.fields << qMakePair(tr("Fade out"), QString::number((double)fm.fadeOut / scale));
+    for (int t=0; t<trims && t<CPN_MAX_TRIMS; t++) {
+      QString trim;
+      if (fm.trimMode[t] == -1)
+        trim = tr("Off");
+      else if (fm.trimRef[t] == i)
+        trim = QString::number(fm.trim[t]);
+      else if (fm.trimMode[t] == 0)
+        trim = tr("FM%1").arg(fm.trimRef[t]);
+      else
+        trim = tr("FM%1%2").arg(fm.trimRef[t]).arg(fm.trim[t] < 0 ? QString::number(fm.trim[t]) : "+" + QString::number(fm.trim[t]));
+      item.fields << qMakePair(RawSource(SOURCE_TYPE_TRIM, t).toString(&model, &settings), trim);
+    }
+    items.append(item);
+  }
+}
+
+void ModelDiff::inputItems(const ModelData & model, const GeneralSettings & settings, ItemList & items)
+{
+  bool virtualInputs = getCurrentFirmware()->getCapability(VirtualInputs);
+  RawSourceType inputType = (virtualInputs ? SOURCE_TYPE_VIRTUAL_INPUT : SOURCE_TYPE_STICK);
+
+  for (int i=0; i<CPN_MAX_EXPOS; i++) {
+    const ExpoData & input = model.expoData[i];
+    if (input.mode == 0)
+      continue;
+    Item item;
+    item.key = ((qint64)input.chn << 32) | (quint32)input.srcRaw.toValue();
+    item.label = RawSource(inputType, input.chn).toString(&model, &settings);
+    if (virtualInputs)
+      item.label += " " + input.srcRaw.toString(&model, &settings);
+    item.fields << qMakePair(tr("Weight"), Helpers::getAdjustmentString(input.weight, &model, true));
+    item.fields << qMakePair(tr("Offset"), (input.offset ? Helpers::getAdjustmentString(input.offset, &model) : QString()));
+    item.fields << qMakePair(tr("Curve"), (input.curve.value ? input.curve.toString(&model) : QString()));
+    item.fields << qMakePair(tr("Switch"), (input.swtch.type != SWITCH_TYPE_NONE ? input.swtch.toString(getCurrentBoard(), &settings, &model) : QString()));
+    item.fields << qMakePair(tr("Side"), QString(input.mode == 1 ? "x<0" : (input.mode == 2 ? "x>0" : "")));
+    item.fields << qMakePair(tr("Trim"), (virtualInputs ? trimToString(model, settings, input.carryTrim) : QString()));
+    item.fields << qMakePair(tr("Flight modes"), flightModesToString(model, input.flightModes));
+    item.fields << qMakePair(tr("Name"), QString(input.name));
+    items.append(item);
+  }
+}
+
+void ModelDiff::mixItems(const ModelData & model, const GeneralSettings & settings, ItemList & items)
+{
+  int scale = getCurrentFirmware()->getCapability(SlowScale);
+  if (scale == 0)
+    scale = 1;
+
+  for (int i=0; i<CPN_MAX_MIXERS; i++) {
+    const MixData & mix = model.mixData[i];
+    if (mix.destCh == 0)
+      continue;
+    QString multiplex;
+    if (mix.mltpx == MLTPX_MUL)
+      multiplex = tr("Multiply");
+    else if (mix.mltpx == MLTPX_REP)
+      multiplex = tr("Replace");
+    Item item;
+    item.key = ((qint64)mix.destCh << 32) | (quint32)mix.srcRaw.toValue();
+    item.label = tr("CH%1").arg(mix.destCh) + " " + mix.srcRaw.toString(&model, &settings);
+    item.fields << qMakePair(tr("Weight"), Helpers::getAdjustmentString(mix.weight, &model, true));
+    item.fields << qMakePair(tr("Offset"), (mix.sOffset ? Helpers::getAdjustmentString(mix.sOffset, &model) : QString()));
+    item.fields << qMakePair(tr("Curve"), (mix.curve.value ? mix.curve.toString(&model) : QString()));
+    item.fields << qMakePair(tr("Switch"), (mix.swtch.type != SWITCH_TYPE_NONE ? mix.swtch.toString(getCurrentBoard(), &settings, &model) : QString()));
+    item.fields << qMakePair(tr("Multiplex"), multiplex);
+    item.fields << qMakePair(tr("Trim"), trimToString(model, settings, mix.carryTrim));
+    item.fields << qMakePair(tr("Flight modes"), flightModesToString(model, mix.flightModes));
+    item.fields << qMakePair(tr("Delay"), (mix.delayUp || mix.delayDown ? QString("u%1:d%2").arg((double)mix.delayUp / scale).arg((double)mix.delayDown / scale) : QString()));
+    item.fields << qMakePair(tr("Slow"), (mix.speedUp || mix.speedDown ? QString("u%1:d%2").arg((double)mix.speedUp / scale).arg((double)mix.speedDown / scale) : QString()));
+    item.fields << qMakePair(tr("Warning"), (mix.mixWarn ? QString::number(mix.mixWarn) : QString()));
+    item.fields << qMakePair(tr("No DR/Expo"), (mix.noExpo ? tr("Yes") : QString()));
+    item.fields << qMakePair(tr("Name"), QString(mix.name));
+    items.append(item);
+  }
+}
+
+void ModelDiff::outputItems(const ModelData & model, const GeneralSettings & settings, ItemList & items)
+{
+  Firmware * firmware = getCurrentFirmware();
+  int count = firmware->getCapability(Outputs);
+  for (int i=0; i<count && i<CPN_MAX_CHNOUT; i++) {
+    const LimitData & output = model.limitData[i];
+    Item item;
+    item.key = i;
+    item.label = tr("CH%1").arg(i+1);
+    item.fields << qMakePair(tr("Name"), QString(output.name));
+    item.fields << qMakePair(tr("Subtrim"), output.offsetToString());
+    item.fields << qMakePair(tr("Min"), output.minToString());
+    item.fields << qMakePair(tr("Max"), output.maxToString());
+    item.fields << qMakePair(tr("Direction"), output.revertToString());
+    item.fields << qMakePair(tr("Curve"), (output.curve.value ? output.curve.toString(&model) : QString()));
+    item.fields << qMakePair(tr("PPM center"), (firmware->getCapability(PPMCenter) ? QString::number(1500 + output.ppmCenter) : QString()));
+    item.fields << qMakePair(tr("Symmetrical"), boolToString(output.symetrical));
+    items.append(item);
+  }
+}
+
+void ModelDiff::curveItems(const ModelData & model, const GeneralSettings & settings, ItemList & items)
+{
+  int count = getCurrentFirmware()->getCapability(NumCurves);
+  for (int i=0; i<count && i<CPN_MAX_CURVES; i++) {
+    const CurveData & curve = model.curves[i];
+    if (curve.isEmpty() && !curve.name[0])
+      continue;
+    QStringList points;
+    for (int p=0; p<curve.count && p<CPN_MAX_POINTS; p++) {
+      if (curve.type == CurveData::CURVE_TYPE_CUSTOM)
+        points << QString("(%1,%2)").arg((int)curve.points[p].x).arg((int)curve.points[p].y);
+      else
+        points << QString::number(curve.points[p].y);
+    }
+    Item item;
+    item.key = i;
+    item.label = tr("CV%1").arg(i+1);
+    item.fields << qMakePair(tr("Name"), QString(curve.name));
+    item.fields << qMakePair(tr("Type"), (curve.type == CurveData::CURVE_TYPE_CUSTOM ? tr("Custom") : tr("Standard")));
+    item.fields << qMakePair(tr("Smooth"), boolToString(curve.smooth));
+    item.fields << qMakePair(tr("Points"), points.join(" "));
+    items.append(item);
+  }
+}
+
+void ModelDiff::logicalSwitchItems(const ModelData & model, const GeneralSettings & settings, ItemList & items)
+{
+  Firmware * firmware = getCurrentFirmware();
+  int count = firmware->getCapability(LogicalSwitches);
+  for (int i=0; i<count && i<CPN_MAX_LOGICAL_SWITCHES; i++) {
+    const LogicalSwitchData & ls = model.logicalSw[i];
+    if (ls.isEmpty())
+      continue;
+    QString v1, v2, v3;
+    logicalSwitchValues(ls, model, settings, v1, v2, v3);
+    Item item;
+    item.key = i;
+    item.label = ls.nameToString(i);
+    item.fields << qMakePair(tr("Function"), ls.funcToString());
+    item.fields << qMakePair(tr("V1"), v1);
+    item.fields << qMakePair(tr("V2"), v2);
+    item.fields << qMakePair(tr("V3"), v3);
+    item.fields << qMakePair(tr("AND switch"), (ls.andsw ? RawSwitch(ls.andsw).toString(getCurrentBoard(), &settings, &model) : QString()));
+    if (firmware->getCapability(LogicalSwitchesExt)) {
+      item.fields << qMakePair(tr("Duration"), (ls.duration ? QString("%1s").arg(ls.duration / 10.0) : QString()));
+      item.fields << qMakePair(tr("Delay"), (ls.delay ? QString("%1s").arg(ls.delay / 10.0) : QString()));
+    }
+    items.append(item);
+  }
+}
+
+void ModelDiff::customFunctionItems(const ModelData & model, const GeneralSettings & settings, ItemList & items)
+{
+  int count = getCurrentFirmware()->getCapability(CustomFunctions);
+  for (int i=0; i<count && i<CPN_MAX_SPECIAL_FUNCTIONS; i++) {
+    const CustomFunctionData & cf = model.customFn[i];
+    if (cf.isEmpty())
+      continue;
+    Item item;
+    item.key = i;
+    item.label = cf.nameToString(i);
+    item.fields << qMakePair(tr("Switch"), cf.swtch.toString(getCurrentBoard(), &settings, &model));
+    item.fields << qMakePair(tr("Function"), cf.funcToString(&model));
+    item.fields << qMakePair(tr("Parameter"), cf.paramToString(&model));
+    item.fields << qMakePair(tr("Repeat"), cf.repeatToString());
+    item.fields << qMakePair(tr("Enabled"), cf.enabledToString());
+    items.append(item);
+  }
+}
+
+QString ModelDiff::toText() const
+{
+  QString result;
+  QString section;
+  foreach (const Change & change, m_changes) {
+    if (change.section != section) {
+      section = change.section;
+      result += section + "\n";
+    }
+    result += QString("  %1 (%2)").arg(change.item, changeTypeToString(change.type));
+    if (change.type == ITEM_ADDED)
+      result += ": " + change.after;
+    else if (change.type == ITEM_REMOVED)
+      result += ": " + change.before;
+    result += "\n";
+    foreach (const Field & field, change.fields) {
+      result += QString("    %1: %2 -> %3\n").arg(field.name, field.before.isEmpty() ? "-" : field.before,
+                field.after.isEmpty() ? "-" : field.after);
+    }
+  }
+  return result;
+}
+
+QString ModelDiff::toHtml() const
+{
+  QString result = "<table cellspacing='0' cellpadding='3' width='100%'>";
+  result += QString("<tr><td class=mpc-section-title colspan='4'>%1</td></tr>").arg(tr("Differences"));
+  if (m_changes.isEmpty())
+    result += QString("<tr><td colspan='4'>%1</td></tr>").arg(tr("The models are identical"));
+
+  QString section;
+  foreach (const Change & change, m_changes) {
+    if (change.section != section) {
+      section = change.section;
+      result += QString("<tr><td colspan='4'><b>%1</b></td></tr>").arg(section.toHtmlEscaped());
+    }
+    QString item = QString("<td width='20%'>%1</td><td width='10%'>%2</td>").arg(change.item.toHtmlEscaped(), changeTypeToString(change.type));
+    if (change.fields.isEmpty()) {
+      result += QString("<tr>%1<td width='35%'>%2</td><td width='35%'>%3</td></tr>").arg(item, change.before.toHtmlEscaped(), change.after.toHtmlEscaped());
+    }
+    foreach (const Field & field, change.fields) {
+      result += QString("<tr>%1<td width='35%'>%2: %3</td><td width='35%'>%2: %4</td></tr>").arg(item, field.name.toHtmlEscaped(),
+                field.before.toHtmlEscaped(), field.after.toHtmlEscaped());
+      item = "<td></td><td></td>";
+    }
+  }
+
+  result += "</table>";
+  return result;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) OpenTX
+ *
+ * Based on code named
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef _MODELDIFF_H_
+#define _MODELDIFF_H_
+
+#include <QCoreApplication>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+class ModelData;
+class GeneralSettings;
+
+// Structural diff of two models: the mixes and the inputs are aligned by
+// identity (destination and source) so that an insertion doesn't shift all
+// the following lines, the items referenced by their number (logical
+// switches, special functions, outputs, ...) are aligned by slot. Each pair
+// of aligned items is compared field by field.
+class ModelDiff
+{
+  Q_DECLARE_TR_FUNCTIONS(ModelDiff)
+
+  public:
+    enum ChangeType {
+      ITEM_ADDED,
+      ITEM_REMOVED,
+      ITEM_CHANGED,
+      ITEM_MOVED     // order changed, the fields may have changed too
+    };
+
+    struct Field {
+      QString name;
+      QString before;
+      QString after;
+    };
+
+    struct Change {
+      ChangeType type;
+      QString section;
+      QString item;
+      QString before;   // summary of a removed item
+      QString after;    // summary of an added item
+      QList<Field> fields;
+    };
+
+    ModelDiff(const ModelData & model1, const GeneralSettings & settings1, const ModelData & model2, const GeneralSettings & settings2);
+
+    const QList<Change> & changes() const { return m_changes; }
+    bool isEmpty() const { return m_changes.isEmpty(); }
+
+    QString toText() const;
+    QString toHtml() const;
+
+    static QString changeTypeToString(ChangeType type);
+
+  protected:
+    typedef QList<QPair<QString, QString>> ItemFields;
+
+    struct Item {
+      qint64 key;
+      QString label;
+      ItemFields fields;
+    };
+
+    typedef QVector<Item> ItemList;
+
+    void compare(const QString & section, const ItemList & items1, const ItemList & items2);
+    void compareFields(Change & change, const ItemFields & fields1, const ItemFields & fields2);
+    static QString summary(const ItemFields & fields);
+
+    static void modelItems(const ModelData & model, const GeneralSettings & settings, ItemList & items);
+    static void inputItems(const ModelData & model, const GeneralSettings & settings, ItemList & items);
+    static void mixItems(const ModelData & model, const GeneralSettings & settings, ItemList & items);
+    static void outputItems(const ModelData & model, const GeneralSettings & settings, ItemList & items);
+    static void curveItems(const ModelData & model, const GeneralSettings & settings, ItemList & items);
+    static void logicalSwitchItems(const ModelData & model, const GeneralSettings & settings, ItemList & items);
+    static void customFunctionItems(const ModelData & model, const GeneralSettings & settings, ItemList & items);
+    static void timerItems(const ModelData & model, const GeneralSettings & settings, ItemList & items);
+    static void flightModeItems(const ModelData & model, const GeneralSettings & settings, ItemList & items);
+
+    static QString flightModesToString(const ModelData & model, unsigned int flightModes);
+    static QString trimToString(const ModelData & model, const GeneralSettings & settings, int carryTrim);
+    static QString boolToString(bool value);
+
+    QList<Change> m_changes;
+};
+
+#endif // _MODELDIFF_H_
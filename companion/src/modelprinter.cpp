@@ -28,6 +28,7 @@
 
 #include <QApplication>
 #include <QPainter>
+#include <QBuffer>
 #include <QFile>
 #include <QUrl>
 #include <QTextStream>
@@ -738,9 +739,16 @@ QString ModelPrinter::createCurveImage(int idx, QTextDocument * document)
 {
   CurveImage image;
   image.drawCurve(model.curves[idx], colors[idx]);
+  if (!document) {
+    // no document to hold the image (export to a file), it is embedded in the HTML
+    QByteArray png;
+    QBuffer buffer(&png);
+    buffer.open(QIODevice::WriteOnly);
+    image.get().save(&buffer, "PNG");
+    return "data:image/png;base64," + QString::fromLatin1(png.toBase64());
+  }
   QString filename = QString("mydata://curve-%1-%2.png").arg((uint64_t)this).arg(idx);
-  if (document)
-    document->addResource(QTextDocument::ImageResource, QUrl(filename), image.get());
+  document->addResource(QTextDocument::ImageResource, QUrl(filename), image.get());
   // qDebug() << "ModelPrinter::createCurveImage()" << idx << filename;
   return filename;
 }
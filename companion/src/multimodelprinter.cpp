@@ -22,13 +22,21 @@
 #include "helpers_html.h"
 #include "multimodelprinter.h"
 #include "appdata.h"
+#include <QFileInfo>
+#include <QRunnable>
 #include <algorithm>
 
+#define MULTICOLUMNS_RESERVE   1024
+#define MODEL_PRINT_RESERVE    (64 * 1024)
+
 MultiModelPrinter::MultiColumns::MultiColumns(int count):
   count(count),
   compareColumns(NULL)
 {
   columns = new QString[count];
+  for (int i=0; i<count; i++) {
+    columns[i].reserve(MULTICOLUMNS_RESERVE);
+  }
 }
 
 MultiModelPrinter::MultiColumns::~MultiColumns()
@@ -86,9 +94,17 @@ void MultiModelPrinter::MultiColumns::append(int idx, T val)
 
 QString MultiModelPrinter::MultiColumns::print()
 {
-  QString result = "<tr>";
+  int size = 16;
+  for (int i=0; i<count; i++) {
+    size += columns[i].size() + 32;
+  }
+  QString result;
+  result.reserve(size);
+  result.append("<tr>");
   for (int i=0; i<count; i++) {
-    result.append(QString("<td width='%1%'>%2</td>").arg(100.0/count).arg(columns[i]));
+    result.append(QString("<td width='%1%'>").arg(100.0/count));
+    result.append(columns[i]);
+    result.append("</td>");
   }
   result.append("</tr>");
   return result;
@@ -229,7 +245,8 @@ QString MultiModelPrinter::printTitle(const QString & label)
 }
 
 MultiModelPrinter::MultiModelPrinter(Firmware * firmware):
-  firmware(firmware)
+  firmware(firmware),
+  firmwareId(g.profile[g.id()].fwType())
 {
 }
 
@@ -266,11 +283,16 @@ void MultiModelPrinter::clearModels()
 
 QString MultiModelPrinter::print(QTextDocument * document)
 {
-  if (document) document->clear();
-  Stylesheet css(MODEL_PRINT_CSS);
-  if (css.load(Stylesheet::StyleType::STYLE_TYPE_EFFECTIVE))
-    document->setDefaultStyleSheet(css.text());
-  QString str = "<table cellspacing='0' cellpadding='3' width='100%'>";   // attributes not settable via QT stylesheet
+  // without document (export to a file) the stylesheet is set by the caller
+  if (document) {
+    document->clear();
+    Stylesheet css(MODEL_PRINT_CSS);
+    if (css.load(Stylesheet::StyleType::STYLE_TYPE_EFFECTIVE))
+      document->setDefaultStyleSheet(css.text());
+  }
+  QString str;
+  str.reserve(MODEL_PRINT_RESERVE * qMax(1, modelPrinterMap.size()));
+  str.append("<table cellspacing='0' cellpadding='3' width='100%'>");   // attributes not settable via QT stylesheet
   str.append(printSetup());
   if (firmware->getCapability(HasDisplayText))
     str.append(printChecklist());
@@ -832,8 +854,7 @@ QString MultiModelPrinter::printTelemetry()
     }
     columns.appendRowStart("", 20);
     columns.appendCellStart(80);
-    QString firmware_id = g.profile[g.id()].fwType();
-    if (firmware->getCapability(HasFasOffset) && firmware_id.contains("fasoffset")) {
+    if (firmware->getCapability(HasFasOffset) && firmwareId.contains("fasoffset")) {
       COMPARESTRING(tr("FAS offset"), QString("%1 A").arg(model->frsky.fasOffset/10.0), true);
     }
     if (firmware->getCapability(HasMahPersistent)) {
@@ -977,3 +998,183 @@ QString MultiModelPrinter::printChecklist()
   }
   return str;
 }
+
+class BatchModelPrinterTask : public QRunnable
+{
+  public:
+    BatchModelPrinterTask(BatchModelPrinter * printer, int index):
+      printer(printer),
+      index(index)
+    {
+    }
+
+    virtual void run()
+    {
+      printer->printPage(index);
+    }
+
+  protected:
+    BatchModelPrinter * printer;
+    int index;
+};
+
+BatchModelPrinter::BatchModelPrinter(Firmware * firmware, QObject * parent):
+  QObject(parent),
+  firmware(firmware),
+  pagesWritten(0)
+{
+  timer.setInterval(50);
+  connect(&timer, &QTimer::timeout, this, &BatchModelPrinter::writePages);
+}
+
+BatchModelPrinter::~BatchModelPrinter()
+{
+  cancel();
+  pool.waitForDone();
+  if (file.isOpen()) {
+    file.cancelWriting();
+    file.commit();
+  }
+  foreach (const Page & page, pages) {
+    delete page.printer;
+  }
+}
+
+bool BatchModelPrinter::start(const QVector<const ModelData *> & models, const GeneralSettings & generalSettings, const QString & filename)
+{
+  if (isRunning()) {
+    m_error = tr("An export is already running");
+    return false;
+  }
+
+  m_error.clear();
+  canceled.store(0);
+  pagesWritten = 0;
+
+  file.setFileName(filename);
+  if (!file.open(QIODevice::WriteOnly)) {
+    m_error = tr("Error writing file %1:\n%2.").arg(filename).arg(file.errorString());
+    return false;
+  }
+
+  // the stylesheet of the print preview is embedded in the file
+  Stylesheet css(MODEL_PRINT_CSS);
+  QString header = "<!DOCTYPE html>\n<html><head><meta charset='utf-8'/>";
+  header.append(QString("<title>%1</title>").arg(QFileInfo(filename).completeBaseName().toHtmlEscaped()));
+  if (css.load(Stylesheet::StyleType::STYLE_TYPE_EFFECTIVE))
+    header.append("<style>\n" + css.text() + "</style>");
+  header.append("</head><body>\n");
+  file.write(header.toUtf8());
+
+  this->models.clear();
+  this->models.reserve(models.size());
+  foreach (const ModelData * model, models) {
+    this->models.push_back(*model);
+  }
+  this->generalSettings = generalSettings;
+
+  // the printers are created here, the threads only print
+  pages.resize(models.size());
+  for (int i=0; i<pages.size(); i++) {
+    pages[i].printer = new MultiModelPrinter(firmware);
+    pages[i].printer->setModel(0, &this->models[i], &this->generalSettings);
+    pages[i].html.clear();
+    pages[i].ready = false;
+  }
+
+  for (int i=0; i<pages.size(); i++) {
+    BatchModelPrinterTask * task = new BatchModelPrinterTask(this, i);
+    task->setAutoDelete(true);
+    pool.start(task);
+  }
+
+  timer.start();
+  emit progress(0, pages.size());
+  return true;
+}
+
+void BatchModelPrinter::cancel()
+{
+  canceled.store(1);
+  pool.clear();
+}
+
+void BatchModelPrinter::printPage(int index)
+{
+  MultiModelPrinter * printer;
+  {
+    QMutexLocker locker(&mutex);
+    printer = pages[index].printer;
+  }
+
+  QString html;
+  if (!canceled.load()) {
+    html = QString("<h2>%1</h2>\n").arg(QString(models[index].name).toHtmlEscaped());
+    html.append(printer->print(nullptr));
+    html.append("\n<div style='page-break-after: always'></div>\n");
+  }
+
+  QMutexLocker locker(&mutex);
+  pages[index].html = html;
+  pages[index].ready = true;
+}
+
+// writes the pages printed so far in order, the memory of a page is freed
+// as soon as it is written
+void BatchModelPrinter::writePages()
+{
+  while (pagesWritten < pages.size() && !canceled.load()) {
+    QString html;
+    {
+      QMutexLocker locker(&mutex);
+      Page & page = pages[pagesWritten];
+      if (!page.ready)
+        break;
+      html.swap(page.html);
+      delete page.printer;
+      page.printer = nullptr;
+    }
+    if (file.write(html.toUtf8()) < 0) {
+      m_error = tr("Error writing file %1:\n%2.").arg(file.fileName()).arg(file.errorString());
+      cancel();
+      break;
+    }
+    pagesWritten++;
+  }
+
+  if (canceled.load()) {
+    // wait for the pages being printed
+    if (pool.waitForDone(0))
+      finish(false);
+    return;
+  }
+
+  emit progress(pagesWritten, pages.size());
+  if (pagesWritten == pages.size())
+    finish(true);
+}
+
+void BatchModelPrinter::finish(bool success)
+{
+  timer.stop();
+
+  if (success) {
+    file.write("</body></html>\n");
+    if (!file.commit()) {
+      m_error = tr("Error writing file %1:\n%2.").arg(file.fileName()).arg(file.errorString());
+      success = false;
+    }
+  }
+  else {
+    file.cancelWriting();
+    file.commit();
+  }
+
+  foreach (const Page & page, pages) {
+    delete page.printer;
+  }
+  pages.clear();
+  models.clear();
+
+  emit finished(success);
+}
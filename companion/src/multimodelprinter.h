@@ -21,8 +21,14 @@
 #ifndef _MULTIMODELPRINTER_H_
 #define _MULTIMODELPRINTER_H_
 
+#include <QAtomicInt>
+#include <QMutex>
 #include <QObject>
+#include <QSaveFile>
 #include <QTextDocument>
+#include <QThreadPool>
+#include <QTimer>
+#include <vector>
 #include "eeprominterface.h"
 #include "modelprinter.h"
 
@@ -74,6 +80,7 @@ class MultiModelPrinter: public QObject
     };
 
     Firmware * firmware;
+    QString firmwareId;
     GeneralSettings defaultSettings;
     QMap<int, QPair<const ModelData *, ModelPrinter *> > modelPrinterMap;
 
@@ -97,4 +104,56 @@ class MultiModelPrinter: public QObject
     QString printChecklist();
 };
 
+// Prints a list of models to a HTML file in background: the models are
+// printed by a pool of threads and the pages are written in order as soon
+// as they are ready, so the whole document is never held in memory
+class BatchModelPrinter : public QObject
+{
+  Q_OBJECT
+
+  public:
+    BatchModelPrinter(Firmware * firmware, QObject * parent = nullptr);
+    virtual ~BatchModelPrinter();
+
+    void setThreadCount(int count) { pool.setMaxThreadCount(qMax(1, count)); }
+    // the models and the settings are copied, returns false if the file can't be created
+    bool start(const QVector<const ModelData *> & models, const GeneralSettings & generalSettings, const QString & filename);
+    bool isRunning() const { return timer.isActive(); }
+    bool isCanceled() const { return canceled.load(); }
+    QString errorString() const { return m_error; }
+
+  public slots:
+    void cancel();
+
+  signals:
+    void progress(int done, int total);
+    void finished(bool success);
+
+  protected slots:
+    void writePages();
+
+  protected:
+    struct Page {
+      MultiModelPrinter * printer;
+      QString html;
+      bool ready;
+    };
+
+    friend class BatchModelPrinterTask;
+    void printPage(int index);
+    void finish(bool success);
+
+    Firmware * firmware;
+    std::vector<ModelData> models;
+    GeneralSettings generalSettings;
+    QVector<Page> pages;
+    QMutex mutex;
+    QAtomicInt canceled;
+    int pagesWritten;
+    QThreadPool pool;
+    QTimer timer;
+    QSaveFile file;
+    QString m_error;
+};
+
 #endif // _MULTIMODELPRINTER_H_
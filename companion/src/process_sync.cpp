@@ -24,8 +24,14 @@
 #include <QCryptographicHash>
 #include <QElapsedTimer>
 #include <QMutexLocker>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QStandardPaths>
 
 #define SYNC_MAX_ERRORS       50  // give up after this many errors per destination
+#define SYNC_CHUNK_KB         1024
+#define SYNC_READ_AHEAD_KB    (16 * 1024)  // file data read by the copy threads and not yet written
+#define SYNC_HASH_ALGORITHM   QCryptographicHash::Md5
 
 // a flood of log messages can make the UI unresponsive so we'll introduce a dynamic sleep period based on log frequency (values in [us])
 #define PAUSE_FACTOR          60UL
@@ -52,8 +58,115 @@
   #define FILTER_RE_SYNTX     QRegExp::WildcardUnix
 #endif
 
+void SyncManifest::load(const QString & folder)
+{
+  // the manifests are kept with the application data, not on the synchronized folders
+  const QString path = QDir(folder).absolutePath();
+  this->folder = path;
+  filename = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) % "/sync/" % QString::fromLatin1(QCryptographicHash::hash(path.toUtf8(), QCryptographicHash::Md5).toHex()) % ".txt";
+  entries.clear();
+  modified = false;
+
+  QFile file(filename);
+  if (!file.open(QFile::ReadOnly | QFile::Text))
+    return;
+
+  // <hash> <size> <msecs since epoch> <path>
+  while (!file.atEnd()) {
+    const QString line = QString::fromUtf8(file.readLine()).trimmed();
+    const QStringList fields = line.split(' ');
+    if (fields.size() < 4)
+      continue;
+    Entry entry;
+    entry.hash = QByteArray::fromHex(fields.at(0).toLatin1());
+    entry.size = fields.at(1).toLongLong();
+    entry.lastModified = fields.at(2).toLongLong();
+    entries.insert(line.section(' ', 3), entry);
+  }
+}
+
+bool SyncManifest::save()
+{
+  const QDir dir(folder);
+  for (QHash<QString, Entry>::iterator it = entries.begin(); it != entries.end(); ) {
+    if (!dir.exists(it.key())) {
+      it = entries.erase(it);
+      modified = true;
+    }
+    else {
+      ++it;
+    }
+  }
+
+  if (!modified || filename.isEmpty())
+    return true;
+
+  if (!QDir().mkpath(QFileInfo(filename).absolutePath()))
+    return false;
+
+  QSaveFile file(filename);
+  if (!file.open(QFile::WriteOnly | QFile::Text))
+    return false;
+  for (QHash<QString, Entry>::const_iterator it = entries.constBegin(); it != entries.constEnd(); ++it) {
+    file.write(it.value().hash.toHex() + ' ' + QByteArray::number(it.value().size) + ' ' + QByteArray::number(it.value().lastModified) + ' ' + it.key().toUtf8() + '\n');
+  }
+  modified = false;
+  return file.commit();
+}
+
+bool SyncManifest::hash(const QFileInfo & fileInfo, const QString & path, QByteArray & result, QString & error)
+{
+  const qint64 lastModified = fileInfo.lastModified().toMSecsSinceEpoch();
+  QHash<QString, Entry>::const_iterator it = entries.constFind(path);
+  if (it != entries.constEnd() && it.value().size == fileInfo.size() && it.value().lastModified == lastModified) {
+    result = it.value().hash;
+    return true;
+  }
+
+  QFile file(fileInfo.absoluteFilePath());
+  QCryptographicHash hash(SYNC_HASH_ALGORITHM);
+  if (!file.open(QFile::ReadOnly) || !hash.addData(&file)) {
+    error = file.errorString();
+    return false;
+  }
+  result = hash.result();
+  update(path, fileInfo.size(), fileInfo.lastModified(), result);
+  return true;
+}
+
+void SyncManifest::update(const QString & path, qint64 size, const QDateTime & lastModified, const QByteArray & hash)
+{
+  Entry & entry = entries[path];
+  entry.size = size;
+  entry.lastModified = lastModified.toMSecsSinceEpoch();
+  entry.hash = hash;
+  modified = true;
+}
+
+class SyncCopyTask : public QRunnable
+{
+  public:
+    SyncCopyTask(SyncProcess * process, const SyncProcess::CopyJob & job):
+      process(process),
+      job(job)
+    {
+    }
+
+    virtual void run()
+    {
+      process->copyFile(job);
+    }
+
+  protected:
+    SyncProcess * process;
+    SyncProcess::CopyJob job;
+};
+
 SyncProcess::SyncProcess(const SyncProcess::SyncOptions & options) :
   m_options(options),
+  m_srcManifest(nullptr),
+  m_dstManifest(nullptr),
+  m_readAhead(SYNC_READ_AHEAD_KB),
   m_pauseTime(PAUSE_MINTM),
   stopping(false)
 {
@@ -118,6 +231,9 @@ void SyncProcess::run()
   emit fileCountChanged(0);
   emit statusUpdate(m_stat);
 
+  m_manifestA.load(folderA);
+  m_manifestB.load(folderB);
+
   if (direction == SYNC_A2B_B2A || direction == SYNC_A2B) {
     emit statusMessage(gathering.arg(folderA));
     count = getFilesCount(folderA);
@@ -130,6 +246,8 @@ void SyncProcess::run()
       if (m_options.direction == SYNC_A2B_B2A)
         count *= 2;  // assume this direction is only 50% of total, exact will be calculated later
       emit fileCountChanged(count);
+      m_srcManifest = &m_manifestA;
+      m_dstManifest = &m_manifestB;
       updateDir(folderA, folderB);
       if (isStopRequsted())
         goto endrun;
@@ -151,6 +269,8 @@ void SyncProcess::run()
     emit fileCountChanged(m_stat.count);
 
     if (count) {
+      m_srcManifest = &m_manifestB;
+      m_dstManifest = &m_manifestA;
       updateDir(folderB, folderA);
     }
     else {
@@ -166,6 +286,8 @@ void SyncProcess::run()
   }
 
   endrun:
+  if (!m_manifestA.save() || !m_manifestB.save())
+    PRINT_INFO(tr("Could not save the files information for the next synchronization."));
   finish();
 }
 
@@ -258,6 +380,7 @@ void SyncProcess::updateDir(const QString & source, const QString & destination)
       pushDirEntries(fi, it);
       if ((m_dirFilters & QDir::Dirs) || fi.isFile()) {
         updateEntry(fi.filePath(), srcDir, dstDir);
+        processCopyResults();
         if (fi.isFile())
           ++m_stat.index;
         emit statusUpdate(m_stat);
@@ -288,6 +411,8 @@ void SyncProcess::updateDir(const QString & source, const QString & destination)
     pause();
   }
 
+  waitForCopies();
+
   QString endStr = "\n" % testRunStr;
   if (isStopRequsted())
     endStr.append(tr("Aborted synchronization of:"));
@@ -301,8 +426,9 @@ void SyncProcess::updateDir(const QString & source, const QString & destination)
 
 bool SyncProcess::updateEntry(const QString & entry, const QDir & source, const QDir & destination)
 {
+  const QString relativePath = source.relativeFilePath(entry);
   const QString srcPath = QDir::toNativeSeparators(source.absoluteFilePath(entry));
-  const QString destPath = QDir::toNativeSeparators(destination.absoluteFilePath(source.relativeFilePath(entry)));
+  const QString destPath = QDir::toNativeSeparators(destination.absoluteFilePath(relativePath));
   const QFileInfo sourceInfo(srcPath);
   const QFileInfo destInfo(destPath);
   static QString lastMkPath;
@@ -336,8 +462,6 @@ bool SyncProcess::updateEntry(const QString & entry, const QDir & source, const
   }
 
   //qDebug() << destPath;
-  QFile sourceFile(srcPath);
-  QFile destinationFile(destPath);
   const bool destExists = destInfo.exists();
   bool checkDate = (m_options.compareType == OVERWR_NEWER_IF_DIFF || m_options.compareType == OVERWR_NEWER_ALWAYS);
   bool checkContent = (m_options.compareType == OVERWR_NEWER_IF_DIFF || m_options.compareType == OVERWR_IF_DIFF);
@@ -359,20 +483,23 @@ bool SyncProcess::updateEntry(const QString & entry, const QDir & source, const
   }
 
   if (destExists && checkContent) {
-    if (!sourceFile.open(QFile::ReadOnly)) {
-      PRINT_ERROR(tr("Could not open source file '%1': %2").arg(srcPath, sourceFile.errorString()));
-      ++m_stat.errored;
-      return false;
-    }
-    if (!destinationFile.open(QFile::ReadOnly)) {
-      PRINT_ERROR(tr("Could not open destination file '%1': %2").arg(destPath, destinationFile.errorString()));
-      ++m_stat.errored;
-      return false;
+    // files of different sizes differ, the hashes of unchanged files are in the manifests
+    bool skip = false;
+    if (sourceInfo.size() == destInfo.size()) {
+      QByteArray sourceHash, destinationHash;
+      QString error;
+      if (!m_srcManifest->hash(sourceInfo, relativePath, sourceHash, error)) {
+        PRINT_ERROR(tr("Could not open source file '%1': %2").arg(srcPath, error));
+        ++m_stat.errored;
+        return false;
+      }
+      if (!m_dstManifest->hash(destInfo, relativePath, destinationHash, error)) {
+        PRINT_ERROR(tr("Could not open destination file '%1': %2").arg(destPath, error));
+        ++m_stat.errored;
+        return false;
+      }
+      skip = (sourceHash == destinationHash);
     }
-
-    const bool skip = QCryptographicHash::hash(sourceFile.readAll(), QCryptographicHash::Md5) == QCryptographicHash::hash(destinationFile.readAll(), QCryptographicHash::Md5);
-    sourceFile.close();
-    destinationFile.close();
     if (skip) {
       PRINT_SKIP(tr("Skipping identical file: %1").arg(srcPath));
       ++m_stat.skipped;
@@ -385,28 +512,105 @@ bool SyncProcess::updateEntry(const QString & entry, const QDir & source, const
     if (destInfo.exists()) {
       existed = true;
       PRINT_REPLACE(tr("Replacing file: %1").arg(destPath));
-      if (!(m_options.flags & OPT_DRY_RUN) && !destinationFile.remove()) {
-        PRINT_ERROR(tr("Could not delete destination file '%1': %2").arg(destPath, destinationFile.errorString()));
-        ++m_stat.errored;
-        return false;
-      }
     }
     else {
       PRINT_CREATE(tr("Creating file: %1").arg(destPath));
     }
-    if (!(m_options.flags & OPT_DRY_RUN) && !sourceFile.copy(destPath)) {
-      PRINT_ERROR(tr("Copy failed: '%1' to '%2': %3").arg(srcPath, destPath, sourceFile.errorString()));
-      ++m_stat.errored;
-      return false;
+
+    if (m_options.flags & OPT_DRY_RUN) {
+      if (existed)
+        ++m_stat.updated;
+      else
+        ++m_stat.created;
+      return true;
+    }
+
+    // the copy is done by the pool, its result is counted by processCopyResults()
+    CopyJob job;
+    job.srcPath = srcPath;
+    job.destPath = destPath;
+    job.path = relativePath;
+    job.srcSize = sourceInfo.size();
+    job.srcLastModified = sourceInfo.lastModified();
+    job.existed = existed;
+    m_copyPool.start(new SyncCopyTask(this, job));
+  }
+
+  return true;
+}
+
+// runs on the copy threads
+void SyncProcess::copyFile(CopyJob & job)
+{
+  QFile source(job.srcPath);
+  QSaveFile destination(job.destPath);
+  QCryptographicHash hash(SYNC_HASH_ALGORITHM);
+
+  if (!source.open(QFile::ReadOnly)) {
+    job.error = tr("Could not open source file '%1': %2").arg(job.srcPath, source.errorString());
+  }
+  else if (!destination.open(QFile::WriteOnly)) {
+    job.error = tr("Could not open destination file '%1': %2").arg(job.destPath, destination.errorString());
+  }
+  else {
+    // the memory used by all the copies is bounded by the read ahead semaphore
+    while (!source.atEnd() && job.error.isEmpty()) {
+      if (isStopRequsted()) {
+        job.error = tr("Copy aborted: '%1' to '%2'").arg(job.srcPath, job.destPath);
+        break;
+      }
+      m_readAhead.acquire(SYNC_CHUNK_KB);
+      const QByteArray chunk = source.read(SYNC_CHUNK_KB * 1024);
+      if (chunk.isEmpty() || destination.write(chunk) != chunk.size())
+        job.error = tr("Copy failed: '%1' to '%2': %3").arg(job.srcPath, job.destPath, chunk.isEmpty() ? source.errorString() : destination.errorString());
+      else
+        hash.addData(chunk);
+      m_readAhead.release(SYNC_CHUNK_KB);
     }
+    if (job.error.isEmpty() && !destination.commit())
+      job.error = tr("Copy failed: '%1' to '%2': %3").arg(job.srcPath, job.destPath, destination.errorString());
+    job.hash = hash.result();
+  }
+
+  QMutexLocker locker(&m_copyMutex);
+  m_copyResults.append(job);
+}
+
+void SyncProcess::processCopyResults()
+{
+  QList<CopyJob> results;
+  {
+    QMutexLocker locker(&m_copyMutex);
+    results.swap(m_copyResults);
+  }
 
-    if (existed)
+  for (const CopyJob & job : results) {
+    if (!job.error.isEmpty()) {
+      PRINT_ERROR(job.error);
+      ++m_stat.errored;
+      continue;
+    }
+    // both files are known for the next synchronization
+    const QFileInfo destInfo(job.destPath);
+    m_srcManifest->update(job.path, job.srcSize, job.srcLastModified, job.hash);
+    m_dstManifest->update(job.path, destInfo.size(), destInfo.lastModified(), job.hash);
+    if (job.existed)
       ++m_stat.updated;
     else
       ++m_stat.created;
   }
 
-  return true;
+  if (!results.isEmpty())
+    emit statusUpdate(m_stat);
+}
+
+void SyncProcess::waitForCopies()
+{
+  while (!m_copyPool.waitForDone(50)) {
+    processCopyResults();
+    QApplication::processEvents();
+  }
+  processCopyResults();
 }
 
 void SyncProcess::pause()
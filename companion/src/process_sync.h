@@ -26,10 +26,42 @@
 #include <QDebug>
 #include <QDir>
 #include <QDirIterator>
+#include <QHash>
+#include <QMutex>
 #include <QReadWriteLock>
 #include <QRegExp>
+#include <QSemaphore>
+#include <QThreadPool>
 #include <QVector>
 
+// Size, modification time and hash of the files of a synchronized folder,
+// saved between synchronizations so that unchanged files are not read again
+class SyncManifest
+{
+  public:
+    SyncManifest(): modified(false) {}
+
+    void load(const QString & folder);
+    // the files which don't exist anymore are removed
+    bool save();
+
+    // from the manifest when the file size and date didn't change
+    bool hash(const QFileInfo & fileInfo, const QString & path, QByteArray & result, QString & error);
+    void update(const QString & path, qint64 size, const QDateTime & lastModified, const QByteArray & hash);
+
+  protected:
+    struct Entry {
+      qint64 size;
+      qint64 lastModified;  // msecs since epoch
+      QByteArray hash;
+    };
+
+    QString folder;
+    QString filename;
+    QHash<QString, Entry> entries;
+    bool modified;
+};
+
 class SyncProcess : public QObject
 {
     Q_OBJECT
@@ -121,6 +153,19 @@ class SyncProcess : public QObject
   protected:
     enum FileFilterResult { FILE_ALLOW, FILE_OVERSIZE, FILE_EXCLUDE, FILE_LINK_IGNORE };
 
+    struct CopyJob {
+      QString srcPath;
+      QString destPath;
+      QString path;         // relative to the synchronized folders
+      qint64 srcSize;
+      QDateTime srcLastModified;
+      bool existed;
+      QByteArray hash;
+      QString error;
+    };
+
+    friend class SyncCopyTask;
+
     bool isStopRequsted();
     void finish();
     FileFilterResult fileFilter(const QFileInfo & fileInfo);
@@ -129,6 +174,9 @@ class SyncProcess : public QObject
     void updateDir(const QString & source, const QString & destination);
     void pushDirEntries(const QFileInfo & fi, QMutableListIterator<QFileInfo> &it);
     bool updateEntry(const QString & entry, const QDir & source, const QDir & destination);
+    void copyFile(CopyJob & job);
+    void processCopyResults();
+    void waitForCopies();
     void pause();
     void emitProgressMessage(const QString &text, int type);
 
@@ -140,6 +188,14 @@ class SyncProcess : public QObject
     QStringList m_dirIteratorFilters;
     QDir::Filters m_dirFilters;
     QDateTime m_startTime;
+    SyncManifest m_manifestA;
+    SyncManifest m_manifestB;
+    SyncManifest * m_srcManifest;
+    SyncManifest * m_dstManifest;
+    QThreadPool m_copyPool;
+    QSemaphore m_readAhead;   // KB of file data read and not yet written
+    QMutex m_copyMutex;
+    QList<CopyJob> m_copyResults;
     unsigned long m_pauseTime;
     bool stopping;
 };
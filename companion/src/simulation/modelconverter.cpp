@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) OpenTX
+ *
+ * Based on code named
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "modelconverter.h"
+#include "simulatorinterface.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QThread>
+#include <QThreadPool>
+
+#define MINIZ_HEADER_FILE_ONLY
+#include "miniz.c"
+#undef MINIZ_HEADER_FILE_ONLY
+
+#define RADIO_SETTINGS_FILE    "RADIO/radio.bin"
+#define MODELS_FOLDER          "MODELS"
+
+class ModelConverterTask : public QRunnable
+{
+  public:
+    ModelConverterTask(ModelConverter * converter, ModelConverter::Job & job):
+      converter(converter),
+      job(job)
+    {
+    }
+
+    virtual void run()
+    {
+      converter->runJob(job);
+    }
+
+  protected:
+    ModelConverter * converter;
+    ModelConverter::Job & job;
+};
+
+ModelConverter::ModelConverter(SimulatorInterface * simulator, QObject * parent):
+  QObject(parent),
+  simulator(simulator),
+  threadCount(QThread::idealThreadCount())
+{
+}
+
+int ModelConverter::errorsCount() const
+{
+  int count = 0;
+  foreach (const Result & result, m_results) {
+    if (!result.error.isEmpty())
+      count++;
+  }
+  return count;
+}
+
+void ModelConverter::runJob(Job & job)
+{
+  Result & result = job.result;
+
+  if (!job.source.isEmpty()) {
+    QFile file(job.source);
+    if (!file.open(QIODevice::ReadOnly)) {
+      result.error = file.errorString();
+      jobsDone.ref();
+      return;
+    }
+    job.data = file.readAll();
+  }
+
+  result.version = (job.data.size() >= 8 ? (uint8_t)job.data.at(4) : 0);
+
+  QByteArray converted;
+  result.error = simulator->convertFile(job.data, converted, job.radio);
+  if (result.error.isEmpty()) {
+    result.changed = (converted != job.data);
+    job.data = converted;
+  }
+
+  // the file is copied as is if it can't be converted
+  if (!job.destination.isEmpty() && (result.changed || job.destination != job.source)) {
+    QSaveFile file(job.destination);
+    if (!file.open(QIODevice::WriteOnly) || file.write(job.data) != job.data.size() || !file.commit()) {
+      result.error = file.errorString();
+    }
+  }
+
+  jobsDone.ref();
+}
+
+void ModelConverter::runJobs(QList<Job> & jobs)
+{
+  QThreadPool pool;
+  pool.setMaxThreadCount(qMax(1, threadCount));
+  jobsDone.store(0);
+
+  for (int i=0; i<jobs.size(); i++) {
+    ModelConverterTask * task = new ModelConverterTask(this, jobs[i]);
+    task->setAutoDelete(true);
+    pool.start(task);
+  }
+
+  while (!pool.waitForDone(100)) {
+    emit progress(jobsDone.load(), jobs.size());
+  }
+  emit progress(jobs.size(), jobs.size());
+
+  foreach (const Job & job, jobs) {
+    m_results.append(job.result);
+  }
+}
+
+bool ModelConverter::convertFolder(const QString & path, const QString & destination)
+{
+  QDir dir(path);
+  if (!dir.exists()) {
+    m_error = tr("Folder %1 not found").arg(path);
+    return false;
+  }
+
+  QStringList filenames;
+  QDir modelsDir(dir);
+  if (modelsDir.cd(MODELS_FOLDER)) {
+    // a SD card root
+    if (dir.exists(RADIO_SETTINGS_FILE))
+      filenames << RADIO_SETTINGS_FILE;
+    foreach (const QString & filename, modelsDir.entryList(QStringList() << "*.bin", QDir::Files, QDir::Name)) {
+      filenames << QString(MODELS_FOLDER "/") + filename;
+    }
+  }
+  else {
+    filenames = dir.entryList(QStringList() << "*.bin", QDir::Files, QDir::Name);
+  }
+
+  QDir destinationDir(destination.isEmpty() ? path : destination);
+  QList<Job> jobs;
+  foreach (const QString & filename, filenames) {
+    Job job;
+    job.source = dir.filePath(filename);
+    job.destination = destinationDir.filePath(filename);
+    job.radio = (filename.compare(RADIO_SETTINGS_FILE, Qt::CaseInsensitive) == 0);
+    job.result = {filename, QString(), 0, false};
+    if (!QDir().mkpath(QFileInfo(job.destination).path())) {
+      m_error = tr("Cannot create folder %1").arg(QFileInfo(job.destination).path());
+      return false;
+    }
+    jobs.append(job);
+  }
+
+  runJobs(jobs);
+  return true;
+}
+
+bool ModelConverter::convertArchive(const QString & filename, const QString & destination)
+{
+  QFile file(filename);
+  if (!file.open(QIODevice::ReadOnly)) {
+    m_error = tr("Error opening file %1:\n%2.").arg(filename).arg(file.errorString());
+    return false;
+  }
+  QByteArray archiveContents = file.readAll();
+  file.close();
+
+  mz_zip_archive zip;
+  memset(&zip, 0, sizeof(zip));
+  if (!mz_zip_reader_init_mem(&zip, archiveContents.constData(), archiveContents.size(), 0)) {
+    m_error = tr("Error opening OTX archive %1").arg(filename);
+    return false;
+  }
+
+  // the other entries (sounds, images...) are copied as is
+  QList<Job> jobs;
+  QList<Job> entries;
+  for (unsigned int i=0; i<mz_zip_reader_get_num_files(&zip); i++) {
+    char name[256];
+    mz_zip_reader_get_filename(&zip, i, name, sizeof(name));
+    if (mz_zip_reader_is_file_a_directory(&zip, i))
+      continue;
+    size_t size;
+    void * data = mz_zip_reader_extract_to_heap(&zip, i, &size, 0);
+    if (!data) {
+      mz_zip_reader_end(&zip);
+      m_error = tr("Error extracting %1 from %2").arg(name).arg(filename);
+      return false;
+    }
+    Job job;
+    job.radio = (QString(name).compare(RADIO_SETTINGS_FILE, Qt::CaseInsensitive) == 0);
+    job.data = QByteArray((const char *)data, size);
+    job.result = {QString(name), QString(), 0, false};
+    mz_free(data);
+    if (job.radio || (QString(name).startsWith(MODELS_FOLDER "/", Qt::CaseInsensitive) && QString(name).endsWith(".bin", Qt::CaseInsensitive)))
+      jobs.append(job);
+    else
+      entries.append(job);
+  }
+  mz_zip_reader_end(&zip);
+
+  runJobs(jobs);
+
+  memset(&zip, 0, sizeof(zip));
+  if (!mz_zip_writer_init_heap(&zip, 0, archiveContents.size())) {
+    m_error = tr("Error initializing OTX archive writer");
+    return false;
+  }
+
+  bool result = true;
+  foreach (const Job & job, entries + jobs) {
+    if (!mz_zip_writer_add_mem(&zip, qPrintable(job.result.filename), job.data.constData(), job.data.size(), MZ_DEFAULT_LEVEL)) {
+      m_error = tr("Error adding %1 to OTX archive").arg(job.result.filename);
+      result = false;
+      break;
+    }
+  }
+
+  char * contents;
+  size_t size;
+  if (result && mz_zip_writer_finalize_heap_archive(&zip, (void **)&contents, &size)) {
+    QSaveFile output(destination.isEmpty() ? filename : destination);
+    if (!output.open(QIODevice::WriteOnly) || output.write(contents, size) != (qint64)size || !output.commit()) {
+      m_error = tr("Error writing file %1:\n%2.").arg(output.fileName()).arg(output.errorString());
+      result = false;
+    }
+  }
+  else if (result) {
+    m_error = tr("Error creating OTX archive");
+    result = false;
+  }
+
+  mz_zip_writer_end(&zip);
+  return result;
+}
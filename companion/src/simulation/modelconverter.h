@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) OpenTX
+ *
+ * Based on code named
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef _MODELCONVERTER_H_
+#define _MODELCONVERTER_H_
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QList>
+#include <QObject>
+#include <QString>
+
+class SimulatorInterface;
+
+// Converts the radio settings and the models of a SD card folder or of a
+// .otx archive to the current version, with the conversion code of the
+// firmware (simulator library). Files are read, converted and written by
+// a pool of threads; the simulator library serializes the conversions.
+class ModelConverter : public QObject
+{
+  Q_OBJECT
+
+  public:
+
+    struct Result {
+      QString filename;   // relative to the SD card root or archive
+      QString error;
+      int version;        // before the conversion, 0 if unknown
+      bool changed;
+    };
+
+    ModelConverter(SimulatorInterface * simulator, QObject * parent = nullptr);
+
+    void setThreadCount(int count) { threadCount = count; }
+    // destination is a folder / archive name, empty to convert in place
+    bool convertFolder(const QString & path, const QString & destination = QString());
+    bool convertArchive(const QString & filename, const QString & destination = QString());
+
+    const QList<Result> & results() const { return m_results; }
+    QString errorString() const { return m_error; }
+    int errorsCount() const;
+
+  signals:
+
+    void progress(int done, int total);
+
+  protected:
+
+    struct Job {
+      QString source;       // file path, empty when the data is already read
+      QString destination;  // file path, empty to keep the data
+      bool radio;
+      QByteArray data;
+      Result result;
+    };
+
+    friend class ModelConverterTask;
+    void runJob(Job & job);
+    void runJobs(QList<Job> & jobs);
+
+    SimulatorInterface * simulator;
+    int threadCount;
+    QAtomicInt jobsDone;
+    QList<Result> m_results;
+    QString m_error;
+};
+
+#endif // _MODELCONVERTER_H_
@@ -37,6 +37,7 @@ RadioOutputsWidget::RadioOutputsWidget(SimulatorInterface * simulator, Firmware
   QWidget(parent),
   m_simulator(simulator),
   m_firmware(firmware),
+  m_resetOutputs(true),
   m_radioProfileId(g.sessionId()),
   ui(new Ui::RadioOutputsWidget)
 {
@@ -48,10 +49,7 @@ RadioOutputsWidget::RadioOutputsWidget(SimulatorInterface * simulator, Firmware
   connect(ui->channelsScroll->horizontalScrollBar(), &QScrollBar::sliderMoved, ui->mixersScroll->horizontalScrollBar(), &QScrollBar::setValue);
   connect(ui->mixersScroll->horizontalScrollBar(), &QScrollBar::sliderMoved, ui->channelsScroll->horizontalScrollBar(), &QScrollBar::setValue);
 
-  connect(m_simulator, &SimulatorInterface::channelOutValueChange, this, &RadioOutputsWidget::onChannelOutValueChange);
-  connect(m_simulator, &SimulatorInterface::channelMixValueChange, this, &RadioOutputsWidget::onChannelMixValueChange);
-  connect(m_simulator, &SimulatorInterface::virtualSwValueChange, this, &RadioOutputsWidget::onVirtSwValueChange);
-  connect(m_simulator, &SimulatorInterface::gVarValueChange, this, &RadioOutputsWidget::onGVarValueChange);
+  connect(m_simulator, &SimulatorInterface::outputsUpdated, this, &RadioOutputsWidget::onOutputsUpdated);
   connect(m_simulator, &SimulatorInterface::phaseChanged, this, &RadioOutputsWidget::onPhaseChanged);
 }
 
@@ -80,6 +78,8 @@ void RadioOutputsWidget::start()
   setupChannelsDisplay(true);
   setupGVarsDisplay();
   setupLsDisplay();
+  m_resetOutputs = true;
+  onOutputsUpdated();
 }
 
 //void RadioOutputsWidget::stop()
@@ -303,6 +303,37 @@ QWidget * RadioOutputsWidget::createLogicalSwitch(QWidget * parent, int switchNo
   return swtch;
 }
 
+// only the displayed outputs which changed since the last update are redrawn
+void RadioOutputsWidget::onOutputsUpdated()
+{
+  SimulatorInterface::TxOutputs outputs;
+  m_simulator->getOutputs(outputs);
+  if (!outputs.chanLimit)
+    return;  // nothing published yet
+
+  for (int i=0; i < m_channelsMap.size(); i++) {
+    if (m_resetOutputs || outputs.chanLimit != m_outputs.chanLimit || outputs.changed(m_outputs, SimulatorInterface::OUTPUT_SRC_CHAN_OUT, i))
+      onChannelOutValueChange(i, outputs.chans[i], outputs.chanLimit);
+  }
+  for (int i=0; i < m_mixesMap.size(); i++) {
+    if (m_resetOutputs || outputs.changed(m_outputs, SimulatorInterface::OUTPUT_SRC_CHAN_MIX, i))
+      onChannelMixValueChange(i, outputs.ex_chans[i], outputs.mixLimit);
+  }
+  for (int i=0; i < m_logicSwitchMap.size(); i++) {
+    if (m_resetOutputs || outputs.changed(m_outputs, SimulatorInterface::OUTPUT_SRC_VIRTUAL_SW, i))
+      onVirtSwValueChange(i, outputs.vsw[i]);
+  }
+  for (int gv=0; gv < m_globalVarsMap.size(); gv++) {
+    for (int fm=0; fm < m_globalVarsMap.value(gv).size(); fm++) {
+      if (m_resetOutputs || outputs.gvars[fm][gv] != m_outputs.gvars[fm][gv])
+        onGVarValueChange(gv, outputs.gvars[fm][gv]);
+    }
+  }
+
+  m_outputs = outputs;
+  m_resetOutputs = false;
+}
+
 void RadioOutputsWidget::onChannelOutValueChange(quint8 index, qint32 value, qint32 limit)
 {
   if (m_channelsMap.contains(index)) {
@@ -56,6 +56,7 @@ class RadioOutputsWidget : public QWidget
   protected slots:
     void saveState();
     void restoreState();
+    void onOutputsUpdated();
     void onChannelOutValueChange(quint8 index, qint32 value, qint32 limit);
     void onChannelMixValueChange(quint8 index, qint32 value, qint32 limit);
     void onVirtSwValueChange(quint8 index, qint32 value);
@@ -77,6 +78,9 @@ class RadioOutputsWidget : public QWidget
     QHash<int, QLabel *> m_logicSwitchMap;                  // m_logicSwitchMap[lsIndex] = QLabel*
     QHash<int, QHash<int, QLabel *> > m_globalVarsMap;      // m_globalVarsMap[gvarIndex][fmodeIndex] = QLabel*
 
+    SimulatorInterface::TxOutputs m_outputs;   // last displayed outputs
+    bool m_resetOutputs;
+
     int m_radioProfileId;
     int m_dataUpdateFreq;
 
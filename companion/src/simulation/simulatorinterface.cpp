@@ -24,6 +24,7 @@
 
 #include <QDebug>
 #include <QLibraryInfo>
+#include <QThread>
 
 #if defined _MSC_VER || !defined __GNUC__
   #include <windows.h>
@@ -34,6 +35,7 @@
 #endif
 
 QMap<QString, QLibrary *> SimulatorLoader::registeredSimulators;
+QMap<QString, SimulatorInterface *> SimulatorLoader::preloadedSimulators;
 
 QStringList SimulatorLoader::getAvailableSimulators()
 {
@@ -107,6 +109,10 @@ void SimulatorLoader::registerSimulators()
 
 void SimulatorLoader::unregisterSimulators()
 {
+  foreach(QString name, preloadedSimulators.keys()) {
+    delete preloadedSimulators.take(name);
+    unloadSimulator(name);
+  }
   foreach(QLibrary * lib, registeredSimulators)
     delete lib;
 }
@@ -142,6 +148,11 @@ SimulatorInterface * SimulatorLoader::loadSimulator(const QString & name)
     return si;
   }
 
+  if (preloadedSimulators.contains(libname)) {
+    qCDebug(simulatorInterfaceLoader) << "Using preloaded" << libname << "simulator";
+    return preloadedSimulators.take(libname);
+  }
+
   QLibrary * lib = registeredSimulators.value(libname, NULL);
   if (!lib) {
     qWarning() << "Simulator library is NULL";
@@ -195,3 +206,36 @@ bool SimulatorLoader::unloadSimulator(const QString & name)
 
   return ret;
 }
+
+bool SimulatorLoader::preloadSimulator(const QString & name)
+{
+  QString libname = findSimulatorByFirmwareName(name);
+  if (libname.isEmpty())
+    return false;
+  if (preloadedSimulators.contains(libname))
+    return true;
+
+  SimulatorInterface * si = loadSimulator(libname);
+  if (!si)
+    return false;
+
+  preloadedSimulators.insert(libname, si);
+  return true;
+}
+
+void SimulatorLoader::releaseSimulator(const QString & name, SimulatorInterface * simulator)
+{
+  QString libname = findSimulatorByFirmwareName(name);
+  if (!simulator)
+    return;
+
+  // only a stopped instance living in this thread can be used again
+  if (!libname.isEmpty() && !preloadedSimulators.contains(libname) && !simulator->isRunning() && simulator->thread() == QThread::currentThread()) {
+    qCDebug(simulatorInterfaceLoader) << "Keeping" << libname << "simulator instance for the next start";
+    preloadedSimulators.insert(libname, simulator);
+    return;
+  }
+
+  delete simulator;
+  unloadSimulator(name);
+}
@@ -104,10 +104,44 @@ class SimulatorInterface : public QObject
       }
     };
 
+    // snapshot of the outputs of one simulator cycle, see getOutputs()
     struct TxOutputs {
       TxOutputs() { clear(); }
       void clear() { memset(this, 0, sizeof(TxOutputs)); }
 
+      // value of an output by OutputSourceType, gvars are indexed by fm * CPN_MAX_GVARS + gv
+      qint32 value(int type, int index = 0) const
+      {
+        switch (type) {
+          case OUTPUT_SRC_CHAN_OUT:
+            return chans[index];
+          case OUTPUT_SRC_CHAN_MIX:
+            return ex_chans[index];
+          case OUTPUT_SRC_TRIM_VALUE:
+            return trims[index];
+          case OUTPUT_SRC_TRIM_RANGE:
+            return trimRange;
+          case OUTPUT_SRC_VIRTUAL_SW:
+            return vsw[index];
+          case OUTPUT_SRC_PHASE:
+            return phase;
+          case OUTPUT_SRC_GVAR:
+            return gvars[index / CPN_MAX_GVARS][index % CPN_MAX_GVARS];
+          default:
+            return 0;
+        }
+      }
+
+      // true if one of the outputs of the given type in [first, first + count) differs
+      bool changed(const TxOutputs & other, int type, int first = 0, int count = 1) const
+      {
+        for (int i = first; i < first + count; i++) {
+          if (value(type, i) != other.value(type, i))
+            return true;
+        }
+        return false;
+      }
+
       int16_t chans[CPN_MAX_CHNOUT];       // final channel outputs
       int16_t ex_chans[CPN_MAX_CHNOUT];    // raw mix outputs
       qint32 gvars[CPN_MAX_FLIGHT_MODES][CPN_MAX_GVARS];
@@ -115,6 +149,8 @@ class SimulatorInterface : public QObject
       bool vsw[CPN_MAX_LOGICAL_SWITCHES];  // virtual/logic switches
       int8_t phase;
       qint16 trimRange;                  // TRIM_MAX or TRIM_EXTENDED_MAX
+      qint32 chanLimit;                  // chans[] range, depends on the model extended limits
+      qint32 mixLimit;                   // ex_chans[] range
       // bool beep;
     };
 
@@ -127,11 +163,24 @@ class SimulatorInterface : public QObject
     virtual uint8_t getSensorInstance(uint16_t id, uint8_t defaultValue = 0) = 0;
     virtual uint16_t getSensorRatio(uint16_t id) = 0;
     virtual const int getCapability(Capability cap) = 0;
+    // converts a radio.bin or model file image (SD card radios) to the current version, returns an error message
+    virtual QString convertFile(const QByteArray & src, QByteArray & dst, bool radio = false) = 0;
+    // copies the last published outputs, returns false if they were already read;
+    // to be called from the thread receiving outputsUpdated()
+    virtual bool getOutputs(TxOutputs & outputs) = 0;
+    // compressed snapshot of the firmware RAM state (radio settings, current model, timers,
+    // telemetry, logical switches and mixer state), without the inputs; empty on error
+    virtual QByteArray saveState() = 0;
+    // restores a snapshot of the same firmware taken by saveState(), the Lua scripts are reloaded
+    virtual bool restoreState(const QByteArray & state) = 0;
 
   public slots:
 
     virtual void init() = 0;
     virtual void start(const char * filename = NULL, bool tests = true) = 0;
+    // headless mode: the firmware only runs in step(), on a virtual clock
+    virtual void startHeadless(const char * filename = NULL) = 0;
+    virtual void step(unsigned int ms) = 0;
     virtual void stop() = 0;
     virtual void setSdPath(const QString & sdPath = "", const QString & settingsPath = "") = 0;
     virtual void setVolumeGain(const int value) = 0;
@@ -158,13 +207,10 @@ class SimulatorInterface : public QObject
     void runtimeError(const QString & error);
     void lcdChange(bool backlightEnable);
     void phaseChanged(qint8 phase, const QString & name);
-    void channelOutValueChange(quint8 index, qint32 value, qint32 limit);
-    void channelMixValueChange(quint8 index, qint32 value, qint32 limit);
-    void virtualSwValueChange(quint8 index, qint32 value);
+    void outputsUpdated();  // new outputs available from getOutputs(), not repeated until they are read
     void trimValueChange(quint8 index, qint32 value);
     void trimRangeChange(quint8 index, qint32 min, qint16 max);
-    void gVarValueChange(quint8 index, qint32 value);
-    void outputValueChange(int type, quint8 index, qint32 value);
+    void audioEvent(const QString & event);
 };
 
 class SimulatorFactory {
@@ -185,12 +231,18 @@ class SimulatorLoader
     static QString findSimulatorByFirmwareName(const QString & name);
     static SimulatorInterface * loadSimulator(const QString & name);
     static bool unloadSimulator(const QString & name);
+    // warm start: one stopped instance is kept per simulator library, the next
+    // loadSimulator() returns it without loading the library again
+    static bool preloadSimulator(const QString & name);
+    // to be called instead of deleting the instance and unloadSimulator()
+    static void releaseSimulator(const QString & name, SimulatorInterface * simulator);
 
   protected:
     typedef SimulatorFactory * (*RegisterSimulator)();
 
     static int registerSimulators(const QDir & dir);
     static QMap<QString, QLibrary *> registeredSimulators;
+    static QMap<QString, SimulatorInterface *> preloadedSimulators;
 };
 
 #endif // _SIMULATORINTERFACE_H_
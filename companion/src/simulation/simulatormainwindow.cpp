@@ -36,9 +36,13 @@
 #include <QDir>
 #include <QLabel>
 #include <QMessageBox>
+#include <QTimer>
 
 extern AppData g;  // ensure what "g" means
 
+#define SIMULATOR_CHECKPOINT_PERIOD    1000  // ms
+#define SIMULATOR_CHECKPOINTS_MAX      60
+
 const quint16 SimulatorMainWindow::m_savedUiStateVersion = 2;
 
 SimulatorMainWindow::SimulatorMainWindow(QWidget *parent, const QString & firmwareId, quint8 flags, Qt::WindowFlags wflags) :
@@ -111,6 +115,9 @@ SimulatorMainWindow::SimulatorMainWindow(QWidget *parent, const QString & firmwa
   // add these to this window directly to maintain shorcuts when menubar is hidden
   addAction(ui->toolBar->toggleViewAction());
   addAction(ui->actionToggleMenuBar);
+  addAction(ui->actionRewind);
+  addAction(ui->actionSaveState);
+  addAction(ui->actionRestoreState);
 
   ui->menuView->insertSeparator(ui->actionToggleMenuBar);
   ui->menuView->insertAction(ui->actionToggleMenuBar, ui->toolBar->toggleViewAction());
@@ -138,6 +145,18 @@ SimulatorMainWindow::SimulatorMainWindow(QWidget *parent, const QString & firmwa
 
   connect(ui->actionReloadLua, &QAction::triggered, m_simulator, &SimulatorInterface::setLuaStateReloadPermanentScripts);
 
+  // the firmware state is saved periodically for rewind
+  m_checkpointTimer.setInterval(SIMULATOR_CHECKPOINT_PERIOD);
+  connect(&m_checkpointTimer, &QTimer::timeout, this, &SimulatorMainWindow::saveCheckpoint);
+  connect(this, &SimulatorMainWindow::simulatorStart, [this]() { m_checkpointTimer.start(); });
+  connect(this, &SimulatorMainWindow::simulatorRestart, [this]() {
+    m_checkpoints.clear();
+    m_checkpointTimer.start();
+  });
+  connect(ui->actionRewind, &QAction::triggered, this, &SimulatorMainWindow::rewind);
+  connect(ui->actionSaveState, &QAction::triggered, this, &SimulatorMainWindow::saveSimulatorState);
+  connect(ui->actionRestoreState, &QAction::triggered, this, &SimulatorMainWindow::restoreSimulatorState);
+
   if (m_outputsWidget) {
     connect(this, &SimulatorMainWindow::simulatorStart, m_outputsWidget, &RadioOutputsWidget::start);
     connect(this, &SimulatorMainWindow::simulatorRestart, m_outputsWidget, &RadioOutputsWidget::restart);
@@ -153,6 +172,7 @@ SimulatorMainWindow::SimulatorMainWindow(QWidget *parent, const QString & firmwa
 
 SimulatorMainWindow::~SimulatorMainWindow()
 {
+  m_checkpointTimer.stop();
   delete m_telemetryDockWidget;
   delete m_trainerDockWidget;
   delete m_outputsDockWidget;
@@ -162,15 +182,25 @@ SimulatorMainWindow::~SimulatorMainWindow()
   delete ui;
 
   if (m_simulator) {
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 4, 0))
+    // give the simulator back to this thread so it can be kept for the next start
+    QTimer::singleShot(0, m_simulator, [this]() {
+      m_simulator->moveToThread(QCoreApplication::instance()->thread());
+      simuThread.quit();
+    });
+#else
     simuThread.quit();
+#endif
     simuThread.wait();
     if (m_simuLogFile.isOpen()) {
       m_simulator->removeTracebackDevice(&m_simuLogFile);
       m_simuLogFile.close();
     }
-    delete m_simulator;
+    SimulatorLoader::releaseSimulator(m_simulatorId, m_simulator);
+  }
+  else {
+    SimulatorLoader::unloadSimulator(m_simulatorId);
   }
-  SimulatorLoader::unloadSimulator(m_simulatorId);
 }
 
 void SimulatorMainWindow::closeEvent(QCloseEvent *)
@@ -272,6 +302,49 @@ void SimulatorMainWindow::start()
   emit simulatorStart();
 }
 
+void SimulatorMainWindow::saveCheckpoint()
+{
+  if (!m_simulator->isRunning())
+    return;
+
+  QByteArray state = m_simulator->saveState();
+  if (state.isEmpty())
+    return;
+  if (m_checkpoints.size() >= SIMULATOR_CHECKPOINTS_MAX)
+    m_checkpoints.removeFirst();
+  m_checkpoints.append(state);
+}
+
+void SimulatorMainWindow::rewind()
+{
+  if (m_checkpoints.isEmpty() || !m_simulator->isRunning())
+    return;
+
+  // restart the period so the next checkpoint is taken one period after this one
+  m_checkpointTimer.start();
+  if (!m_simulator->restoreState(m_checkpoints.takeLast()))
+    qWarning() << "Simulator state could not be restored";
+}
+
+void SimulatorMainWindow::saveSimulatorState()
+{
+  if (!m_simulator->isRunning())
+    return;
+
+  m_savedSimulatorState = m_simulator->saveState();
+  ui->actionRestoreState->setEnabled(!m_savedSimulatorState.isEmpty());
+}
+
+void SimulatorMainWindow::restoreSimulatorState()
+{
+  if (m_savedSimulatorState.isEmpty() || !m_simulator->isRunning())
+    return;
+
+  m_checkpointTimer.start();
+  if (!m_simulator->restoreState(m_savedSimulatorState))
+    qWarning() << "Simulator state could not be restored";
+}
+
 void SimulatorMainWindow::createDockWidgets()
 {
   if (!m_outputsDockWidget) {
@@ -25,8 +25,10 @@
 
 #include <QDockWidget>
 #include <QFile>
+#include <QList>
 #include <QMainWindow>
 #include <QThread>
+#include <QTimer>
 
 class DebugOutput;
 class RadioData;
@@ -81,6 +83,10 @@ class SimulatorMainWindow : public QMainWindow
     void toggleRadioDocked(bool dock);
     void openJoystickDialog(bool);
     void showHelp(bool show);
+    void saveCheckpoint();
+    void rewind();
+    void saveSimulatorState();
+    void restoreSimulatorState();
 
   protected:
     void createDockWidgets();
@@ -100,6 +106,9 @@ class SimulatorMainWindow : public QMainWindow
     QDockWidget * m_outputsDockWidget;
 
     QThread simuThread;
+    QTimer m_checkpointTimer;
+    QList<QByteArray> m_checkpoints;  // firmware states for rewind, the last one is the most recent
+    QByteArray m_savedSimulatorState;
     QFile m_simuLogFile;
     QVector<keymapHelp_t> m_keymapHelp;
     QString m_simulatorId;
@@ -0,0 +1,399 @@
+/*
+ * Copyright (C) OpenTX
+ *
+ * Based on code named
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+
+#include "simulatorrunner.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFileInfo>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <algorithm>
+
+#define RUNNER_STEP_MS               10
+#define RUNNER_CHECKPOINT_MAGIC      0x4358544F  // "OTXC"
+#define RUNNER_CHECKPOINT_VERSION    1
+
+SimulatorRunner::SimulatorRunner(SimulatorInterface * simulator, QObject * parent):
+  QObject(parent),
+  simulator(simulator),
+  m_time(0),
+  outputsInterval(10),
+  lcdSize(0),
+  checkpointsInterval(0),
+  startTime(0)
+{
+  connect(simulator, &SimulatorInterface::outputsUpdated, this, &SimulatorRunner::onOutputsUpdated);
+  connect(simulator, &SimulatorInterface::lcdChange, this, &SimulatorRunner::onLcdChange);
+  connect(simulator, &SimulatorInterface::audioEvent, this, &SimulatorRunner::onAudioEvent);
+}
+
+SimulatorRunner::~SimulatorRunner()
+{
+  outputsStream.flush();
+  audioStream.flush();
+}
+
+bool SimulatorRunner::parseLine(const QString & line, Event & event)
+{
+  static const QStringList commands = QStringList() << "" << "analog" << "stick" << "knob" << "slider" << "txvin"
+                                                    << "switch" << "trimsw" << "trim" << "key" << "rotenc" << "trainer";
+
+  QStringList fields = line.split(QRegExp("\\s+"), QString::SkipEmptyParts);
+  bool ok = (fields.size() >= 2);
+  if (ok)
+    event.time = fields.at(0).toUInt(&ok);
+  if (!ok)
+    return false;
+
+  const QString command = fields.at(1).toLower();
+  event.index = 0;
+  event.value = 0;
+  if (command == "end") {
+    event.type = EVENT_END;
+    return fields.size() == 2;
+  }
+  if (command == "telemetry") {
+    event.type = EVENT_TELEMETRY;
+    event.data = QByteArray::fromHex(fields.mid(2).join("").toLatin1());
+    return !event.data.isEmpty();
+  }
+
+  event.type = commands.indexOf(command);
+  if (event.type <= SimulatorInterface::INPUT_SRC_NONE || fields.size() != 4)
+    return false;
+  event.index = fields.at(2).toInt(&ok);
+  if (ok)
+    event.value = fields.at(3).toInt(&ok);
+  return ok;
+}
+
+bool SimulatorRunner::loadScript(const QString & filename)
+{
+  QFile file(filename);
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    m_error = tr("Error opening file %1:\n%2.").arg(filename).arg(file.errorString());
+    return false;
+  }
+
+  events.clear();
+  QTextStream stream(&file);
+  for (int lineNumber=1; !stream.atEnd(); lineNumber++) {
+    QString line = stream.readLine().trimmed();
+    if (line.isEmpty() || line.startsWith('#'))
+      continue;
+    Event event;
+    if (!parseLine(line, event)) {
+      m_error = tr("%1:%2: invalid event \"%3\"").arg(filename).arg(lineNumber).arg(line);
+      return false;
+    }
+    events.append(event);
+  }
+
+  // recordings may be concatenated, events at the same time keep their order
+  std::stable_sort(events.begin(), events.end(), [](const Event & a, const Event & b) {
+    return a.time < b.time;
+  });
+  return true;
+}
+
+bool SimulatorRunner::openCapture(QFile & file, const QString & filename)
+{
+  file.setFileName(filename);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    m_error = tr("Error writing file %1:\n%2.").arg(filename).arg(file.errorString());
+    return false;
+  }
+  return true;
+}
+
+bool SimulatorRunner::captureOutputs(const QString & filename, unsigned int sampleInterval)
+{
+  if (!openCapture(outputsFile, filename))
+    return false;
+
+  outputsInterval = qMax(1u, sampleInterval);
+  outputsStream.setDevice(&outputsFile);
+  outputsStream << "time";
+  for (int i=0; i<CPN_MAX_CHNOUT; i++) {
+    outputsStream << ",CH" << i + 1;
+  }
+  outputsStream << endl;
+  return true;
+}
+
+bool SimulatorRunner::captureLcd(const QString & filename, int width, int height, int depth)
+{
+  if (!openCapture(lcdFile, filename))
+    return false;
+
+  if (depth >= 8)
+    lcdSize = width * height * ((depth + 7) / 8);
+  else
+    lcdSize = width * ((height + 7) / 8) * depth;
+
+  // header: width, height and depth, then one record per frame:
+  // time (ms), size, then the LCD buffer as returned by getLcd()
+  QDataStream stream(&lcdFile);
+  stream.setByteOrder(QDataStream::LittleEndian);
+  stream << (quint16)width << (quint16)height << (quint16)depth;
+  return true;
+}
+
+bool SimulatorRunner::captureAudio(const QString & filename)
+{
+  if (!openCapture(audioFile, filename))
+    return false;
+
+  audioStream.setDevice(&audioFile);
+  return true;
+}
+
+bool SimulatorRunner::saveCheckpoints(const QString & folder, unsigned int interval)
+{
+  if (!QDir().mkpath(folder)) {
+    m_error = tr("Error creating folder %1.").arg(folder);
+    return false;
+  }
+  checkpointsFolder = folder;
+  checkpointsInterval = qMax(1u, interval);
+  return true;
+}
+
+// checkpoint file: magic, version, simulator name, time (ms) and the firmware state
+bool SimulatorRunner::startFromCheckpoint(const QString & filename)
+{
+  QFile file(filename);
+  if (!file.open(QIODevice::ReadOnly)) {
+    m_error = tr("Error opening file %1:\n%2.").arg(filename).arg(file.errorString());
+    return false;
+  }
+
+  QDataStream stream(&file);
+  stream.setByteOrder(QDataStream::LittleEndian);
+  quint32 magic, time;
+  quint16 version;
+  QString name;
+  stream >> magic >> version >> name >> time >> startState;
+  if (stream.status() != QDataStream::Ok || magic != RUNNER_CHECKPOINT_MAGIC || version != RUNNER_CHECKPOINT_VERSION) {
+    m_error = tr("%1 is not a checkpoint file.").arg(filename);
+    return false;
+  }
+  if (name != simulator->name()) {
+    m_error = tr("Checkpoint %1 was saved by the %2 simulator.").arg(filename).arg(name);
+    return false;
+  }
+  startTime = time;
+  return true;
+}
+
+bool SimulatorRunner::writeCheckpoint()
+{
+  QByteArray state = simulator->saveState();
+  QFile file(QDir(checkpointsFolder).filePath(QString("%1.state").arg(m_time, 10, 10, QChar('0'))));
+  if (state.isEmpty() || !file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    m_error = tr("Error writing checkpoint %1:\n%2.").arg(file.fileName()).arg(file.errorString());
+    return false;
+  }
+
+  QDataStream stream(&file);
+  stream.setByteOrder(QDataStream::LittleEndian);
+  stream << (quint32)RUNNER_CHECKPOINT_MAGIC << (quint16)RUNNER_CHECKPOINT_VERSION << simulator->name() << (quint32)m_time << state;
+  return stream.status() == QDataStream::Ok;
+}
+
+void SimulatorRunner::onOutputsUpdated()
+{
+  simulator->getOutputs(outputs);
+}
+
+void SimulatorRunner::onLcdChange(bool backlightEnable)
+{
+  Q_UNUSED(backlightEnable);
+  if (!lcdFile.isOpen() || !lcdSize)
+    return;
+
+  QDataStream stream(&lcdFile);
+  stream.setByteOrder(QDataStream::LittleEndian);
+  stream << (quint32)m_time << (quint32)lcdSize;
+  stream.writeRawData((const char *)simulator->getLcd(), lcdSize);
+}
+
+void SimulatorRunner::onAudioEvent(const QString & event)
+{
+  if (audioFile.isOpen())
+    audioStream << m_time << " " << event << endl;
+}
+
+void SimulatorRunner::writeOutputs()
+{
+  outputsStream << m_time;
+  for (int i=0; i<CPN_MAX_CHNOUT; i++) {
+    outputsStream << "," << outputs.chans[i];
+  }
+  outputsStream << "\n";
+}
+
+static bool copyFolder(const QString & source, const QString & destination)
+{
+  QDir dir(source);
+  if (!dir.exists())
+    return true;
+  if (!QDir().mkpath(destination))
+    return false;
+
+  foreach (const QFileInfo & info, dir.entryInfoList(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot)) {
+    const QString target = QDir(destination).filePath(info.fileName());
+    if (info.isDir() ? !copyFolder(info.filePath(), target) : !QFile::copy(info.filePath(), target))
+      return false;
+  }
+  return true;
+}
+
+// the firmware writes to its storage (storageCheck(), models cache, ...), the
+// eeprom file or the radio settings and models are copied into folder
+bool SimulatorRunner::copyData(const QString & sdPath, const QString & data, const QString & folder, QByteArray & eepromFile)
+{
+  if (QFileInfo(data).isFile()) {
+    const QString copy = QDir(folder).filePath(QFileInfo(data).fileName());
+    if (!QFile::copy(data, copy)) {
+      m_error = tr("Error copying %1 to %2.").arg(data).arg(folder);
+      return false;
+    }
+    eepromFile = QFile::encodeName(copy);
+    simulator->setSdPath(sdPath, QString());
+    return true;
+  }
+
+  const QString settingsPath = data.isEmpty() ? sdPath : data;
+  if (!copyFolder(QDir(settingsPath).filePath("RADIO"), QDir(folder).filePath("RADIO")) ||
+      !copyFolder(QDir(settingsPath).filePath("MODELS"), QDir(folder).filePath("MODELS"))) {
+    m_error = tr("Error copying the radio settings and models of %1 to %2.").arg(settingsPath).arg(folder);
+    return false;
+  }
+  eepromFile.clear();
+  simulator->setSdPath(sdPath, folder);
+  return true;
+}
+
+bool SimulatorRunner::run(const QString & sdPath, const QString & data, unsigned int duration)
+{
+  QTemporaryDir folder(QDir::tempPath() + "/otx-run-XXXXXX");
+  if (!folder.isValid()) {
+    m_error = tr("Error creating a temporary folder.");
+    return false;
+  }
+
+  // the eeprom file name must stay valid while the simulator runs, without
+  // a file the eeprom of radios which have one is only in memory
+  QByteArray eepromFile;
+  if (!copyData(sdPath, data, folder.path(), eepromFile))
+    return false;
+
+  simulator->init();
+  // the inputs at time 0 are the positions at power on, seen by the startup checks
+  for (int i=0; i < events.size() && events.at(i).time == 0; i++) {
+    const Event & event = events.at(i);
+    if (event.type < EVENT_TELEMETRY)
+      simulator->setInputValue(event.type, event.index, event.value);
+  }
+  simulator->startHeadless(eepromFile.isEmpty() ? nullptr : eepromFile.constData());
+  if (!simulator->isRunning()) {
+    m_error = tr("Simulator could not be started");
+    return false;
+  }
+
+  bool result = true;
+  int next = 0;
+  m_time = 0;
+
+  if (!startState.isEmpty()) {
+    if (!simulator->restoreState(startState)) {
+      m_error = tr("The checkpoint could not be restored");
+      simulator->stop();
+      return false;
+    }
+    m_time = startTime;
+    // the inputs are not in the state, the events before the checkpoint set them
+    // again; but the trims are in the model data and the telemetry in the state
+    for (; next < events.size() && events.at(next).time < m_time; next++) {
+      const Event & event = events.at(next);
+      if (event.type < EVENT_TELEMETRY && event.type != SimulatorInterface::INPUT_SRC_TRIM)
+        simulator->setInputValue(event.type, event.index, event.value);
+    }
+  }
+
+  unsigned int nextSample = m_time;
+  unsigned int nextCheckpoint = m_time;
+
+  while (m_time < duration) {
+    if (checkpointsInterval && m_time >= nextCheckpoint) {
+      if (!writeCheckpoint()) {
+        result = false;
+        break;
+      }
+      nextCheckpoint += checkpointsInterval;
+    }
+
+    for (; next < events.size() && events.at(next).time <= m_time; next++) {
+      const Event & event = events.at(next);
+      if (event.type == EVENT_END)
+        duration = m_time;
+      else if (event.type == EVENT_TELEMETRY)
+        simulator->sendTelemetry(event.data);
+      else
+        simulator->setInputValue(event.type, event.index, event.value);
+    }
+    if (m_time >= duration)
+      break;
+
+    if (outputsFile.isOpen() && m_time >= nextSample) {
+      writeOutputs();
+      nextSample += outputsInterval;
+    }
+
+    // stop on the next event, sample or end of the run
+    unsigned int ms = qMin<unsigned int>(RUNNER_STEP_MS, duration - m_time);
+    if (next < events.size())
+      ms = qMin(ms, events.at(next).time - m_time);
+    if (outputsFile.isOpen())
+      ms = qMin(ms, nextSample - m_time);
+    if (checkpointsInterval)
+      ms = qMin(ms, nextCheckpoint - m_time);
+
+    simulator->step(ms);
+    m_time += ms;
+
+    if (!simulator->isRunning()) {
+      m_error = tr("Simulator stopped at %1ms").arg(m_time);
+      result = false;
+      break;
+    }
+  }
+
+  if (outputsFile.isOpen())
+    writeOutputs();
+
+  simulator->stop();
+  outputsStream.flush();
+  audioStream.flush();
+  return result;
+}
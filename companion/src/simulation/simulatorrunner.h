@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) OpenTX
+ *
+ * Based on code named
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+
+#ifndef _SIMULATORRUNNER_H_
+#define _SIMULATORRUNNER_H_
+
+#include "simulatorinterface.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QTextStream>
+
+// Runs a simulator without GUI and faster than real time: the firmware is
+// stepped on a virtual clock, its inputs come from a script and its outputs
+// (channels, LCD frames, audio events) are captured to files.
+//
+// The script (or a recording, same format) has one event per line:
+//   <time ms> <command> [<index> <value>]
+// with the commands analog, stick, knob, slider, txvin, switch, trimsw,
+// trim, key, trainer (index and value as in SimulatorInterface::setInputValue),
+// telemetry <hex bytes> and end. Empty lines and lines starting with # are ignored.
+//
+// The firmware state can be saved to checkpoint files during a run, and a later
+// run can start (rewind) from one of them instead of power on: the script events
+// before the checkpoint only set the inputs, as they are not part of the state.
+class SimulatorRunner : public QObject
+{
+  Q_OBJECT
+
+  public:
+
+    SimulatorRunner(SimulatorInterface * simulator, QObject * parent = nullptr);
+    virtual ~SimulatorRunner();
+
+    bool loadScript(const QString & filename);
+    bool captureOutputs(const QString & filename, unsigned int sampleInterval = 10);
+    bool captureLcd(const QString & filename, int width, int height, int depth);
+    bool captureAudio(const QString & filename);
+    // checkpoints are written every interval ms of the run, as <time>.state files
+    bool saveCheckpoints(const QString & folder, unsigned int interval);
+    bool startFromCheckpoint(const QString & filename);
+
+    // data is the eeprom file, or the folder of the radio settings and models
+    // on radios with SD card storage (the SD card itself when empty); the run
+    // works on a temporary copy of it and ends at duration (ms) or at the end
+    // event of the script
+    bool run(const QString & sdPath, const QString & data, unsigned int duration);
+
+    unsigned int time() const { return m_time; }
+    QString errorString() const { return m_error; }
+
+  protected slots:
+
+    void onOutputsUpdated();
+    void onLcdChange(bool backlightEnable);
+    void onAudioEvent(const QString & event);
+
+  protected:
+
+    struct Event {
+      unsigned int time;
+      int type;         // SimulatorInterface::InputSourceType, or an EVENT_* below
+      int index;
+      int value;
+      QByteArray data;
+    };
+
+    enum EventType {
+      EVENT_TELEMETRY = 1000,
+      EVENT_END
+    };
+
+    bool parseLine(const QString & line, Event & event);
+    bool copyData(const QString & sdPath, const QString & data, const QString & folder, QByteArray & eepromFile);
+    bool openCapture(QFile & file, const QString & filename);
+    void writeOutputs();
+    bool writeCheckpoint();
+
+    SimulatorInterface * simulator;
+    QList<Event> events;
+    unsigned int m_time;
+    QString m_error;
+
+    QFile outputsFile;
+    QTextStream outputsStream;
+    unsigned int outputsInterval;
+    SimulatorInterface::TxOutputs outputs;
+
+    QFile lcdFile;
+    int lcdSize;
+
+    QFile audioFile;
+    QTextStream audioStream;
+
+    QString checkpointsFolder;
+    unsigned int checkpointsInterval;
+    QByteArray startState;
+    unsigned int startTime;
+};
+
+#endif // _SIMULATORRUNNER_H_
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) OpenTX
+ *
+ * Based on code named
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+
+#ifndef _TRIPLEBUFFER_H_
+#define _TRIPLEBUFFER_H_
+
+#include <atomic>
+#include <stdint.h>
+
+// Lock-free triple buffer for one producer and one consumer thread: the
+// producer fills writeBuffer() and publishes it, the consumer gets the most
+// recently published buffer with update() / readBuffer(). Neither side waits,
+// intermediate buffers are dropped when the consumer is slower.
+template <class T>
+class TripleBuffer
+{
+  public:
+
+    TripleBuffer():
+      writeIndex(0),
+      readIndex(1),
+      middle(2)
+    {
+    }
+
+    T & writeBuffer()
+    {
+      return buffers[writeIndex];
+    }
+
+    void publish()
+    {
+      writeIndex = middle.exchange(writeIndex | FRESH) & INDEX_MASK;
+    }
+
+    // returns false when nothing was published since the previous call
+    bool update()
+    {
+      if (!(middle.load() & FRESH))
+        return false;
+      readIndex = middle.exchange(readIndex) & INDEX_MASK;
+      return true;
+    }
+
+    const T & readBuffer() const
+    {
+      return buffers[readIndex];
+    }
+
+  protected:
+
+    enum {
+      INDEX_MASK = 0x03,
+      FRESH = 0x04
+    };
+
+    T buffers[3];
+    uint8_t writeIndex;        // only used by the producer
+    uint8_t readIndex;         // only used by the consumer
+    std::atomic<uint8_t> middle;
+};
+
+#endif // _TRIPLEBUFFER_H_
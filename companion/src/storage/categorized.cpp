@@ -21,6 +21,39 @@
 #include "categorized.h"
 #include "firmwares/opentx/opentxinterface.h"
 
+#include <QRunnable>
+#include <QThreadPool>
+#include <functional>
+
+// The models are independent once the radio settings are known: they are
+// decoded / encoded by a pool of threads, while the files are extracted and
+// written sequentially, in the models order, by the storage format.
+class CategorizedStorageTask : public QRunnable
+{
+  public:
+    CategorizedStorageTask(const std::function<void()> & function):
+      function(function)
+    {
+    }
+
+    virtual void run()
+    {
+      function();
+    }
+
+  protected:
+    std::function<void()> function;
+};
+
+static void runTasks(int count, const std::function<void(int)> & function)
+{
+  QThreadPool pool;
+  for (int i=0; i<count; i++) {
+    pool.start(new CategorizedStorageTask(std::bind(function, i)));
+  }
+  pool.waitForDone();
+}
+
 bool CategorizedStorageFormat::load(RadioData & radioData)
 {
   QByteArray radioSettingsBuffer;
@@ -45,6 +78,7 @@ bool CategorizedStorageFormat::load(RadioData & radioData)
   QList<QByteArray> lines = modelsListBuffer.split('\n');
   int modelIndex = 0;
   int categoryIndex = -1;
+  QList<ModelJob> jobs;
   foreach (const QByteArray & lineArray, lines) {
     QString line = QString(lineArray).trimmed();
     if (line.isEmpty()) continue;
@@ -80,27 +114,15 @@ bool CategorizedStorageFormat::load(RadioData & radioData)
       // parse model file name and load
       QString fileName = parts[0];
       qDebug() << "Loading model from file" << fileName << "into slot" << modelIndex;
-      QByteArray modelBuffer;
-      if (!loadFile(modelBuffer, QString("MODELS/%1").arg(fileName))) {
+      ModelJob job = {modelIndex, categoryIndex, fileName, QByteArray()};
+      if (!loadFile(job.buffer, QString("MODELS/%1").arg(fileName))) {
         setError(tr("Can't extract %1").arg(fileName));
         return false;
       }
       if ((int)radioData.models.size() <= modelIndex) {
         radioData.models.resize(modelIndex + 1);
       }
-      if (!loadModelFromByteArray(radioData.models[modelIndex], modelBuffer)) {
-        setError(tr("Error loading models"));
-        return false;
-      }
-      strncpy(radioData.models[modelIndex].filename, qPrintable(fileName), sizeof(radioData.models[modelIndex].filename));
-      if (IS_HORUS(board) && !strcmp(radioData.generalSettings.currModelFilename, qPrintable(fileName))) {
-        radioData.generalSettings.currModelIndex = modelIndex;
-        qDebug() << "currModelIndex =" << modelIndex;
-      }
-      if (getCurrentFirmware()->getCapability(HasModelCategories)) {
-        radioData.models[modelIndex].category = categoryIndex;
-      }
-      radioData.models[modelIndex].used = true;
+      jobs.append(job);
       modelIndex++;
       continue;
     }
@@ -110,6 +132,48 @@ bool CategorizedStorageFormat::load(RadioData & radioData)
     qDebug() << "Invalid line" <<line;
     continue;
   }
+
+  // each job decodes into its own model slot
+  std::vector<char> loaded(jobs.size());
+  runTasks(jobs.size(), [&](int i) {
+    loaded[i] = (loadModelFromByteArray(radioData.models[jobs.at(i).modelIndex], jobs.at(i).buffer) != nullptr);
+  });
+
+  radioData.modelErrors.clear();
+  QStringList errors;
+  for (int i=0; i<jobs.size(); i++) {
+    const ModelJob & job = jobs[i];
+    ModelData & model = radioData.models[job.modelIndex];
+    if (!loaded[i]) {
+      // the file is kept to be written back as is
+      model.clear();
+      ModelErrorData & error = radioData.modelErrors[job.modelIndex];
+      error.filename = job.fileName;
+      error.category = job.categoryIndex;
+      error.data = job.buffer;
+      error.error = tr("Error loading model %1").arg(job.fileName);
+      errors.append(error.error);
+      continue;
+    }
+    strncpy(model.filename, qPrintable(job.fileName), sizeof(model.filename));
+    if (IS_HORUS(board) && !strcmp(radioData.generalSettings.currModelFilename, qPrintable(job.fileName))) {
+      radioData.generalSettings.currModelIndex = job.modelIndex;
+      qDebug() << "currModelIndex =" << job.modelIndex;
+    }
+    if (getCurrentFirmware()->getCapability(HasModelCategories)) {
+      model.category = job.categoryIndex;
+    }
+    model.used = true;
+  }
+
+  if (!radioData.modelErrors.isEmpty()) {
+    if (radioData.modelErrors.size() == jobs.size()) {
+      setError(tr("Error loading models"));
+      return false;
+    }
+    setWarning(errors.join("\n"));
+  }
+
   return true;
 }
 
@@ -126,14 +190,15 @@ bool CategorizedStorageFormat::write(const RadioData & radioData)
     return false;
   }
 
-  for (size_t m=0; m<numModels; m++) {
-    const ModelData & model = radioData.models[m];
-    if (model.isEmpty()) continue;
+  // the models are encoded in parallel, then written in their order
+  std::vector<QByteArray> modelsData(numModels);
+  runTasks(numModels, [&](int m) {
+    if (!radioData.models[m].isEmpty())
+      writeModelToByteArray(radioData.models[m], modelsData[m]);
+  });
 
-    QString modelFilename = QString("MODELS/%1").arg(model.filename);
-    QByteArray modelData;
-    writeModelToByteArray(model, modelData);
-    if (!writeFile(modelData, modelFilename)) {
+  auto addModel = [&](size_t m, const QByteArray & data, const QString & filename, unsigned category) -> bool {
+    if (!writeFile(data, QString("MODELS/%1").arg(filename))) {
       return false;
     }
 
@@ -145,9 +210,33 @@ bool CategorizedStorageFormat::write(const RadioData & radioData)
     if (!getCurrentFirmware()->getCapability(HasModelCategories)) {
       // Use format with model number and file name. This is needed because
       // radios without category support can have unused model slots
-      modelsList.append(QString("%1 %2\n").arg(m).arg(model.filename));
+      modelsList.append(QString("%1 %2\n").arg(m).arg(filename));
     } else {
-      sortedModels[model.category].push_back(QString("%1\n").arg(model.filename));
+      sortedModels[category].push_back(QString("%1\n").arg(filename));
+    }
+    return true;
+  };
+
+  size_t numSlots = numModels;
+  if (!radioData.modelErrors.isEmpty()) {
+    numSlots = qMax<size_t>(numSlots, radioData.modelErrors.lastKey() + 1);
+  }
+
+  for (size_t m=0; m<numSlots; m++) {
+    if (m < numModels && !radioData.models[m].isEmpty()) {
+      const ModelData & model = radioData.models[m];
+      if (!addModel(m, modelsData[m], model.filename, model.category)) {
+        return false;
+      }
+    }
+
+    // a model which could not be loaded is written back unchanged
+    auto error = radioData.modelErrors.find((int)m);
+    if (error != radioData.modelErrors.end()) {
+      unsigned category = (error->category >= 0 && error->category < (int)numCategories ? error->category : 0);
+      if (!addModel(m, error->data, error->filename, category)) {
+        return false;
+      }
     }
   }
 
@@ -39,6 +39,13 @@ class CategorizedStorageFormat : public StorageFormat
     virtual bool write(const RadioData & radioData);
 
   protected:
+    struct ModelJob {
+      int modelIndex;
+      int categoryIndex;
+      QString fileName;
+      QByteArray buffer;
+    };
+
     virtual bool loadFile(QByteArray & fileData, const QString & fileName) = 0;
     virtual bool writeFile(const QByteArray & fileData, const QString & fileName) = 0;
 };
@@ -0,0 +1,47 @@
+#include "gtests.h"
+#include "location.h"
+#include "storage/otx.h"
+#include "storage/sdcard.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+
+// a model which can't be loaded is kept in the library when it is saved
+TEST(CategorizedStorage, CorruptedModelKept)
+{
+  RadioData radio;
+  OtxFormat source(RADIO_TESTS_PATH "/model_22_x10.otx");
+  ASSERT_TRUE(source.load(radio));
+  ASSERT_FALSE(radio.models[0].isEmpty());
+
+  radio.models[1] = radio.models[0];
+  strcpy(radio.models[1].filename, "model2.bin");
+
+  QTemporaryDir folder;
+  ASSERT_TRUE(folder.isValid());
+  ASSERT_TRUE(SdcardFormat(folder.path()).write(radio));
+
+  const QByteArray corrupted("not a model");
+  QFile file(QDir(folder.path()).filePath("MODELS/model2.bin"));
+  ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+  file.write(corrupted);
+  file.close();
+
+  RadioData loaded;
+  ASSERT_TRUE(SdcardFormat(folder.path()).load(loaded));
+  ASSERT_EQ(1, loaded.modelErrors.size());
+  EXPECT_TRUE(loaded.models[1].isEmpty());
+  EXPECT_EQ(corrupted, loaded.modelErrors[1].data);
+
+  // saved to an archive, then loaded again
+  const QString archive = QDir(folder.path()).filePath("library.otx");
+  ASSERT_TRUE(OtxFormat(archive).write(loaded));
+
+  RadioData reloaded;
+  ASSERT_TRUE(OtxFormat(archive).load(reloaded));
+  EXPECT_STREQ(radio.models[0].name, reloaded.models[0].name);
+  ASSERT_EQ(1, reloaded.modelErrors.size());
+  EXPECT_EQ(QString("model2.bin"), reloaded.modelErrors[1].filename);
+  EXPECT_EQ(corrupted, reloaded.modelErrors[1].data);
+}
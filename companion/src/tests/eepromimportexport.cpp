@@ -0,0 +1,342 @@
+#include "gtests.h"
+#include "firmwares/eepromimportexport.h"
+
+#include <QBitArray>
+#include <random>
+
+// the per-bit QBitArray implementation the BitWriter / BitReader replaced,
+// kept as the reference of the layout
+namespace reference {
+
+void appendBits(QBitArray & output, const QBitArray & bits)
+{
+  int offset = output.size();
+  output.resize(offset + bits.size());
+  for (int i=0; i<bits.size(); i++)
+    output[offset + i] = bits[i];
+}
+
+QBitArray unsignedBits(unsigned int value, int N)
+{
+  QBitArray output(N);
+  for (int i=0; i<N; i++) {
+    if (value & ((unsigned int)1<<i))
+      output.setBit(i);
+  }
+  return output;
+}
+
+QBitArray signedBits(int value, int N)
+{
+  QBitArray output(N);
+  for (int i=0; i<N; i++) {
+    if (((unsigned int)value) & (1u<<i))
+      output.setBit(i);
+  }
+  return output;
+}
+
+QBitArray boolBits(bool value, int N)
+{
+  QBitArray output(N);
+  if (value)
+    output.setBit(0);
+  return output;
+}
+
+QBitArray charBits(const char * field, int N, bool truncate)
+{
+  QBitArray output(N*8);
+  int b = 0;
+  int len = truncate ? strlen(field) : N;
+  for (int i=0; i<N; i++) {
+    int idx = (i>=len ? 0 : field[i]);
+    for (int j=0; j<8; j++, b++) {
+      if (idx & (1<<j))
+        output.setBit(b);
+    }
+  }
+  return output;
+}
+
+QBitArray zcharBits(const char * field, int N)
+{
+  QBitArray output(N*8);
+  int b = 0;
+  int len = strlen(field);
+  for (int i=0; i<N; i++) {
+    int idx = i>=len ? 0 : char2zchar(field[i]);
+    for (int j=0; j<8; j++, b++) {
+      if (idx & (1<<j))
+        output.setBit(b);
+    }
+  }
+  return output;
+}
+
+unsigned int readUnsigned(const QBitArray & input, int & offset, int N)
+{
+  unsigned int value = 0;
+  for (int i=0; i<N; i++) {
+    if (input[offset++])
+      value |= ((unsigned int)1<<i);
+  }
+  return value;
+}
+
+int readSigned(const QBitArray & input, int & offset, int N)
+{
+  unsigned int value = readUnsigned(input, offset, N);
+  if (input[offset-1]) {
+    for (unsigned int i=N; i<8*sizeof(int); i++)
+      value |= (1u<<i);
+  }
+  return (int)value;
+}
+
+QByteArray bitsToBytes(const QBitArray & bits)
+{
+  QByteArray bytes((bits.count()+7)/8, 0);
+  for (int b=0; b<bits.count(); ++b)
+    bytes[b/8] = (bytes.at(b/8) | ((bits[b]?1:0)<<(b%8)));
+  return bytes;
+}
+
+QBitArray bytesToBits(const QByteArray & bytes)
+{
+  QBitArray bits(bytes.count()*8);
+  for (int i=0; i<bytes.count(); ++i)
+    for (int b=0; b<8; ++b)
+      bits.setBit(i*8+b, bytes.at(i)&(1<<b));
+  return bits;
+}
+
+}  // namespace reference
+
+static int exportMinus2(int value)
+{
+  return value - 2;
+}
+
+static int importPlus2(int value)
+{
+  return value + 2;
+}
+
+struct FieldsData {
+  unsigned int u3;
+  int s5;
+  bool b1;
+  unsigned int u13;
+  bool b3;
+  char chars[5];
+  char name[6];
+  int s16;
+  unsigned int u32;
+  int s32;
+  int converted;
+  unsigned int selector;
+  unsigned int unionU7;
+  int unionS20;
+  char fixed[3];
+  unsigned int nested;
+};
+
+class UnsignedMember: public UnionField<unsigned int>::UnionMember, public UnsignedField<7> {
+  public:
+    UnsignedMember(DataField * parent, unsigned int & field):
+      UnsignedField<7>(parent, field)
+    {
+    }
+
+    bool select(const unsigned int & attr) const override
+    {
+      return attr == 0;
+    }
+
+    DataField * getField() override
+    {
+      return this;
+    }
+};
+
+class SignedMember: public UnionField<unsigned int>::UnionMember, public SignedField<20> {
+  public:
+    SignedMember(DataField * parent, int & field):
+      SignedField<20>(parent, field)
+    {
+    }
+
+    bool select(const unsigned int & attr) const override
+    {
+      return true;
+    }
+
+    DataField * getField() override
+    {
+      return this;
+    }
+};
+
+// one field of each type, most of them not byte aligned
+class AllFields: public StructField {
+  public:
+    explicit AllFields(FieldsData & data):
+      StructField(nullptr, "AllFields")
+    {
+      Append(new UnsignedField<3>(this, data.u3));
+      Append(new SignedField<5>(this, data.s5));
+      Append(new BoolField<1>(this, data.b1));
+      Append(new UnsignedField<13>(this, data.u13));
+      Append(new BoolField<3>(this, data.b3));
+      Append(new CharField<4>(this, data.chars));
+      Append(new ZCharField<5>(this, data.name));
+      Append(new SpareBitsField<6>(this));
+      Append(new SignedField<16>(this, data.s16));
+      Append(new UnsignedField<32>(this, data.u32));
+      Append(new SignedField<32>(this, data.s32));
+      Append(new ConversionField<SignedField<6>>(this, data.converted, exportMinus2, importPlus2));
+      Append(new UnsignedField<1>(this, data.selector));
+      UnionField<unsigned int> * unionField = new UnionField<unsigned int>(this, data.selector);
+      unionField->Append(new UnsignedMember(this, data.unionU7));
+      unionField->Append(new SignedMember(this, data.unionS20));
+      Append(unionField);
+      Append(new CharField<3>(this, data.fixed, false));
+      StructField * nested = new StructField(this, "Nested");
+      nested->Append(new UnsignedField<9>(this, data.nested));
+      nested->Append(new SpareBitsField<2>(this));
+      Append(nested);
+    }
+};
+
+static QBitArray referenceBits(const FieldsData & data)
+{
+  using namespace reference;
+  QBitArray bits;
+  appendBits(bits, unsignedBits(data.u3, 3));
+  appendBits(bits, signedBits(data.s5, 5));
+  appendBits(bits, boolBits(data.b1, 1));
+  appendBits(bits, unsignedBits(data.u13, 13));
+  appendBits(bits, boolBits(data.b3, 3));
+  appendBits(bits, charBits(data.chars, 4, true));
+  appendBits(bits, zcharBits(data.name, 5));
+  appendBits(bits, unsignedBits(0, 6));
+  appendBits(bits, signedBits(data.s16, 16));
+  appendBits(bits, unsignedBits(data.u32, 32));
+  appendBits(bits, signedBits(data.s32, 32));
+  appendBits(bits, signedBits(exportMinus2(data.converted), 6));
+  appendBits(bits, unsignedBits(data.selector, 1));
+  QBitArray unionBits = (data.selector == 0 ? unsignedBits(data.unionU7, 7) : signedBits(data.unionS20, 20));
+  unionBits.resize(20);
+  appendBits(bits, unionBits);
+  appendBits(bits, charBits(data.fixed, 3, false));
+  appendBits(bits, unsignedBits(data.nested, 9));
+  appendBits(bits, unsignedBits(0, 2));
+  return bits;
+}
+
+static void randomData(std::mt19937 & random, FieldsData & data)
+{
+  static const char zchars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789_-,.";
+  memset(&data, 0, sizeof(data));
+  data.u3 = random() & 0x07;
+  data.s5 = (int)(random() & 0x1F) - 16;
+  data.b1 = random() & 1;
+  data.u13 = random() & 0x1FFF;
+  data.b3 = random() & 1;
+  int len = random() % 5;
+  for (int i=0; i<len; i++)
+    data.chars[i] = 'a' + random() % 26;
+  len = random() % 6;
+  for (int i=0; i<len; i++)
+    data.name[i] = zchars[random() % (sizeof(zchars) - 1)];
+  data.s16 = (int)(random() & 0xFFFF) - 32768;
+  data.u32 = random();
+  data.s32 = (int)random();
+  data.converted = (int)(random() & 0x3F) - 32 + 2;
+  data.selector = random() & 1;
+  data.unionU7 = random() & 0x7F;
+  data.unionS20 = (int)(random() & 0xFFFFF) - 0x80000;
+  for (int i=0; i<3; i++)
+    data.fixed[i] = random() & 0xFF;
+  data.nested = random() & 0x1FF;
+}
+
+TEST(EepromImportExport, exportMatchesPerBitReference)
+{
+  std::mt19937 random(42);
+  for (int i=0; i<1000; i++) {
+    FieldsData data;
+    randomData(random, data);
+    AllFields fields(data);
+
+    QByteArray output;
+    fields.Export(output);
+    QBitArray expected = referenceBits(data);
+    ASSERT_EQ(fields.size(), (unsigned int)expected.size());
+    ASSERT_EQ(reference::bitsToBytes(expected), output) << "iteration " << i;
+  }
+}
+
+TEST(EepromImportExport, importMatchesPerBitReference)
+{
+  std::mt19937 random(1234);
+  for (int i=0; i<1000; i++) {
+    FieldsData data;
+    randomData(random, data);
+    QByteArray bytes = reference::bitsToBytes(referenceBits(data));
+
+    // the imported values, read from the reference layout
+    FieldsData result;
+    memset(&result, 0, sizeof(result));
+    AllFields fields(result);
+    ASSERT_EQ(0, fields.Import(bytes));
+
+    QBitArray bits = reference::bytesToBits(bytes);
+    int offset = 0;
+    EXPECT_EQ(reference::readUnsigned(bits, offset, 3), result.u3);
+    EXPECT_EQ(reference::readSigned(bits, offset, 5), result.s5);
+    EXPECT_EQ((bool)reference::readUnsigned(bits, offset, 1), result.b1);
+    EXPECT_EQ(reference::readUnsigned(bits, offset, 13), result.u13);
+    EXPECT_EQ((bool)(reference::readUnsigned(bits, offset, 3) & 1), result.b3);
+    offset += 8 * 4;
+    EXPECT_EQ(0, memcmp(data.chars, result.chars, 4));
+    offset += 8 * 5;
+    EXPECT_STREQ(data.name, result.name);
+    offset += 6;
+    EXPECT_EQ(reference::readSigned(bits, offset, 16), result.s16);
+    EXPECT_EQ(reference::readUnsigned(bits, offset, 32), result.u32);
+    EXPECT_EQ(reference::readSigned(bits, offset, 32), result.s32);
+    EXPECT_EQ(importPlus2(reference::readSigned(bits, offset, 6)), result.converted);
+    EXPECT_EQ(reference::readUnsigned(bits, offset, 1), result.selector);
+    int unionOffset = offset;
+    if (result.selector == 0)
+      EXPECT_EQ(reference::readUnsigned(bits, unionOffset, 7), result.unionU7);
+    else
+      EXPECT_EQ(reference::readSigned(bits, unionOffset, 20), result.unionS20);
+    offset += 20;
+    EXPECT_EQ(0, memcmp(data.fixed, result.fixed, 3));
+    offset += 8 * 3;
+    EXPECT_EQ(reference::readUnsigned(bits, offset, 9), result.nested);
+
+    // and the values round-trip
+    EXPECT_EQ(data.u3, result.u3);
+    EXPECT_EQ(data.s5, result.s5);
+    EXPECT_EQ(data.u13, result.u13);
+    EXPECT_EQ(data.s16, result.s16);
+    EXPECT_EQ(data.u32, result.u32);
+    EXPECT_EQ(data.s32, result.s32);
+    EXPECT_EQ(data.converted, result.converted);
+    EXPECT_EQ(data.nested, result.nested);
+  }
+}
+
+TEST(EepromImportExport, shortInputReadsZeros)
+{
+  // bits past the end of the data read as zeros, as with the reference
+  QByteArray bytes(1, (char)0xFF);
+  BitReader reader(bytes);
+  EXPECT_EQ(0x0Fu, reader.read(4));
+  EXPECT_EQ(0x0Fu, reader.read(12));
+  EXPECT_EQ(0u, reader.read(32));
+}
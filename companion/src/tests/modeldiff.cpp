@@ -0,0 +1,77 @@
+#include "gtests.h"
+#include "modeldiff.h"
+#include "firmwares/opentx/opentxinterface.h"
+
+static void setMix(MixData & mix, unsigned int destCh, const RawSource & source, int weight)
+{
+  mix.clear();
+  mix.destCh = destCh;
+  mix.srcRaw = source;
+  mix.weight = weight;
+}
+
+class ModelDiffTest : public testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+      model1.clear();
+      setMix(model1.mixData[0], 1, RawSource(SOURCE_TYPE_STICK, 0), 100);
+      setMix(model1.mixData[1], 1, RawSource(SOURCE_TYPE_STICK, 1), 50);
+      setMix(model1.mixData[2], 2, RawSource(SOURCE_TYPE_STICK, 2), 100);
+      model1.logicalSw[0].func = LS_FN_VPOS;
+      model1.logicalSw[0].val1 = RawSource(SOURCE_TYPE_STICK, 0).toValue();
+      model2 = model1;
+    }
+
+    ModelData model1;
+    ModelData model2;
+    GeneralSettings settings;
+};
+
+TEST_F(ModelDiffTest, Identical)
+{
+  ModelDiff diff(model1, settings, model2, settings);
+  EXPECT_TRUE(diff.isEmpty());
+}
+
+TEST_F(ModelDiffTest, InsertedMix)
+{
+  // an insertion doesn't shift the following mixes
+  for (int i=3; i>0; i--)
+    model2.mixData[i] = model2.mixData[i-1];
+  setMix(model2.mixData[0], 1, RawSource(SOURCE_TYPE_STICK, 3), 100);
+
+  ModelDiff diff(model1, settings, model2, settings);
+  ASSERT_EQ(1, diff.changes().size());
+  EXPECT_EQ(ModelDiff::ITEM_ADDED, diff.changes()[0].type);
+}
+
+TEST_F(ModelDiffTest, ChangedField)
+{
+  model2.mixData[1].weight = 75;
+
+  ModelDiff diff(model1, settings, model2, settings);
+  ASSERT_EQ(1, diff.changes().size());
+  EXPECT_EQ(ModelDiff::ITEM_CHANGED, diff.changes()[0].type);
+  ASSERT_EQ(1, diff.changes()[0].fields.size());
+  EXPECT_EQ(QString("Weight"), diff.changes()[0].fields[0].name);
+}
+
+TEST_F(ModelDiffTest, MovedMix)
+{
+  qSwap(model2.mixData[0], model2.mixData[1]);
+
+  ModelDiff diff(model1, settings, model2, settings);
+  ASSERT_EQ(1, diff.changes().size());
+  EXPECT_EQ(ModelDiff::ITEM_MOVED, diff.changes()[0].type);
+}
+
+TEST_F(ModelDiffTest, RemovedLogicalSwitch)
+{
+  model2.logicalSw[0].clear();
+
+  ModelDiff diff(model1, settings, model2, settings);
+  ASSERT_EQ(1, diff.changes().size());
+  EXPECT_EQ(ModelDiff::ITEM_REMOVED, diff.changes()[0].type);
+}
@@ -0,0 +1,75 @@
+#include "gtests.h"
+#include "firmwares/opentx/opentxinterface.h"
+
+// bitwise version of the radio crc8 (polynomial 0xD5)
+static uint8_t crc8(const QByteArray & data, uint8_t crc = 0)
+{
+  for (int i = 0; i < data.size(); i++) {
+    crc ^= (uint8_t)data[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x80) ? (crc << 1) ^ 0xD5 : (crc << 1);
+    }
+  }
+  return crc;
+}
+
+static QByteArray journalRecord(int offset, const QByteArray & bytes)
+{
+  QByteArray record;
+  record.append((char)(offset & 0xFF));
+  record.append((char)(offset >> 8));
+  record.append((char)bytes.size());
+  record.append((char)crc8(bytes, crc8(record)));
+  record.append(bytes);
+  return record;
+}
+
+TEST(ModelJournal, apply)
+{
+  QByteArray data(300, 0);
+  QByteArray journal;
+  journal.append(journalRecord(2, QByteArray("\xAA\xBB\xCC", 3)));
+  journal.append(journalRecord(260, QByteArray("\x11", 1)));
+  journal.append(journalRecord(3, QByteArray("\xDD", 1)));
+
+  applyModelJournal(data, journal);
+  EXPECT_EQ((char)0xAA, data.at(2));
+  EXPECT_EQ((char)0xDD, data.at(3));
+  EXPECT_EQ((char)0xCC, data.at(4));
+  EXPECT_EQ((char)0x11, data.at(260));
+  EXPECT_EQ(0, data.at(5));
+}
+
+TEST(ModelJournal, invalidRecordStopsReplay)
+{
+  QByteArray data(16, 0);
+  QByteArray journal;
+  journal.append(journalRecord(0, QByteArray("\x01", 1)));
+  QByteArray corrupted = journalRecord(1, QByteArray("\x02", 1));
+  corrupted[3] = (char)(corrupted.at(3) ^ 0xFF);
+  journal.append(corrupted);
+  journal.append(journalRecord(2, QByteArray("\x03", 1)));
+  // outside of the data
+  journal.prepend(journalRecord(15, QByteArray("\x04\x05", 2)));
+
+  applyModelJournal(data, journal);
+  EXPECT_EQ(0, data.at(0));
+  EXPECT_EQ(0, data.at(15));
+
+  data.fill(0);
+  journal = journalRecord(0, QByteArray("\x01", 1));
+  journal.append(corrupted);
+  journal.append(journalRecord(2, QByteArray("\x03", 1)));
+  applyModelJournal(data, journal);
+  EXPECT_EQ(1, data.at(0));
+  EXPECT_EQ(0, data.at(1));
+  EXPECT_EQ(0, data.at(2));
+
+  // a torn record at the end of the file
+  data.fill(0);
+  journal = journalRecord(0, QByteArray("\x01", 1));
+  journal.append(journalRecord(1, QByteArray("\x02\x03", 2)).left(5));
+  applyModelJournal(data, journal);
+  EXPECT_EQ(1, data.at(0));
+  EXPECT_EQ(0, data.at(1));
+}
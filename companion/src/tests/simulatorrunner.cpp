@@ -0,0 +1,52 @@
+#include "gtests.h"
+#include "simulatorinterface.h"
+#include "simulatorrunner.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#define RUNNER_TESTS_RADIO   "opentx-x9d+"
+
+// an empty eeprom is formatted with a bad data alert, then the default model
+// (throttle warning enabled) is loaded with the throttle stick at full: neither
+// alert may wait for a key in a headless run
+TEST(SimulatorRunner, ThrottleWarningDoesNotBlock)
+{
+  SimulatorLoader::registerSimulators();
+  SimulatorInterface * simulator = SimulatorLoader::loadSimulator(RUNNER_TESTS_RADIO);
+  if (!simulator) {
+    printf("%s simulator not found, test skipped\n", RUNNER_TESTS_RADIO);
+    SimulatorLoader::unregisterSimulators();
+    return;
+  }
+
+  QTemporaryDir folder;
+  ASSERT_TRUE(folder.isValid());
+
+  const QString eeprom = QDir(folder.path()).filePath("eeprom.bin");
+  QFile eepromFile(eeprom);
+  ASSERT_TRUE(eepromFile.open(QIODevice::WriteOnly));
+  eepromFile.close();
+
+  // the throttle is the left or the right vertical stick depending on the mode
+  const QString script = QDir(folder.path()).filePath("script.txt");
+  QFile scriptFile(script);
+  ASSERT_TRUE(scriptFile.open(QIODevice::WriteOnly | QIODevice::Text));
+  QTextStream(&scriptFile) << "0 stick 1 1024\n" << "0 stick 2 1024\n";
+  scriptFile.close();
+
+  SimulatorRunner runner(simulator);
+  ASSERT_TRUE(runner.loadScript(script));
+  EXPECT_TRUE(runner.run(folder.path(), eeprom, 2000));
+  EXPECT_EQ(2000u, runner.time());
+
+  // the run works on a copy of the data
+  EXPECT_EQ(0, QFileInfo(eeprom).size());
+
+  delete simulator;
+  SimulatorLoader::unloadSimulator(RUNNER_TESTS_RADIO);
+  SimulatorLoader::unregisterSimulators();
+}
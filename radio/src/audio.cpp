@@ -19,7 +19,6 @@
  */
 
 #include "opentx.h"
-#include <math.h>
 
 extern RTOS_MUTEX_HANDLE audioMutex;
 
@@ -653,12 +652,15 @@ int WavContext::mixBuffer(AudioBuffer *buffer, int volume, unsigned int fade)
 }
 #endif
 
-const unsigned int toneVolumes[] = { 10, 8, 6, 4, 2 };
-inline float evalVolumeRatio(int freq, int volume)
+static_assert(DIM(sineValues) == (1 << (32 - TONE_PHASE_SHIFT)), "Wrong sine table size");
+
+// tone volumes divisors { 10, 8, 6, 4, 2 } as 4096 / divisor
+const uint16_t toneVolumes[] = { 410, 512, 683, 1024, 2048 };
+inline uint32_t evalToneVolume(uint32_t freq, int volume)
 {
-  float result = toneVolumes[2+volume];
+  uint32_t result = toneVolumes[2+volume];
   if (freq < 330) {
-    result = (result * freq * freq) / (330 * 330);
+    result = (result * 330 * 330) / (freq * freq);
   }
   return result;
 }
@@ -671,7 +673,7 @@ int ToneContext::mixBuffer(AudioBuffer * buffer, int volume, unsigned int fade)
   int remainingDuration = fragment.tone.duration - state.duration;
   if (remainingDuration > 0) {
     int points;
-    float toneIdx = state.idx;
+    uint32_t phase = state.phase;
 
     if (fragment.tone.reset) {
       fragment.tone.reset = 0;
@@ -681,8 +683,8 @@ int ToneContext::mixBuffer(AudioBuffer * buffer, int volume, unsigned int fade)
 
     if (fragment.tone.freq != state.freq) {
       state.freq = fragment.tone.freq;
-      state.step = limit<float>(1, float(fragment.tone.freq) * (float(DIM(sineValues))/float(AUDIO_SAMPLE_RATE)), 512);
-      state.volume = 1.0f / evalVolumeRatio(fragment.tone.freq, volume);
+      state.step = limit<uint32_t>(TONE_PHASE_STEP_MIN, fragment.tone.freq * TONE_PHASE_STEP_PER_HZ, TONE_PHASE_STEP_MAX);
+      state.volume = evalToneVolume(fragment.tone.freq, volume);
     }
 
     if (fragment.tone.freqIncr) {
@@ -708,27 +710,37 @@ int ToneContext::mixBuffer(AudioBuffer * buffer, int volume, unsigned int fade)
       points = AUDIO_BUFFER_SIZE;
     }
     else {
+      // the tone ends on the last full period inside its duration (or on the first one after it) to avoid a click
       duration = remainingDuration;
-      points = (duration * AUDIO_BUFFER_SIZE) / AUDIO_BUFFER_DURATION;
-      unsigned int end = toneIdx + (state.step * points);
-      if (end > DIM(sineValues))
-        end -= (end % DIM(sineValues));
-      else
-        end = DIM(sineValues);
-      points = (float(end) - toneIdx) / state.step;
+      int maxPoints = (duration * AUDIO_BUFFER_SIZE) / AUDIO_BUFFER_DURATION;
+      uint32_t end = phase;
+      points = 0;
+      for (int i=1; i<=AUDIO_BUFFER_SIZE; i++) {
+        uint32_t next = end + state.step;
+        if (next < end) {
+          // the phase accumulator wrapped: a period ends after i points
+          if (i > maxPoints && points > 0)
+            break;
+          points = i;
+          if (i >= maxPoints)
+            break;
+        }
+        end = next;
+      }
+      if (points == 0) {
+        points = maxPoints;
+      }
     }
 
     for (int i=0; i<points; i++) {
-      int16_t sample = sineValues[int(toneIdx)] * state.volume;
+      int16_t sample = (sineValues[phase >> TONE_PHASE_SHIFT] * int32_t(state.volume)) >> TONE_VOLUME_SHIFT;
       mixSample(&buffer->data[i], sample, fade);
-      toneIdx += state.step;
-      if ((unsigned int)toneIdx >= DIM(sineValues))
-        toneIdx -= DIM(sineValues);
+      phase += state.step;
     }
 
     if (remainingDuration > AUDIO_BUFFER_DURATION) {
       state.duration += AUDIO_BUFFER_DURATION;
-      state.idx = toneIdx;
+      state.phase = phase;
       return AUDIO_BUFFER_SIZE;
     }
     else {
@@ -855,8 +867,15 @@ bool AudioQueue::isPlaying(uint8_t id)
 
 void AudioQueue::playTone(uint16_t freq, uint16_t len, uint16_t pause, uint8_t flags, int8_t freqIncr)
 {
-#if defined(SIMU) && !defined(SIMU_AUDIO)
+#if defined(SIMU)
+  if (simuAudioCallback) {
+    char event[32];
+    snprintf(event, sizeof(event), "tone %d %d %d", freq, len, pause);
+    simuAudioCallback(event);
+  }
+#if !defined(SIMU_AUDIO)
   return;
+#endif
 #endif
 
   RTOS_LOCK_MUTEX(audioMutex);
@@ -894,6 +913,11 @@ void AudioQueue::playFile(const char * filename, uint8_t flags, uint8_t id)
     TRACE("file name too long! maximum length is %d characters", AUDIO_FILENAME_MAXLEN);
     return;
   }
+  if (simuAudioCallback) {
+    char event[AUDIO_FILENAME_MAXLEN + 8];
+    snprintf(event, sizeof(event), "file %s", filename);
+    simuAudioCallback(event);
+  }
   #if !defined(SIMU_AUDIO)
   return;
   #endif
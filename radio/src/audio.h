@@ -86,6 +86,13 @@ template <unsigned int NUM_BITS> class BitField {
 #define BEEP_KEY_UP_FREQ               (BEEP_DEFAULT_FREQ+150)
 #define BEEP_KEY_DOWN_FREQ             (BEEP_DEFAULT_FREQ-150)
 
+// tones are generated from a 1024 points sine table with a 32 bits phase accumulator
+#define TONE_PHASE_SHIFT               (22)
+#define TONE_PHASE_STEP_PER_HZ         (uint32_t((1ULL << 32) / AUDIO_SAMPLE_RATE))
+#define TONE_PHASE_STEP_MIN            (1UL << TONE_PHASE_SHIFT)
+#define TONE_PHASE_STEP_MAX            (1UL << 31)
+#define TONE_VOLUME_SHIFT              (12)
+
 #if defined(AUDIO_DUAL_BUFFER)
 enum AudioBufferState
 {
@@ -203,9 +210,9 @@ class ToneContext {
     AudioFragment fragment;
 
     struct {
-      float step;
-      float idx;
-      float  volume;
+      uint32_t step;
+      uint32_t phase;
+      uint16_t volume;
       uint16_t freq;
       uint16_t duration;
       uint16_t pause;
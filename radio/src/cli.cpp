@@ -702,6 +702,7 @@ int cliStackInfo(const char ** argv)
   serialPrint("[MAIN] %d available / %d", stackAvailable(), stackSize());
   serialPrint("[MENUS] %d available / %d", menusStack.available(), menusStack.size());
   serialPrint("[MIXER] %d available / %d", mixerStack.available(), mixerStack.size());
+  serialPrint("[TELEMETRY] %d available / %d", telemetryStack.available(), telemetryStack.size());
   serialPrint("[AUDIO] %d available / %d", audioStack.available(), audioStack.size());
   serialPrint("[CLI] %d available / %d", cliStack.available(), cliStack.size());
   return 0;
@@ -853,6 +854,9 @@ void printTaskSwitchLog()
     else if (mixerTaskId == n) {
       serialPrint("%d: mixer", n);
     }
+    else if (telemetryTaskId == n) {
+      serialPrint("%d: telemetry", n);
+    }
     else if (audioTaskId == n) {
       serialPrint("%d: audio", n);
     }
@@ -263,6 +263,10 @@ const char * const debugTimerNames[DEBUG_TIMERS_COUNT] = {
   ,"Audio int. "   // debugTimerAudioIterval
   ,"Audio dur. "   // debugTimerAudioDuration
   ," A. consume"   // debugTimerAudioConsume,
+  ,"Model read "   // debugTimerModelRead,
+  ,"Model conv."   // debugTimerModelConvert,
+  ,"Model post "   // debugTimerPostModelLoad,
+  ,"Model stage"   // debugTimerModelLoadStages,
 
 };
 
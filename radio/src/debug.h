@@ -402,6 +402,11 @@ enum DebugTimers {
   debugTimerAudioDuration,
   debugTimerAudioConsume,
 
+  debugTimerModelRead,
+  debugTimerModelConvert,
+  debugTimerPostModelLoad,
+  debugTimerModelLoadStages,
+
   DEBUG_TIMERS_COUNT
 };
 
@@ -21,6 +21,7 @@
 #ifndef _DMA_FIFO_H_
 #define _DMA_FIFO_H_
 
+#include <string.h>
 #include "definitions.h"
 
 template <int N>
@@ -68,6 +69,23 @@ class DMAFifo
       }
     }
 
+    uint32_t read(uint8_t * elements, uint32_t count)
+    {
+#if defined(SIMU)
+      return 0;
+#endif
+      uint32_t r = ridx;
+      uint32_t available = (N + N - stream->NDTR - r) & (N - 1);
+      if (count > available) {
+        count = available;
+      }
+      uint32_t first = (count < N - r) ? count : N - r;
+      memcpy(elements, &fifo[r], first);
+      memcpy(elements + first, &fifo[0], count - first);
+      ridx = (r + count) & (N - 1);
+      return count;
+    }
+
     uint8_t * buffer()
     {
       return fifo;
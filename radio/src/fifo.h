@@ -22,6 +22,7 @@
 #define _FIFO_H_
 
 #include <inttypes.h>
+#include <string.h>
 
 template <class T, int N>
 class Fifo
@@ -66,6 +67,21 @@ class Fifo
       }
     }
 
+    // pops up to count elements at once, the read index is only updated once
+    uint32_t read(T * elements, uint32_t count)
+    {
+      uint32_t r = ridx;
+      uint32_t available = (N + widx - r) & (N - 1);
+      if (count > available) {
+        count = available;
+      }
+      uint32_t first = (count < N - r) ? count : N - r;
+      memcpy(elements, &fifo[r], first * sizeof(T));
+      memcpy(elements + first, &fifo[0], (count - first) * sizeof(T));
+      ridx = (r + count) & (N - 1);
+      return count;
+    }
+
     bool isEmpty() const
     {
       return (ridx == widx);
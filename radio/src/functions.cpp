@@ -195,13 +195,13 @@ void evalFunctions(const CustomFunctionData * functions, CustomFunctionsContext
                 }
                 break;
               case FUNC_RESET_TELEMETRY:
-                telemetryReset();
+                telemetryResetRequest = 1;   // telemetryItems are only written by the telemetry task
                 break;
             }
             if (CFN_PARAM(cfn)>=FUNC_RESET_PARAM_FIRST_TELEM) {
               uint8_t item = CFN_PARAM(cfn)-FUNC_RESET_PARAM_FIRST_TELEM;
               if (item < MAX_TELEMETRY_SENSORS) {
-                telemetryItems[item].clear();
+                telemetryItemResetRequests[item] = 1;
               }
             }
             break;
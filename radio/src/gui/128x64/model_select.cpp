@@ -25,7 +25,6 @@
 void onDeleteModelConfirm(const char * result)
 {
   if (result == STR_OK) {
-    storageCheck(true);
     eeDeleteModel(menuVerticalPosition); // delete file
     s_copyMode = 0;
   }
@@ -50,7 +49,6 @@ void onModelSelectMenu(const char * result)
   }
 #if defined(SDCARD)
   else if (result == STR_BACKUP_MODEL) {
-    storageCheck(true); // force writing of current model data before this is changed
     POPUP_WARNING(eeBackupModel(sub));
   }
   else if (result == STR_RESTORE_MODEL || result == STR_UPDATE_LIST) {
@@ -67,7 +65,6 @@ void onModelSelectMenu(const char * result)
 #if defined(SDCARD)
   else if (result != STR_EXIT) {
     // The user choosed a file on SD to restore
-    storageCheck(true);
     POPUP_WARNING(eeRestoreModel(sub, (char *)result));
     if (!warningText && g_eeGeneral.currModel == sub) {
       eeLoadModel(sub);
@@ -136,7 +133,6 @@ void menuModelSelect(event_t event)
       }
       else if (s_copyMode && (s_copyTgtOfs || s_copySrcRow>=0)) {
         showMessageBox(s_copyMode==COPY_MODE ? STR_COPYINGMODEL : STR_MOVINGMODEL);
-        storageCheck(true); // force writing of current model data before this is changed
 
         uint8_t cur = (MAX_MODELS + sub + s_copyTgtOfs) % MAX_MODELS;
 
@@ -41,7 +41,6 @@ void onModelSelectMenu(const char * result)
     s_copySrcRow = -1;
   }
   else if (result == STR_BACKUP_MODEL) {
-    storageCheck(true); // force writing of current model data before this is changed
     POPUP_WARNING(eeBackupModel(sub));
   }
   else if (result == STR_RESTORE_MODEL || result == STR_UPDATE_LIST) {
@@ -58,7 +57,6 @@ void onModelSelectMenu(const char * result)
   }
   else if (result != STR_EXIT) {
     // The user choosed a file on SD to restore
-    storageCheck(true);
     POPUP_WARNING(eeRestoreModel(sub, (char *)result));
     if (!warningText && g_eeGeneral.currModel == sub) {
       eeLoadModel(sub);
@@ -70,7 +68,6 @@ void menuModelSelect(event_t event)
 {
   if (warningResult) {
     warningResult = 0;
-    storageCheck(true);
     eeDeleteModel(menuVerticalPosition); // delete file
     s_copyMode = 0;
     event = EVT_ENTRY_UP;
@@ -134,7 +131,6 @@ void menuModelSelect(event_t event)
         }
         else if (s_copyMode && (s_copyTgtOfs || s_copySrcRow>=0)) {
           showMessageBox(s_copyMode==COPY_MODE ? STR_COPYINGMODEL : STR_MOVINGMODEL);
-          storageCheck(true); // force writing of current model data before this is changed
 
           uint8_t cur = (MAX_MODELS + sub + s_copyTgtOfs) % MAX_MODELS;
 
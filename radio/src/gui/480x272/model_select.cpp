@@ -69,6 +69,29 @@ void drawModel(coord_t x, coord_t y, ModelCell * model, bool current, bool selec
   }
 }
 
+// The models cells are rendered (or their thumbnails checked) one per call when the menu
+// is idle, the visible ones first. Returns true when the screen needs to be refreshed
+bool refreshModelsBuffers()
+{
+  ModelCell * next = NULL;
+  int index = 0;
+  for (ModelsCategory::iterator it = currentCategory->begin(); it != currentCategory->end(); ++it, ++index) {
+    ModelCell * model = *it;
+    if (!model->valid_thumbnail) {
+      if (index >= menuVerticalOffset*2 && index < (menuVerticalOffset+4)*2) {
+        return model->refreshBuffer(true);
+      }
+      else if (!next) {
+        next = model;
+      }
+    }
+  }
+  if (next) {
+    next->refreshBuffer(false);
+  }
+  return false;
+}
+
 uint16_t categoriesVerticalOffset = 0;
 uint16_t categoriesVerticalPosition = 0;
 #define MODEL_INDEX()       (menuVerticalPosition*2+menuHorizontalPosition)
@@ -346,8 +369,10 @@ bool menuModelSelect(event_t event)
   const std::list<ModelsCategory*>& cats = modelslist.getCategories();
   switch(event) {
     case 0:
-      // no need to refresh the screen
-      return false;
+      // no need to refresh the screen, unless a model cell was rendered
+      if (!currentCategory || !refreshModelsBuffers())
+        return false;
+      break;
 
     case EVT_ENTRY:
       selectMode = MODE_SELECT_MODEL;
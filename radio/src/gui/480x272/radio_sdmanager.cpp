@@ -136,6 +136,7 @@ void onSdManagerMenu(const char * result)
   else if (result == STR_DELETE_FILE) {
     getSelectionFullPath(lfn);
     f_unlink(lfn);
+    removeModelThumbnail(lfn);
     menuVerticalOffset = 0;
     menuVerticalPosition = 0;
     REFRESH_FILES();
@@ -424,6 +425,11 @@ bool menuRadioSdManager(event_t _event)
             reusableBuffer.sdManager.lines[i][efflen] = 0;
           }
           f_rename(reusableBuffer.sdManager.originalName, reusableBuffer.sdManager.lines[i]);
+          char path[_MAX_LFN+1];
+          f_getcwd(path, _MAX_LFN);
+          strcat(path, "/");
+          strcat(path, reusableBuffer.sdManager.originalName);
+          removeModelThumbnail(path);
           REFRESH_FILES();
         }
       }
@@ -475,6 +475,7 @@ void perMain()
 #endif
   checkSpeakerVolume();
   checkEeprom();
+  modelLoadWakeup();
   logsWrite();
   handleUsbConnection();
 #if defined(PCBXLITES)
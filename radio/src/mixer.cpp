@@ -403,7 +403,7 @@ getvalue_t getValue(mixsrc_t i)
     }
     i -= MIXSRC_FIRST_TELEM;
     div_t qr = div(i, 3);
-    TelemetryItem & telemetryItem = telemetryItems[qr.quot];
+    TelemetrySnapshot::Item telemetryItem = telemetrySnapshot[qr.quot];
     switch (qr.rem) {
       case 1:
         return telemetryItem.valueMin;
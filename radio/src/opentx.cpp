@@ -987,7 +987,7 @@ void checkThrottleStick()
   bool refresh = false;
 #endif
 
-  while (!getEvent()) {
+  while (!getEvent() && !IS_SIMU_HEADLESS()) {
     if (!isThrottleWarningAlertNeeded()) {
       return;
     }
@@ -1046,7 +1046,7 @@ void alert(const char * title, const char * msg , uint8_t sound)
   while (1) {
     RTOS_WAIT_MS(10);
 
-    if (keyDown())  // wait for key release
+    if (keyDown() || IS_SIMU_HEADLESS())  // wait for key release
       break;
 
     doLoopCommonActions();
@@ -451,6 +451,13 @@ uint16_t evalChkSum();
 
 void alert(const char * title, const char * msg, uint8_t sound);
 
+#if defined(SIMU)
+  // nobody would dismiss the alerts of a headless simulator, they don't wait for a key
+  #define IS_SIMU_HEADLESS()           (simu_headless)
+#else
+  #define IS_SIMU_HEADLESS()           false
+#endif
+
 #if !defined(GUI)
   #define RAISE_ALERT(...)
   #define ALERT(...)
@@ -477,6 +484,7 @@ enum PerOutMode {
 
 extern uint8_t mixerCurrentFlightMode;
 extern uint8_t lastFlightMode;
+extern tmr10ms_t flightModeTransitionTime;
 extern uint8_t flightModeTransitionLast;
 
 #if defined(SIMU)
@@ -509,6 +517,19 @@ void evalLogicalSwitches(bool isCurrentFlightmode=true);
 void logicalSwitchesCopyState(uint8_t src, uint8_t dst);
 #define LS_RECURSIVE_EVALUATION_RESET()
 
+PACK(struct LogicalSwitchContext {
+  uint8_t state:1;
+  uint8_t timerState:2;
+  uint8_t spare:5;
+  uint8_t timer;
+  int16_t lastValue;
+});
+
+PACK(struct LogicalSwitchesFlightModeContext {
+  LogicalSwitchContext lsw[MAX_LOGICAL_SWITCHES];
+});
+extern LogicalSwitchesFlightModeContext lswFm[MAX_FLIGHT_MODES];
+
 #if defined(PCBTARANIS) || defined(PCBHORUS)
   void getSwitchesPosition(bool startup);
 #else
@@ -23,27 +23,37 @@
 #define CROSSFIRE_CH_CENTER         0x3E0
 #define CROSSFIRE_CH_BITS           11
 
+class CrossfireCrc {
+  public:
+    uint8_t value = 0;
+
+    void addToCrc(uint8_t byte)
+    {
+      value = crc8Update(value, byte);
+    }
+
+    void addWordToCrc(uint32_t word)
+    {
+      value = crc8UpdateWord(value, word);
+    }
+};
+
 // Range for pulses (channels output) is [-1024:+1024]
 uint8_t createCrossfireChannelsFrame(uint8_t * frame, int16_t * pulses)
 {
   uint8_t * buf = frame;
   *buf++ = MODULE_ADDRESS;
   *buf++ = 24; // 1(ID) + 22 + 1(CRC)
-  uint8_t * crc_start = buf;
+  CrossfireCrc crc;
+  crc.addToCrc(CHANNELS_ID);
   *buf++ = CHANNELS_ID;
-  uint32_t bits = 0;
-  uint8_t bitsavailable = 0;
+  ChannelsPacker<CROSSFIRE_CH_BITS, CrossfireCrc> packer(buf, crc);
   for (int i=0; i<CROSSFIRE_CHANNELS_COUNT; i++) {
     uint32_t val = limit(0, CROSSFIRE_CH_CENTER + (((pulses[i]) * 4) / 5), 2*CROSSFIRE_CH_CENTER);
-    bits |= val << bitsavailable;
-    bitsavailable += CROSSFIRE_CH_BITS;
-    while (bitsavailable >= 8) {
-      *buf++ = bits;
-      bits >>= 8;
-      bitsavailable -= 8;
-    }
+    packer.addValue(val);
   }
-  *buf++ = crc8(crc_start, 23);
+  buf = packer.end();
+  *buf++ = crc.value;
   return buf - frame;
 }
 
@@ -22,6 +22,7 @@
 #define _PULSES_COMMON_H_
 
 #include <inttypes.h>
+#include <string.h>
 
 #if defined(EXTMODULE_TIMER_32BITS)
   typedef uint32_t pulse_duration_t;
@@ -54,6 +55,53 @@ class DataBuffer {
     }
 };
 
+// Packs the channels values LSB first, BITS bits each, directly in the frame which will be sent
+// by DMA. The bits are written one 32-bit word at a time (unaligned stores are allowed on
+// Cortex-M3/M4 and x86), and each word is given to the CRC at the same time
+template <unsigned BITS, class Crc>
+class ChannelsPacker {
+  public:
+    ChannelsPacker(uint8_t * ptr, Crc & crc):
+      ptr(ptr),
+      crc(crc),
+      bits(0),
+      count(0)
+    {
+    }
+
+    void addValue(uint32_t value)
+    {
+      bits |= uint64_t(value) << count;
+      count += BITS;
+      if (count >= 32) {
+        uint32_t word = bits;
+        memcpy(ptr, &word, sizeof(word));
+        crc.addWordToCrc(word);
+        ptr += sizeof(word);
+        bits >>= 32;
+        count -= 32;
+      }
+    }
+
+    // write the remaining bytes, returns the end of the packed values
+    uint8_t * end()
+    {
+      while (count > 0) {
+        crc.addToCrc(uint8_t(bits));
+        *ptr++ = bits;
+        bits >>= 8;
+        count = (count > 8 ? count - 8 : 0);
+      }
+      return ptr;
+    }
+
+  protected:
+    uint8_t * ptr;
+    Crc & crc;
+    uint64_t bits;
+    unsigned count;
+};
+
 template <class T, int SIZE>
 class PulsesBuffer: public DataBuffer<T, SIZE> {
   public:
@@ -50,44 +50,36 @@ void Pxx2Pulses::addFlag1(uint8_t module)
   Pxx2Transport::addByte(subType << 4);
 }
 
-void Pxx2Pulses::addPulsesValues(uint16_t low, uint16_t high)
-{
-  Pxx2Transport::addByte(low); // Low byte of channel
-  Pxx2Transport::addByte(((low >> 8) & 0x0F) | (high << 4));  // 4 bits each from 2 channels
-  Pxx2Transport::addByte(high >> 4);  // High byte of channel
-}
-
 void Pxx2Pulses::addChannels(uint8_t module)
 {
-  uint16_t pulseValue = 0;
-  uint16_t pulseValueLow = 0;
-
   uint8_t channel = g_model.moduleData[module].channelsStart;
-  uint8_t count = sentModuleChannels(module);
+  uint8_t count = sentModuleChannels(module) & ~1; // the channels are sent by pairs
+
+  ChannelsPacker<PXX2_CHANNEL_BITS, Pxx2CrcMixin> packer(ptr, *this);
 
   for (int8_t i = 0; i < count; i++, channel++) {
     int value = channelOutputs[channel] + 2*PPM_CH_CENTER(channel) - 2*PPM_CENTER;
-    pulseValue = limit(1, (value * 512 / 682) + 1024, 2046);
+    uint16_t pulseValue = limit(1, (value * 512 / 682) + 1024, 2046);
 #if defined(DEBUG_LATENCY_RF_ONLY)
     if (latencyToggleSwitch)
       pulseValue = 1;
     else
       pulseValue = 2046;
 #endif
-    if (i & 1)
-      addPulsesValues(pulseValueLow, pulseValue);
-    else
-      pulseValueLow = pulseValue;
+    packer.addValue(pulseValue);
   }
+
+  ptr = packer.end();
 }
 
 void Pxx2Pulses::addFailsafe(uint8_t module)
 {
   uint16_t pulseValue = 0;
-  uint16_t pulseValueLow = 0;
 
   uint8_t channel = g_model.moduleData[module].channelsStart;
-  uint8_t count = sentModuleChannels(module);
+  uint8_t count = sentModuleChannels(module) & ~1; // the channels are sent by pairs
+
+  ChannelsPacker<PXX2_CHANNEL_BITS, Pxx2CrcMixin> packer(ptr, *this);
 
   for (int8_t i = 0; i < count; i++, channel++) {
     if (g_model.moduleData[module].failsafeMode == FAILSAFE_HOLD) {
@@ -109,11 +101,10 @@ void Pxx2Pulses::addFailsafe(uint8_t module)
         pulseValue = limit(1, (failsafeValue * 512 / 682) + 1024, 2046);
       }
     }
-    if (i & 1)
-      addPulsesValues(pulseValueLow, pulseValue);
-    else
-      pulseValueLow = pulseValue;
+    packer.addValue(pulseValue);
   }
+
+  ptr = packer.end();
 }
 
 void Pxx2Pulses::setupChannelsFrame(uint8_t module)
@@ -291,7 +291,12 @@ enum PXX2ReceiverStatus {
 extern ModuleFifo intmoduleFifo;
 extern ModuleFifo extmoduleFifo;
 
+#define PXX2_CHANNEL_BITS              12
+
 class Pxx2CrcMixin {
+  template <unsigned BITS, class Crc>
+  friend class ChannelsPacker;
+
   protected:
     void initCrc()
     {
@@ -303,6 +308,13 @@ class Pxx2CrcMixin {
       crc -= byte;
     }
 
+    void addWordToCrc(uint32_t word)
+    {
+      // the 4 bytes are added 2 by 2
+      word = (word & 0x00FF00FF) + ((word >> 8) & 0x00FF00FF);
+      crc -= (word & 0xFFFF) + (word >> 16);
+    }
+
     uint16_t crc;
 };
 
@@ -381,8 +393,6 @@ class Pxx2Pulses: public Pxx2Transport {
 
     void addFlag1(uint8_t module);
 
-    void addPulsesValues(uint16_t low, uint16_t high);
-
     void addChannels(uint8_t module);
 
     void addFailsafe(uint8_t module);
@@ -24,12 +24,14 @@
 #include "opentx.h"
 #include "timers.h"
 
-void eeLoadModel(uint8_t index)
+void eeLoadModel(uint8_t index, bool alarms)
 {
   if (index < MAX_MODELS) {
     preModelLoad();
 
+    DEBUG_TIMER_START(debugTimerModelRead);
     uint16_t size = eeLoadModelData(index);
+    DEBUG_TIMER_STOP(debugTimerModelRead);
 
 #if defined(SIMU) && defined(EEPROM_ZONE_SIZE)
     if (sizeof(uint16_t) + sizeof(g_model) > EEPROM_ZONE_SIZE) {
@@ -43,7 +45,6 @@ void eeLoadModel(uint8_t index)
     }
 #endif
 
-    bool alarms = true;
     if (size < EEPROM_MIN_MODEL_SIZE) { // if not loaded a fair amount
       modelDefault(index) ;
       storageCheck(true);
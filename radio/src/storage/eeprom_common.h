@@ -24,7 +24,7 @@ uint16_t eeLoadModelData(uint8_t id);
 uint16_t eeLoadGeneralSettingsData();
 
 bool eeModelExists(uint8_t id);
-void eeLoadModel(uint8_t id);
+void eeLoadModel(uint8_t id, bool alarms=true);
 uint8_t eeFindEmptyModel(uint8_t id, bool down);
 void selectModel(uint8_t sub);
 
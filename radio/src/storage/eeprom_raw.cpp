@@ -59,8 +59,14 @@ uint8_t eepromWriteFileIndex;
 uint16_t eepromWriteSize;
 uint8_t * eepromWriteSourceAddr;
 uint32_t eepromWriteDestinationAddr;
+uint32_t eepromCopySourceAddr = 0;
+EepromFileHeader eepromCopyHeader __DMA;
+uint16_t eepromWriteBufferSize;
 uint16_t eepromFatAddr = 0;
 uint8_t eepromWriteBuffer[EEPROM_BUFFER_SIZE] __DMA;
+EepromWriteRequest eepromWriteQueue[EEPROM_WRITE_QUEUE_SIZE];
+uint8_t eepromWriteQueueCount = 0;
+EepromWriteRequest eepromCurrentRequest;
 
 void eepromWaitReadStatus()
 {
@@ -129,9 +135,44 @@ bool eepromOpen()
   }
 }
 
+// the file which will hold the data of a model once the queued
+// requests are done, -1 if it will be deleted
+int eepromGetQueuedFile(int index)
+{
+  for (int i=eepromWriteQueueCount-1; i>=0; i--) {
+    const EepromWriteRequest & request = eepromWriteQueue[i];
+    int file1 = request.index1 + 1;
+    int file2 = request.index2 + 1;
+    switch (request.type) {
+      case EEPROM_REQUEST_COPY_MODEL:
+        if (index == file1)
+          index = file2;
+        break;
+      case EEPROM_REQUEST_SWAP_MODELS:
+        if (index == file1)
+          index = file2;
+        else if (index == file2)
+          index = file1;
+        break;
+      case EEPROM_REQUEST_DELETE_MODEL:
+        if (index == file1)
+          return -1;
+        break;
+    }
+  }
+
+  // the FAT is already updated for the copy being written, not the data
+  if (eepromCurrentRequest.type == EEPROM_REQUEST_COPY_MODEL && index == eepromCurrentRequest.index1 + 1) {
+    index = eepromCurrentRequest.index2 + 1;
+  }
+
+  return index;
+}
+
 uint32_t readFile(int index, uint8_t * data, uint32_t size)
 {
-  if (eepromHeader.files[index].exists) {
+  index = eepromGetQueuedFile(index);
+  if (index >= 0 && eepromHeader.files[index].exists) {
     EepromFileHeader header;
     uint32_t address = eepromHeader.files[index].zoneIndex * EEPROM_ZONE_SIZE;
     eepromRead((uint8_t *)&header, address, sizeof(header));
@@ -161,7 +202,17 @@ void eepromIncFatAddr()
   }
 }
 
-void writeFile(int index, uint8_t * data, uint32_t size)
+// the FAT is only written once the new FAT block is erased if needed
+void eepromStartFatWrite()
+{
+  eepromIncFatAddr();
+  eepromWriteSize = 0;
+  eepromWriteState = EEPROM_WRITE_NEXT_BUFFER;
+}
+
+// files are always written in a spare zone, which replaces the file zone
+// in the new FAT, so that an interrupted write leaves the previous file
+void eepromStartFileWrite(int index, uint32_t size)
 {
   uint32_t zoneIndex = eepromHeader.files[eepromWriteZoneIndex].zoneIndex;
   eepromHeader.files[eepromWriteZoneIndex].exists = 0;
@@ -169,7 +220,6 @@ void writeFile(int index, uint8_t * data, uint32_t size)
   eepromHeader.files[index].exists = (size > 0);
   eepromHeader.files[index].zoneIndex = zoneIndex;
   eepromWriteFileIndex = index;
-  eepromWriteSourceAddr = data;
   eepromWriteSize = size;
   eepromWriteDestinationAddr = zoneIndex * EEPROM_ZONE_SIZE;
   eepromWriteState = EEPROM_START_WRITE;
@@ -180,53 +230,151 @@ void writeFile(int index, uint8_t * data, uint32_t size)
   eepromIncFatAddr();
 }
 
-void eeDeleteModel(uint8_t index)
+void writeFile(int index, uint8_t * data, uint32_t size)
 {
-  storageCheck(true);
-  memclear(&modelHeaders[index], sizeof(ModelHeader));
-  writeFile(index+1, (uint8_t *)&g_model, 0);
-  eepromWriteWait();
+  eepromCopySourceAddr = 0;
+  eepromWriteSourceAddr = data;
+  eepromStartFileWrite(index, size);
 }
 
-bool eeCopyModel(uint8_t dst, uint8_t src)
+// the header of the source is read asynchronously, the write starts
+// once its size is known
+void copyFile(int index, int source)
 {
-  storageCheck(true);
+  eepromCopySourceAddr = eepromHeader.files[source].zoneIndex * EEPROM_ZONE_SIZE;
+  if (eepromHeader.files[source].exists) {
+    eepromWriteState = EEPROM_READING_COPY_HEADER;
+    eepromStartRead((uint8_t *)&eepromCopyHeader, eepromCopySourceAddr, sizeof(eepromCopyHeader));
+  }
+  else {
+    eepromStartFileWrite(index, 0);
+  }
+}
+
+void eepromStartBufferWrite()
+{
+  eepromWriteState = EEPROM_WRITING_BUFFER;
+  eepromWrite(eepromWriteBuffer, eepromWriteDestinationAddr, eepromWriteBufferSize, false);
+  eepromWriteDestinationAddr += eepromWriteBufferSize;
+}
 
-  uint32_t eepromWriteSourceAddr = eepromHeader.files[src+1].zoneIndex * EEPROM_ZONE_SIZE;
-  uint32_t eepromWriteDestinationAddr = eepromHeader.files[dst+1].zoneIndex * EEPROM_ZONE_SIZE;
+// the data of a copy are read asynchronously before being written
+void eepromFillWriteBuffer(uint8_t * buffer, uint32_t size)
+{
+  if (eepromCopySourceAddr && size > 0) {
+    eepromWriteState = EEPROM_READING_BUFFER;
+    eepromStartRead(buffer, eepromCopySourceAddr, size);
+    eepromCopySourceAddr += size;
+  }
+  else {
+    memcpy(buffer, eepromWriteSourceAddr, size);
+    eepromWriteSourceAddr += size;
+    eepromStartBufferWrite();
+  }
+}
 
-  // erase blocks
-  eepromEraseBlock(eepromWriteDestinationAddr);
-  eepromEraseBlock(eepromWriteDestinationAddr+EEPROM_BLOCK_SIZE);
+void eepromStartRequest(const EepromWriteRequest & request)
+{
+  eepromCurrentRequest = request;
 
-  // write model
-  for (int pos=0; pos<EEPROM_ZONE_SIZE; pos+=EEPROM_BUFFER_SIZE) {
-    eepromRead(eepromWriteBuffer, eepromWriteSourceAddr+pos, EEPROM_BUFFER_SIZE);
-    eepromWrite(eepromWriteBuffer, eepromWriteDestinationAddr+pos, EEPROM_BUFFER_SIZE);
+  switch (request.type) {
+    case EEPROM_REQUEST_WRITE_GENERAL:
+      writeFile(0, (uint8_t *)&g_eeGeneral, sizeof(g_eeGeneral));
+      break;
+
+    case EEPROM_REQUEST_WRITE_MODEL:
+      writeFile(request.index1+1, (uint8_t *)&g_model, sizeof(g_model));
+      break;
+
+    case EEPROM_REQUEST_COPY_MODEL:
+      copyFile(request.index1+1, request.index2+1);
+      break;
+
+    case EEPROM_REQUEST_SWAP_MODELS:
+    {
+      EepromHeaderFile tmp = eepromHeader.files[request.index1+1];
+      eepromHeader.files[request.index1+1] = eepromHeader.files[request.index2+1];
+      eepromHeader.files[request.index2+1] = tmp;
+      eepromStartFatWrite();
+      break;
+    }
+
+    case EEPROM_REQUEST_DELETE_MODEL:
+      eepromHeader.files[request.index1+1].exists = 0;
+      eepromStartFatWrite();
+      break;
   }
+}
 
-  // write FAT
-  eepromHeader.files[dst+1].exists = 1;
-  eepromIncFatAddr();
-  eepromWriteState = EEPROM_WRITE_NEW_FAT;
-  eepromWriteWait();
+bool eepromWriteRequest(uint8_t type, uint8_t index1, uint8_t index2)
+{
+  // a file write still in the queue will write the latest data anyway
+  for (int i=eepromWriteQueueCount-1; i>=0; i--) {
+    EepromWriteRequest & request = eepromWriteQueue[i];
+    if (request.type != EEPROM_REQUEST_WRITE_GENERAL && request.type != EEPROM_REQUEST_WRITE_MODEL)
+      break;
+    if (request.type == type && request.index1 == index1)
+      return true;
+  }
 
-  modelHeaders[dst] = modelHeaders[src];
+  if (eepromWriteQueueCount >= EEPROM_WRITE_QUEUE_SIZE) {
+    return false;
+  }
+
+  // radio settings are written before the models
+  int pos = eepromWriteQueueCount;
+  if (type == EEPROM_REQUEST_WRITE_GENERAL) {
+    while (pos > 0 && eepromWriteQueue[pos-1].type == EEPROM_REQUEST_WRITE_MODEL)
+      pos--;
+  }
 
+  memmove(&eepromWriteQueue[pos+1], &eepromWriteQueue[pos], (eepromWriteQueueCount-pos) * sizeof(EepromWriteRequest));
+  eepromWriteQueue[pos].type = type;
+  eepromWriteQueue[pos].index1 = index1;
+  eepromWriteQueue[pos].index2 = index2;
+  eepromWriteQueueCount++;
   return true;
 }
 
-void eeSwapModels(uint8_t id1, uint8_t id2)
+void eepromWriteStep()
 {
-  storageCheck(true);
-  {
-    EepromHeaderFile tmp = eepromHeader.files[id1+1];
-    eepromHeader.files[id1+1] = eepromHeader.files[id2+1];
-    eepromHeader.files[id2+1] = tmp;
+#if defined(STM32)
+  // Waits a little bit for CS transitions
+  RTOS_WAIT_MS(2);
+#endif
+  eepromWriteProcess();
+#ifdef SIMU
+  sleep(5/*ms*/);
+#endif
+}
+
+void eepromQueueRequest(uint8_t type, uint8_t index1=0, uint8_t index2=0)
+{
+  // when the queue is full we wait for the oldest requests to be written
+  while (!eepromWriteRequest(type, index1, index2)) {
+    eepromWriteStep();
   }
-  eepromIncFatAddr();
-  eepromWriteState = EEPROM_WRITE_NEW_FAT;
-  eepromWriteWait();
+}
+
+void eeDeleteModel(uint8_t index)
+{
+  storageCheck(false);
+  memclear(&modelHeaders[index], sizeof(ModelHeader));
+  eepromQueueRequest(EEPROM_REQUEST_DELETE_MODEL, index);
+}
+
+bool eeCopyModel(uint8_t dst, uint8_t src)
+{
+  storageCheck(false);
+  eepromQueueRequest(EEPROM_REQUEST_COPY_MODEL, dst, src);
+  modelHeaders[dst] = modelHeaders[src];
+  return true;
+}
+
+void eeSwapModels(uint8_t id1, uint8_t id2)
+{
+  storageCheck(false);
+  eepromQueueRequest(EEPROM_REQUEST_SWAP_MODELS, id1, id2);
 
   {
     ModelHeader tmp = modelHeaders[id1];
@@ -246,16 +394,6 @@ uint16_t eeLoadModelData(uint8_t index)
   return readFile(index+1, (uint8_t *)&g_model, sizeof(g_model));
 }
 
-void writeGeneralSettings()
-{
-  writeFile(0, (uint8_t *)&g_eeGeneral, sizeof(g_eeGeneral));
-}
-
-void writeModel(int index)
-{
-  writeFile(index+1, (uint8_t *)&g_model, sizeof(g_model));
-}
-
 bool eeLoadGeneral(bool allowFixes)
 {
   eeLoadGeneralSettingsData();
@@ -276,7 +414,8 @@ bool eeLoadGeneral(bool allowFixes)
 
 bool eeModelExists(uint8_t id)
 {
-  return (eepromHeader.files[id+1].exists);
+  int index = eepromGetQueuedFile(id+1);
+  return (index >= 0 && eepromHeader.files[index].exists);
 }
 
 void eeLoadModelHeader(uint8_t id, ModelHeader * header)
@@ -300,42 +439,27 @@ void storageFormat()
 
 void eepromWriteWait(EepromWriteState state/* = EEPROM_IDLE*/)
 {
-  while (eepromWriteState != state) {
-#if defined(STM32)
-    // Waits a little bit for CS transitions
-    RTOS_WAIT_MS(2);
-#endif
-    eepromWriteProcess();
-#ifdef SIMU
-    sleep(5/*ms*/);
-#endif
+  while (eepromWriteState != state || (state == EEPROM_IDLE && eepromWriteQueueCount > 0)) {
+    eepromWriteStep();
   }
 }
 
 void storageCheck(bool immediately)
 {
-  if (immediately) {
-    eepromWriteWait();
-  }
-
-  assert(eepromWriteState == EEPROM_IDLE);
-
   if (storageDirtyMsk & EE_GENERAL) {
     TRACE("eeprom write general");
     storageDirtyMsk -= EE_GENERAL;
-    writeGeneralSettings();
-    if (immediately)
-      eepromWriteWait();
-    else
-      return;
+    eepromQueueRequest(EEPROM_REQUEST_WRITE_GENERAL);
   }
 
   if (storageDirtyMsk & EE_MODEL) {
     TRACE("eeprom write model");
     storageDirtyMsk -= EE_MODEL;
-    writeModel(g_eeGeneral.currModel);
-    if (immediately)
-      eepromWriteWait();
+    eepromQueueRequest(EEPROM_REQUEST_WRITE_MODEL, g_eeGeneral.currModel);
+  }
+
+  if (immediately) {
+    eepromWriteWait();
   }
 }
 
@@ -349,6 +473,7 @@ void eepromWriteProcess()
     case EEPROM_WRITING_BUFFER:
     case EEPROM_ERASING_FAT_BLOCK:
     case EEPROM_WRITING_NEW_FAT:
+    case EEPROM_WRITING_FAT_MARK:
       if (eepromIsTransferComplete()) {
         eepromWriteState = EepromWriteState(eepromWriteState + 1);
       }
@@ -359,11 +484,25 @@ void eepromWriteProcess()
     case EEPROM_WRITING_BUFFER_WAIT:
     case EEPROM_ERASING_FAT_BLOCK_WAIT:
     case EEPROM_WRITING_NEW_FAT_WAIT:
+    case EEPROM_WRITING_FAT_MARK_WAIT:
       if (eepromReadStatus()) {
         eepromWriteState = EepromWriteState(eepromWriteState + 1);
       }
       break;
 
+    case EEPROM_READING_COPY_HEADER:
+      if (eepromIsTransferComplete()) {
+        eepromCopySourceAddr += sizeof(EepromFileHeader);
+        eepromStartFileWrite(eepromCurrentRequest.index1+1, eepromCopyHeader.size);
+      }
+      break;
+
+    case EEPROM_READING_BUFFER:
+      if (eepromIsTransferComplete()) {
+        eepromStartBufferWrite();
+      }
+      break;
+
     case EEPROM_START_WRITE:
       eepromWriteState = EEPROM_ERASING_FILE_BLOCK1;
       eepromEraseBlock(eepromWriteDestinationAddr, false);
@@ -380,12 +519,9 @@ void eepromWriteProcess()
       header->fileIndex = eepromWriteFileIndex;
       header->size = eepromWriteSize;
       uint32_t size = min<uint32_t>(EEPROM_BUFFER_SIZE-sizeof(EepromFileHeader), eepromWriteSize);
-      memcpy(eepromWriteBuffer+sizeof(EepromFileHeader), eepromWriteSourceAddr, size);
-      eepromWriteState = EEPROM_WRITING_BUFFER;
-      eepromWrite(eepromWriteBuffer, eepromWriteDestinationAddr, sizeof(EepromFileHeader)+size, false);
-      eepromWriteSourceAddr += size;
-      eepromWriteDestinationAddr += sizeof(EepromFileHeader)+size;
+      eepromWriteBufferSize = sizeof(EepromFileHeader)+size;
       eepromWriteSize -= size;
+      eepromFillWriteBuffer(eepromWriteBuffer+sizeof(EepromFileHeader), size);
       break;
     }
 
@@ -393,12 +529,9 @@ void eepromWriteProcess()
     {
       uint32_t size = min<uint32_t>(EEPROM_BUFFER_SIZE, eepromWriteSize);
       if (size > 0) {
-        memcpy(eepromWriteBuffer, eepromWriteSourceAddr, size);
-        eepromWriteState = EEPROM_WRITING_BUFFER;
-        eepromWrite(eepromWriteBuffer, eepromWriteDestinationAddr, size, false);
-        eepromWriteSourceAddr += size;
-        eepromWriteDestinationAddr += size;
+        eepromWriteBufferSize = size;
         eepromWriteSize -= size;
+        eepromFillWriteBuffer(eepromWriteBuffer, size);
         break;
       }
       else if (eepromFatAddr == 0 || eepromFatAddr == EEPROM_BLOCK_SIZE) {
@@ -410,14 +543,30 @@ void eepromWriteProcess()
     /* no break */
 
     case EEPROM_WRITE_NEW_FAT:
+      // the mark is written last, an interrupted FAT write is then ignored by eepromOpen()
       eepromWriteState = EEPROM_WRITING_NEW_FAT;
-      eepromWrite((uint8_t *)&eepromHeader, eepromFatAddr, sizeof(eepromHeader), false);
+      eepromWrite((uint8_t *)&eepromHeader.index, eepromFatAddr + sizeof(eepromHeader.mark), sizeof(eepromHeader) - sizeof(eepromHeader.mark), false);
+      break;
+
+    case EEPROM_WRITE_FAT_MARK:
+      eepromWriteState = EEPROM_WRITING_FAT_MARK;
+      eepromWrite((uint8_t *)&eepromHeader.mark, eepromFatAddr, sizeof(eepromHeader.mark), false);
       break;
 
     case EEPROM_END_WRITE:
+      eepromCurrentRequest.type = EEPROM_REQUEST_NONE;
       eepromWriteState = EEPROM_IDLE;
       break;
 
+    case EEPROM_IDLE:
+      if (eepromWriteQueueCount > 0) {
+        EepromWriteRequest request = eepromWriteQueue[0];
+        eepromWriteQueueCount--;
+        memmove(&eepromWriteQueue[0], &eepromWriteQueue[1], eepromWriteQueueCount * sizeof(EepromWriteRequest));
+        eepromStartRequest(request);
+      }
+      break;
+
     default:
       break;
   }
@@ -426,9 +575,10 @@ void eepromWriteProcess()
 uint16_t eeModelSize(uint8_t index)
 {
   uint16_t result = 0;
+  int file = eepromGetQueuedFile(index+1);
 
-  if (eepromHeader.files[index+1].exists) {
-    uint32_t address = eepromHeader.files[index+1].zoneIndex * EEPROM_ZONE_SIZE;
+  if (file >= 0 && eepromHeader.files[file].exists) {
+    uint32_t address = eepromHeader.files[file].zoneIndex * EEPROM_ZONE_SIZE;
     EepromFileHeader header;
     eepromRead((uint8_t *)&header, address, sizeof(header));
     result = header.size;
@@ -546,6 +696,7 @@ const char * eeRestoreModel(uint8_t i_fileDst, char *model_name)
 
   if (eeModelExists(i_fileDst)) {
     eeDeleteModel(i_fileDst);
+    eepromWriteWait();
   }
 
   uint16_t size = min<uint16_t>(sizeof(g_model), *(uint16_t*)&buf[6]);
@@ -578,8 +729,7 @@ const char * eeRestoreModel(uint8_t i_fileDst, char *model_name)
 
   // write FAT
   eepromHeader.files[i_fileDst+1].exists = 1;
-  eepromIncFatAddr();
-  eepromWriteState = EEPROM_WRITE_NEW_FAT;
+  eepromStartFatWrite();
   eepromWriteWait();
 
   eeLoadModelHeader(i_fileDst, &modelHeaders[i_fileDst]);
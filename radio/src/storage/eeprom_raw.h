@@ -36,6 +36,7 @@ const char * eeRestoreModel(uint8_t i_fileDst, char *model_name);
 
 enum EepromWriteState {
   EEPROM_IDLE = 0,
+  EEPROM_READING_COPY_HEADER,
   EEPROM_START_WRITE,
   EEPROM_ERASING_FILE_BLOCK1,
   EEPROM_ERASING_FILE_BLOCK1_WAIT,
@@ -46,19 +47,43 @@ enum EepromWriteState {
   EEPROM_WRITING_BUFFER,
   EEPROM_WRITING_BUFFER_WAIT,
   EEPROM_WRITE_NEXT_BUFFER,
+  EEPROM_READING_BUFFER,
   EEPROM_ERASING_FAT_BLOCK,
   EEPROM_ERASING_FAT_BLOCK_WAIT,
   EEPROM_WRITE_NEW_FAT,
   EEPROM_WRITING_NEW_FAT,
   EEPROM_WRITING_NEW_FAT_WAIT,
+  EEPROM_WRITE_FAT_MARK,
+  EEPROM_WRITING_FAT_MARK,
+  EEPROM_WRITING_FAT_MARK_WAIT,
   EEPROM_END_WRITE
 };
 
+enum EepromWriteRequestType {
+  EEPROM_REQUEST_NONE,
+  EEPROM_REQUEST_WRITE_GENERAL,
+  EEPROM_REQUEST_WRITE_MODEL,
+  EEPROM_REQUEST_COPY_MODEL,
+  EEPROM_REQUEST_SWAP_MODELS,
+  EEPROM_REQUEST_DELETE_MODEL,
+};
+
+struct EepromWriteRequest {
+  uint8_t type;
+  uint8_t index1;
+  uint8_t index2;
+};
+
+#define EEPROM_WRITE_QUEUE_SIZE 8
+
 extern volatile EepromWriteState eepromWriteState;
+extern uint8_t eepromWriteQueueCount;
 inline bool eepromIsWriting()
 {
-  return (eepromWriteState != EEPROM_IDLE);
+  return (eepromWriteState != EEPROM_IDLE || eepromWriteQueueCount > 0);
 }
+// returns false when the queue is full
+bool eepromWriteRequest(uint8_t type, uint8_t index1=0, uint8_t index2=0);
 void eepromWriteProcess();
 void eepromWriteWait(EepromWriteState state = EEPROM_IDLE);
 bool eepromOpen();
@@ -23,6 +23,7 @@
 #include "opentx.h"
 #include "timers.h"
 #include "conversions/conversions.h"
+#include "rlc.h"
 
 uint8_t   s_write_err = 0;    // error reasons
 RlcFile   theFile;  //used for any file operation
@@ -449,6 +450,8 @@ const char * eeBackupModel(uint8_t i_fileSrc)
   char * buf = reusableBuffer.modelsel.mainname;
   UINT written;
 
+  storageCheck(true);
+
   // we must close the logs as we reuse the same FIL structure
   logsClose();
 
@@ -532,6 +535,8 @@ const char * eeRestoreModel(uint8_t i_fileDst, char *model_name)
   char * buf = reusableBuffer.modelsel.mainname;
   UINT read;
 
+  storageCheck(true);
+
   // we must close the logs as we reuse the same FIL structure
   logsClose();
 
@@ -626,10 +631,6 @@ void RlcFile::writeRlc(uint8_t i_fileId, uint8_t typ, uint8_t *buf, uint16_t i_l
 
 void RlcFile::nextRlcWriteStep()
 {
-  uint8_t cnt    = 1;
-  uint8_t cnt0   = 0;
-  uint16_t i = 0;
-
   if (m_cur_rlc_len) {
     uint8_t tmp1 = m_cur_rlc_len;
     uint8_t *tmp2 = m_rlc_buf;
@@ -640,41 +641,25 @@ void RlcFile::nextRlcWriteStep()
   }
 
   if (m_rlc_len>0) {
-
-    bool run0 = (m_rlc_buf[0] == 0);
-
-    for (i=1; 1; i++) {
-      bool cur0 = (i<m_rlc_len) ? (m_rlc_buf[i] == 0) : false;
-      if (cur0 != run0 || cnt==0x3f || (cnt0 && cnt==0x0f) || i==m_rlc_len) {
-        if (run0) {
-          assert(cnt0==0);
-          if (cnt<8 && i!=m_rlc_len)
-            cnt0 = cnt; //aufbew fuer spaeter
-          else {
-            m_rlc_buf+=cnt;
-            m_rlc_len-=cnt;
-            write1(cnt|0x40);
-            return;
-          }
-        }
-        else {
-          m_rlc_buf+=cnt0;
-          m_rlc_len-=cnt0+cnt;
-          m_cur_rlc_len=cnt;
-          if(cnt0){
-            write1(0x80 | (cnt0<<4) | cnt);
-          }
-          else{
-            write1(cnt);
-          }
-          return;
-        }
-        cnt=0;
-        if (i==m_rlc_len) break;
-        run0 = cur0;
-      }
-      cnt++;
+    uint8_t cnt0 = rlcCountZeroes(m_rlc_buf, m_rlc_len, 0x3f);
+    if (cnt0 >= 8 || cnt0 == m_rlc_len) {
+      m_rlc_buf+=cnt0;
+      m_rlc_len-=cnt0;
+      write1(cnt0|0x40);
+      return;
+    }
+    // less than 8 zeroes are kept for the next bytes header
+    uint8_t cnt = rlcCountBytes(m_rlc_buf+cnt0, m_rlc_len-cnt0, cnt0 ? 0x0f : 0x3f);
+    m_rlc_buf+=cnt0;
+    m_rlc_len-=cnt0+cnt;
+    m_cur_rlc_len=cnt;
+    if(cnt0){
+      write1(0x80 | (cnt0<<4) | cnt);
+    }
+    else{
+      write1(cnt);
     }
+    return;
   }
 
   switch(m_write_step) {
@@ -853,8 +838,10 @@ void eeLoadModelHeader(uint8_t id, ModelHeader *header)
   }
 }
 
+// the model operations wait for the pending writes, as the file is shared
 bool eeCopyModel(uint8_t dst, uint8_t src)
 {
+  storageCheck(true);
   if (theFile.copy(FILE_MODEL(dst), FILE_MODEL(src))) {
     memcpy(&modelHeaders[dst], &modelHeaders[src], sizeof(ModelHeader));
     return true;
@@ -866,6 +853,7 @@ bool eeCopyModel(uint8_t dst, uint8_t src)
 
 void eeSwapModels(uint8_t id1, uint8_t id2)
 {
+  storageCheck(true);
   EFile::swap(FILE_MODEL(id1), FILE_MODEL(id2));
 
   char tmp[sizeof(g_model.header)];
@@ -876,6 +864,7 @@ void eeSwapModels(uint8_t id1, uint8_t id2)
 
 void eeDeleteModel(uint8_t idx)
 {
+  storageCheck(true);
   EFile::rm(FILE_MODEL(idx));
   memset(&modelHeaders[idx], 0, sizeof(ModelHeader));
 }
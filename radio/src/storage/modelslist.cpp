@@ -24,10 +24,11 @@ using std::list;
 ModelsList modelslist;
 
 ModelCell::ModelCell(const char * name)
-  : buffer(NULL), valid_rfData(false)
+  : buffer(NULL), valid_thumbnail(false), valid_rfData(false), fileSize(0), fileTimestamp(0)
 {
   strncpy(modelFilename, name, sizeof(modelFilename));
   memset(modelName, 0, sizeof(modelName));
+  memset(&thumbnail, 0, sizeof(thumbnail));
 }
 
 ModelCell::~ModelCell()
@@ -60,16 +61,167 @@ void ModelCell::resetBuffer()
     delete buffer;
     buffer = NULL;
   }
+  valid_thumbnail = false;
+}
+
+bool ModelCell::isCurrent()
+{
+  return strncmp(modelFilename, g_eeGeneral.currModelFilename, LEN_MODEL_FILENAME) == 0;
 }
 
 const BitmapBuffer * ModelCell::getBuffer()
 {
   if (!buffer) {
-    loadBitmap();
+    if (isCurrent()) {
+      // the current model is drawn from g_model
+      loadBitmap();
+    }
+    else {
+      // the thumbnail is shown as is, it will be checked later by refreshBuffer()
+      if (!loadThumbnail(true)) {
+        valid_thumbnail = false;
+      }
+    }
   }
   return buffer;
 }
 
+// Checks the thumbnail against the model file, the bitmap file and the theme colors, and
+// renders the cell again when it is outdated. The buffer is kept in RAM only when asked,
+// returns true when a new buffer is available
+bool ModelCell::refreshBuffer(bool keep)
+{
+  if (valid_thumbnail)
+    return false;
+
+  if (isCurrent()) {
+    // no thumbnail for the current model, see getBuffer()
+    valid_thumbnail = true;
+    return false;
+  }
+
+  bool hadBuffer = (buffer != NULL);
+  bool changed = false;
+
+  if (!hadBuffer) {
+    changed = loadThumbnail(keep) && keep;
+  }
+
+  ModelThumbnailHeader key;
+  getThumbnailKey(&key, thumbnail.bitmap);
+  if (memcmp(&key, &thumbnail, sizeof(key))) {
+    if (buffer) {
+      delete buffer;
+      buffer = NULL;
+    }
+    loadBitmap();
+    saveThumbnail();
+    changed = true;
+  }
+
+  if (!keep && !hadBuffer && buffer) {
+    delete buffer;
+    buffer = NULL;
+  }
+
+  valid_thumbnail = true;
+  return changed && buffer;
+}
+
+void ModelCell::getThumbnailKey(ModelThumbnailHeader * header, const char * bitmap)
+{
+  static FILINFO fno;
+  char path[256];
+
+  memclear(header, sizeof(ModelThumbnailHeader));
+  memcpy(header->magic, "OTXT", sizeof(header->magic));
+  header->version = MODEL_THUMBNAIL_VERSION;
+  header->colors = crc16(CRC_1021, (const uint8_t *)lcdColorTable, sizeof(lcdColorTable));
+  header->width = MODELCELL_WIDTH;
+  header->height = MODELCELL_HEIGHT;
+
+  getModelPath(path, modelFilename);
+  if (f_stat(path, &fno) == FR_OK) {
+    header->modelFileSize = fno.fsize;
+    header->modelFileTimestamp = (uint32_t(fno.fdate) << 16) + fno.ftime;
+  }
+
+  memcpy(header->bitmap, bitmap, LEN_BITMAP_NAME);
+  GET_FILENAME(filename, BITMAPS_PATH, header->bitmap, "");
+  if (f_stat(filename, &fno) == FR_OK) {
+    header->bitmapFileSize = fno.fsize;
+    header->bitmapFileTimestamp = (uint32_t(fno.fdate) << 16) + fno.ftime;
+  }
+}
+
+bool ModelCell::loadThumbnail(bool pixels)
+{
+  GET_FILENAME(path, THUMBNAILS_PATH, modelFilename, "");
+  FIL file;
+  UINT read;
+
+  if (f_open(&file, path, FA_OPEN_EXISTING | FA_READ) != FR_OK) {
+    memclear(&thumbnail, sizeof(thumbnail));
+    return false;
+  }
+
+  bool result = (f_read(&file, &thumbnail, sizeof(thumbnail), &read) == FR_OK && read == sizeof(thumbnail) &&
+                 !memcmp(thumbnail.magic, "OTXT", sizeof(thumbnail.magic)) &&
+                 thumbnail.version == MODEL_THUMBNAIL_VERSION &&
+                 thumbnail.width == MODELCELL_WIDTH && thumbnail.height == MODELCELL_HEIGHT);
+
+  if (result && pixels) {
+    buffer = new BitmapBuffer(BMP_RGB565, MODELCELL_WIDTH, MODELCELL_HEIGHT);
+    if (buffer == NULL) {
+      result = false;
+    }
+    else if (f_read(&file, buffer->getData(), buffer->getDataSize(), &read) != FR_OK || read != buffer->getDataSize()) {
+      delete buffer;
+      buffer = NULL;
+      result = false;
+    }
+  }
+
+  if (!result) {
+    memclear(&thumbnail, sizeof(thumbnail));
+  }
+
+  f_close(&file);
+  return result;
+}
+
+void ModelCell::saveThumbnail()
+{
+  // no thumbnail for the invalid models
+  if (!buffer || thumbnail.version != MODEL_THUMBNAIL_VERSION)
+    return;
+
+  sdCheckAndCreateDirectory(THUMBNAILS_PATH);
+
+  GET_FILENAME(path, THUMBNAILS_PATH, modelFilename, "");
+  FIL file;
+  UINT written;
+
+  if (f_open(&file, path, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+    return;
+
+  if (f_write(&file, &thumbnail, sizeof(thumbnail), &written) != FR_OK || written != sizeof(thumbnail) ||
+      f_write(&file, buffer->getData(), buffer->getDataSize(), &written) != FR_OK || written != buffer->getDataSize()) {
+    f_close(&file);
+    f_unlink(path);
+    return;
+  }
+
+  f_close(&file);
+}
+
+void ModelCell::removeThumbnail()
+{
+  GET_FILENAME(path, THUMBNAILS_PATH, modelFilename, "");
+  f_unlink(path);
+  valid_thumbnail = false;
+}
+
 void ModelCell::loadBitmap()
 {
   uint8_t version;
@@ -102,10 +254,12 @@ void ModelCell::loadBitmap()
   buffer->clear(TEXT_BGCOLOR);
 
   if (error) {
+    memclear(&thumbnail, sizeof(thumbnail));
     buffer->drawText(5, 2, "(Invalid Model)", TEXT_COLOR);
     buffer->drawBitmapPattern(5, 23, LBM_LIBRARY_SLOT, TEXT_COLOR);
   }
   else {
+    getThumbnailKey(&thumbnail, partialmodel.header.bitmap);
     char timer[LEN_TIMER_STRING];
     buffer->drawSizedText(5, 2, modelName, LEN_MODEL_NAME, SMLSIZE|TEXT_COLOR);
     getTimerString(timer, 0);
@@ -162,53 +316,29 @@ void ModelCell::setRfModuleData(uint8_t moduleIdx, ModuleData* modData)
   }
 }
 
+// the model file is read with its journal, which holds the latest changes
 bool ModelCell::fetchRfData()
 {
   //TODO: use g_model in case fetching data for current model
   //
-  char buf[256];
-  getModelPath(buf, modelFilename);
-
-  FIL      file;
-  uint16_t size;
-  uint8_t  version;
-
-  const char * err = openFile(buf, &file, &size, &version);
-  if (err || version != EEPROM_VER) return false;
-
-  FSIZE_t start_offset = f_tell(&file);
-
-  UINT read;
-  if ((f_read(&file, buf, LEN_MODEL_NAME, &read) != FR_OK) || (read != LEN_MODEL_NAME))
-    goto error;
+  ModelHeader header;
+  ModuleData modules[NUM_MODULES];
+  uint8_t version;
 
-  setModelName(buf);
+  if (readModelData(modelFilename, offsetof(ModelData, header), (uint8_t *)&header, sizeof(header), &version) || version != EEPROM_VER)
+    return false;
 
-  // 1. fetch modelId: NUM_MODULES @ offsetof(ModelHeader, modelId)
-  // if (f_lseek(&file, start_offset + offsetof(ModelHeader, modelId)) != FR_OK)
-  //   goto error;
-  if ((f_read(&file, modelId, NUM_MODULES, &read) != FR_OK) || (read != NUM_MODULES))
-    goto error;
+  if (readModelData(modelFilename, offsetof(ModelData, moduleData), (uint8_t *)modules, sizeof(modules), &version))
+    return false;
 
-  // 2. fetch ModuleData: sizeof(ModuleData)*NUM_MODULES @ offsetof(ModelData, moduleData)
-  if (f_lseek(&file, start_offset + offsetof(ModelData, moduleData)) != FR_OK)
-    goto error;
-
-  for(uint8_t i=0; i<NUM_MODULES; i++) {
-    ModuleData modData;
-    if ((f_read(&file, &modData, NUM_MODULES, &read) != FR_OK) || (read != NUM_MODULES))
-      goto error;
-
-    setRfModuleData(i, &modData);
+  setModelName(header.name);
+  memcpy(modelId, header.modelId, sizeof(modelId));
+  for (uint8_t i=0; i<NUM_MODULES; i++) {
+    setRfModuleData(i, &modules[i]);
   }
 
-  valid_rfData = true;  
-  f_close(&file);
+  valid_rfData = true;
   return true;
-  
- error:
-  f_close(&file);
-  return false;  
 }
 
 ModelsCategory::ModelsCategory(const char * name)
@@ -233,6 +363,7 @@ ModelCell * ModelsCategory::addModel(const char * name)
 
 void ModelsCategory::removeModel(ModelCell * model)
 {
+  model->removeThumbnail();
   delete model;
   remove(model);
 }
@@ -332,9 +463,6 @@ bool ModelsList::load()
           currentCategory = category;
           currentModel = model;
         }
-        //parseModulesData(model, rf_data_str);
-        //TRACE("model=<%s>, valid_rfData=<%i>",model->modelFilename,model->valid_rfData);
-        model->fetchRfData();
         modelsCount += 1;
       }
     }
@@ -343,6 +471,9 @@ bool ModelsList::load()
     if (!getCurrentModel()) {
       TRACE("currentModel is NULL");
     }
+
+    loadRfData();
+    removeOrphanThumbnails();
   }
 
   if (categories.size() == 0) {
@@ -366,6 +497,228 @@ void ModelsList::save()
   }
 
   f_close(&file);
+
+  saveCache();
+}
+
+ModelCell * ModelsList::findModel(const char * filename) const
+{
+  for (list<ModelsCategory *>::const_iterator cat_it = categories.begin(); cat_it != categories.end(); ++cat_it) {
+    for (ModelsCategory::const_iterator it = (*cat_it)->begin(); it != (*cat_it)->end(); ++it) {
+      if (!strncmp((*it)->modelFilename, filename, LEN_MODEL_FILENAME)) {
+        return *it;
+      }
+    }
+  }
+  return NULL;
+}
+
+// The RF data are taken from the models cache for all the models files which didn't change
+// (same size, same date) since the cache was written. Only the other ones are read.
+void ModelsList::loadRfData()
+{
+  bool changed = !loadCache();
+
+  DIR dir;
+  static FILINFO fno;
+
+  if (f_opendir(&dir, MODELS_PATH) == FR_OK) {
+    for (;;) {
+      FRESULT res = f_readdir(&dir, &fno);
+      if (res != FR_OK || fno.fname[0] == 0) {
+        break;
+      }
+      if (fno.fattrib & AM_DIR) {
+        continue;
+      }
+      ModelCell * model = findModel(fno.fname);
+      if (model) {
+        uint32_t timestamp = (uint32_t(fno.fdate) << 16) + fno.ftime;
+        if (fno.fsize && model->fileSize == fno.fsize && model->fileTimestamp == timestamp) {
+          model->valid_rfData = true;
+        }
+        else {
+          model->fileSize = fno.fsize;
+          model->fileTimestamp = timestamp;
+        }
+      }
+    }
+    f_closedir(&dir);
+  }
+
+  for (list<ModelsCategory *>::iterator cat_it = categories.begin(); cat_it != categories.end(); ++cat_it) {
+    for (ModelsCategory::iterator it = (*cat_it)->begin(); it != (*cat_it)->end(); ++it) {
+      ModelCell * model = *it;
+      if (model == currentModel) {
+        // the current model is already in RAM
+        uint8_t modelId[NUM_MODULES];
+        SimpleModuleData moduleData[NUM_MODULES];
+        memcpy(modelId, model->modelId, sizeof(modelId));
+        memcpy(moduleData, model->moduleData, sizeof(moduleData));
+        bool valid = model->valid_rfData;
+        model->setModelName(g_model.header.name);
+        model->setRfData(&g_model);
+        if (!valid || memcmp(modelId, model->modelId, sizeof(modelId)) || memcmp(moduleData, model->moduleData, sizeof(moduleData))) {
+          changed = true;
+        }
+      }
+      else if (!model->valid_rfData) {
+        model->fetchRfData();
+        changed = true;
+      }
+    }
+  }
+
+  if (changed) {
+    saveCache();
+  }
+}
+
+static void removeThumbnailFile(const char * filename)
+{
+  char path[sizeof(THUMBNAILS_PATH) + _MAX_LFN + 1];
+  strcpy(path, THUMBNAILS_PATH "/");
+  strncat(path, filename, _MAX_LFN);
+  f_unlink(path);
+}
+
+// The model files deleted or renamed from the SD manager
+void removeModelThumbnail(const char * path)
+{
+  if (!strncmp(path, MODELS_PATH "/", sizeof(MODELS_PATH))) {
+    removeThumbnailFile(path + sizeof(MODELS_PATH));
+  }
+}
+
+// The thumbnails of the models deleted or renamed outside the radio
+void ModelsList::removeOrphanThumbnails()
+{
+  DIR dir;
+  static FILINFO fno;
+
+  if (f_opendir(&dir, THUMBNAILS_PATH) != FR_OK)
+    return;
+
+  for (;;) {
+    FRESULT res = f_readdir(&dir, &fno);
+    if (res != FR_OK || fno.fname[0] == 0) {
+      break;
+    }
+    if (!(fno.fattrib & AM_DIR) && !findModel(fno.fname)) {
+      removeThumbnailFile(fno.fname);
+    }
+  }
+
+  f_closedir(&dir);
+}
+
+// Returns false when the cache has to be written again: missing, invalid, or with entries
+// for models which are not in the list anymore
+bool ModelsList::loadCache()
+{
+  bool complete = true;
+  FIL cacheFile;
+  ModelsCacheHeader header;
+  ModelsCacheEntry entry;
+  UINT read;
+
+  if (f_open(&cacheFile, RADIO_MODELSCACHE_PATH, FA_OPEN_EXISTING | FA_READ) != FR_OK)
+    return false;
+
+  if (f_read(&cacheFile, &header, sizeof(header), &read) != FR_OK || read != sizeof(header) ||
+      memcmp(header.magic, "OTXM", sizeof(header.magic)) ||
+      header.version != MODELS_CACHE_VERSION ||
+      header.entrySize != sizeof(ModelsCacheEntry))
+    goto error;
+
+  // the entries are checked before being used
+  {
+    uint16_t checksum = 0;
+    for (uint16_t i = 0; i < header.count; i++) {
+      if (f_read(&cacheFile, &entry, sizeof(entry), &read) != FR_OK || read != sizeof(entry))
+        goto error;
+      checksum = crc16(CRC_1021, (const uint8_t *)&entry, sizeof(entry), checksum);
+    }
+    if (checksum != header.checksum)
+      goto error;
+  }
+
+  if (f_lseek(&cacheFile, sizeof(header)) != FR_OK)
+    goto error;
+
+  for (uint16_t i = 0; i < header.count; i++) {
+    if (f_read(&cacheFile, &entry, sizeof(entry), &read) != FR_OK || read != sizeof(entry))
+      goto error;
+    ModelCell * model = findModel(entry.modelFilename);
+    if (model) {
+      strncpy(model->modelName, entry.modelName, LEN_MODEL_NAME);
+      memcpy(model->modelId, entry.modelId, sizeof(model->modelId));
+      memcpy(model->moduleData, entry.moduleData, sizeof(model->moduleData));
+      model->fileSize = entry.fileSize;
+      model->fileTimestamp = entry.fileTimestamp;
+    }
+    else {
+      complete = false;
+    }
+  }
+
+  f_close(&cacheFile);
+  return complete;
+
+ error:
+  TRACE("models cache invalid");
+  f_close(&cacheFile);
+  return false;
+}
+
+void ModelsList::saveCache()
+{
+  FIL cacheFile;
+  ModelsCacheHeader header;
+  ModelsCacheEntry entry;
+  UINT written;
+
+  if (f_open(&cacheFile, RADIO_MODELSCACHE_PATH, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+    return;
+
+  memcpy(header.magic, "OTXM", sizeof(header.magic));
+  header.version = MODELS_CACHE_VERSION;
+  header.entrySize = sizeof(ModelsCacheEntry);
+  header.count = 0;
+  header.checksum = 0;
+
+  // the header is written again at the end, once the entries count and checksum are known
+  if (f_write(&cacheFile, &header, sizeof(header), &written) != FR_OK)
+    goto error;
+
+  for (list<ModelsCategory *>::iterator cat_it = categories.begin(); cat_it != categories.end(); ++cat_it) {
+    for (ModelsCategory::iterator it = (*cat_it)->begin(); it != (*cat_it)->end(); ++it) {
+      ModelCell * model = *it;
+      if (!model->valid_rfData)
+        continue;
+      memclear(&entry, sizeof(entry));
+      strncpy(entry.modelFilename, model->modelFilename, LEN_MODEL_FILENAME);
+      strncpy(entry.modelName, model->modelName, LEN_MODEL_NAME);
+      memcpy(entry.modelId, model->modelId, sizeof(entry.modelId));
+      memcpy(entry.moduleData, model->moduleData, sizeof(entry.moduleData));
+      entry.fileSize = model->fileSize;
+      entry.fileTimestamp = model->fileTimestamp;
+      if (f_write(&cacheFile, &entry, sizeof(entry), &written) != FR_OK)
+        goto error;
+      header.checksum = crc16(CRC_1021, (const uint8_t *)&entry, sizeof(entry), header.checksum);
+      header.count++;
+    }
+  }
+
+  if (f_lseek(&cacheFile, 0) != FR_OK || f_write(&cacheFile, &header, sizeof(header), &written) != FR_OK)
+    goto error;
+
+  f_close(&cacheFile);
+  return;
+
+ error:
+  f_close(&cacheFile);
+  f_unlink(RADIO_MODELSCACHE_PATH);
 }
 
 void ModelsList::setCurrentCategorie(ModelsCategory* cat)
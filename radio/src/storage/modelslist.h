@@ -31,23 +31,68 @@
 // modelXXXXXXX.bin F,FF F,3F,FF\r\n
 #define LEN_MODELS_IDX_LINE (LEN_MODEL_FILENAME + sizeof(" F,FF F,3F,FF\r\n")-1)
 
+#define MODELS_CACHE_VERSION           1
+#define MODEL_THUMBNAIL_VERSION        1
+
 struct SimpleModuleData
 {
   uint8_t type;
   uint8_t rfProtocol;
 };
 
+// models.idx: the models RF data, kept with the size and date of the model file they were read from
+PACK(struct ModelsCacheHeader
+{
+  char     magic[4];
+  uint8_t  version;
+  uint8_t  entrySize;
+  uint16_t count;
+  uint16_t checksum;
+});
+
+PACK(struct ModelsCacheEntry
+{
+  char             modelFilename[LEN_MODEL_FILENAME];
+  char             modelName[LEN_MODEL_NAME];
+  uint8_t          modelId[NUM_MODULES];
+  SimpleModuleData moduleData[NUM_MODULES];
+  uint32_t         fileSize;
+  uint32_t         fileTimestamp;
+});
+
+// THUMBS/modelXX.bin: the rendered model cell (RGB565 pixels follow the header), valid as long
+// as the model file, the model bitmap file and the theme colors didn't change
+PACK(struct ModelThumbnailHeader
+{
+  char     magic[4];
+  uint8_t  version;
+  uint8_t  spare;
+  uint16_t colors;
+  uint16_t width;
+  uint16_t height;
+  uint32_t modelFileSize;
+  uint32_t modelFileTimestamp;
+  char     bitmap[LEN_BITMAP_NAME];
+  uint32_t bitmapFileSize;
+  uint32_t bitmapFileTimestamp;
+});
+
 class ModelCell
 {
 public:
   char modelFilename[LEN_MODEL_FILENAME+1];
   char modelName[LEN_MODEL_NAME+1];
   BitmapBuffer * buffer;
+  bool valid_thumbnail; // the thumbnail on SD is up to date, as well as the buffer if any
+  ModelThumbnailHeader thumbnail;
 
   bool             valid_rfData;
   uint8_t          modelId[NUM_MODULES];
   SimpleModuleData moduleData[NUM_MODULES];
 
+  uint32_t         fileSize;
+  uint32_t         fileTimestamp; // FatFs fdate << 16 | ftime
+
   ModelCell(const char * name);
   ~ModelCell();
 
@@ -62,7 +107,15 @@ public:
   bool  fetchRfData();
   void  loadBitmap();
   const BitmapBuffer * getBuffer();
+  bool  refreshBuffer(bool keep);
   void  resetBuffer();
+  void  removeThumbnail();
+
+protected:
+  bool  isCurrent();
+  void  getThumbnailKey(ModelThumbnailHeader * header, const char * bitmap);
+  bool  loadThumbnail(bool pixels);
+  void  saveThumbnail();
 };
 
 class ModelsCategory: public std::list<ModelCell *>
@@ -89,6 +142,11 @@ class ModelsList
 
   void init();
 
+  void loadRfData();
+  bool loadCache();
+  void saveCache();
+  void removeOrphanThumbnails();
+
 public:
 
   ModelsList();
@@ -118,6 +176,8 @@ public:
   
   bool readNextLine(char * line, int maxlen);
 
+  ModelCell * findModel(const char * filename) const;
+
   ModelsCategory * createCategory();
   void removeCategory(ModelsCategory * category);
 
@@ -138,4 +198,6 @@ protected:
 
 extern ModelsList modelslist;
 
+void removeModelThumbnail(const char * path);
+
 #endif // _MODELSLIST_H_
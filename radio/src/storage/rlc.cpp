@@ -19,11 +19,11 @@
  */
 
 #include <inttypes.h>
-#include <assert.h>
 #include "debug.h"
+#include "rlc.h"
 
-#define CHECK_DST_SIZE() \
-  if (cur-dst >= (int)dstsize) { \
+#define CHECK_DST_SIZE(size) \
+  if ((unsigned int)(cur-dst) + (size) > dstsize) { \
     TRACE("RLC encoding size too big"); \
     return 0; \
   }
@@ -31,51 +31,39 @@
 unsigned int compress(uint8_t * dst, unsigned int dstsize, const uint8_t * src, unsigned int srcsize)
 {
   uint8_t * cur = dst;
-  bool    run0   = (src[0] == 0);
-  uint8_t cnt    = 1;
-  uint8_t cnt0   = 0;
+  unsigned int i = 0;
 
-  for (unsigned int i=1; 1; i++) {
-    bool cur0 = (i < srcsize) ? (src[i] == 0) : false;
-    if (i==srcsize || cur0!=run0 || cnt==0x3f || (cnt0 && cnt==0xf)) {
-      if (run0) {
-        assert(cnt0==0);
-        if (cnt<8 && i!=srcsize) {
-          cnt0 = cnt;
-        }
-        else {
-          CHECK_DST_SIZE();
-          *cur++ = (cnt | 0x40);
-        }
-      }
-      else {
-        if (cnt0) {
-          CHECK_DST_SIZE();
-          *cur++ = (0x80 | (cnt0<<4) | cnt);
-          cnt0 = 0;
-        }
-        else {
-          CHECK_DST_SIZE();
-          *cur++ = cnt;
-        }
-        for (int j=0; j<cnt; j++) {
-          CHECK_DST_SIZE();
-          *cur++ = src[i - cnt + j];
-        }
-      }
-      cnt = 0;
-      if (i==srcsize) break;
-      run0 = cur0;
+  while (i < srcsize) {
+    unsigned int zeroes = rlcCountZeroes(&src[i], srcsize-i, 0x3f);
+    unsigned int count;
+    if (zeroes >= 8 || i+zeroes == srcsize) {
+      CHECK_DST_SIZE(1);
+      *cur++ = (zeroes | 0x40);
+      i += zeroes;
+      continue;
     }
-    cnt++;
+    else if (zeroes) {
+      count = rlcCountBytes(&src[i+zeroes], srcsize-i-zeroes, 0x0f);
+      CHECK_DST_SIZE(1 + count);
+      *cur++ = (0x80 | (zeroes<<4) | count);
+    }
+    else {
+      count = rlcCountBytes(&src[i], srcsize-i, 0x3f);
+      CHECK_DST_SIZE(1 + count);
+      *cur++ = count;
+    }
+    i += zeroes;
+    memcpy(cur, &src[i], count);
+    cur += count;
+    i += count;
   }
 
   return cur-dst;
 }
 
 #undef CHECK_DST_SIZE
-#define CHECK_DST_SIZE() \
-  if (cur-dst >= (int)dstsize) { \
+#define CHECK_DST_SIZE(size) \
+  if ((unsigned int)(cur-dst) + (size) > dstsize) { \
     TRACE("RLC decoding size too big"); \
     return 0; \
   }
@@ -83,31 +71,9 @@ unsigned int compress(uint8_t * dst, unsigned int dstsize, const uint8_t * src,
 unsigned int uncompress(uint8_t * dst, unsigned int dstsize, const uint8_t * src, unsigned int srcsize)
 {
   uint8_t * cur = dst;
-  uint8_t zeroes = 0;
-  uint8_t bRlc = 0;
-
-  for( ; 1; ) {
-    if (zeroes > 0) {
-      for (int i = 0; i < zeroes; i++) {
-        CHECK_DST_SIZE();
-        *cur++ = 0;
-      }
-      zeroes = 0;
-    }
-
-    if (srcsize == 0) {
-      return cur - dst;
-    }
 
-    for (int i=0; i<bRlc; i++) {
-      CHECK_DST_SIZE();
-      *cur++ = *src++;
-      if (--srcsize == 0) {
-        return cur - dst;
-      }
-    }
-
-    bRlc = *src++;
+  while (srcsize > 0) {
+    uint8_t bRlc = *src++;
     --srcsize;
 
     if (!(bRlc & 0x7f)) {
@@ -115,6 +81,7 @@ unsigned int uncompress(uint8_t * dst, unsigned int dstsize, const uint8_t * src
       return 0;
     }
 
+    uint8_t zeroes = 0;
     if (bRlc & 0x80) { // if contains high byte
       zeroes  = (bRlc>>4) & 0x07;
       bRlc    = bRlc & 0x0f;
@@ -123,7 +90,22 @@ unsigned int uncompress(uint8_t * dst, unsigned int dstsize, const uint8_t * src
       zeroes = bRlc & 0x3f;
       bRlc   = 0;
     }
+
+    CHECK_DST_SIZE(zeroes);
+    memset(cur, 0, zeroes);
+    cur += zeroes;
+
+    // a truncated source is not an error, we stop at its end
+    if (bRlc > srcsize)
+      bRlc = srcsize;
+    CHECK_DST_SIZE(bRlc);
+    memcpy(cur, src, bRlc);
+    cur += bRlc;
+    src += bRlc;
+    srcsize -= bRlc;
   }
+
+  return cur - dst;
 }
 
 #undef CHECK_DST_SIZE
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) OpenTX
+ *
+ * Based on code named
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef _RLC_H_
+#define _RLC_H_
+
+#include <inttypes.h>
+#include <string.h>
+
+// RLC codes:
+//   0x00-0x3f         n bytes follow
+//   0x40-0x7f         n zeroes
+//   0x80-0xff   1zzznnnn  z zeroes (<8) then n bytes follow (<16)
+
+// number of zero bytes at the start of buf (at most max), words are
+// loaded little endian so the lowest set bit gives the first byte
+inline unsigned int rlcCountZeroes(const uint8_t * buf, unsigned int len, unsigned int max)
+{
+  if (len > max)
+    len = max;
+  unsigned int i = 0;
+  for (; i+4 <= len; i += 4) {
+    uint32_t word;
+    memcpy(&word, &buf[i], sizeof(word));
+    if (word)
+      return i + (__builtin_ctz(word) >> 3);
+  }
+  while (i < len && buf[i] == 0)
+    i++;
+  return i;
+}
+
+// number of non-zero bytes at the start of buf (at most max)
+inline unsigned int rlcCountBytes(const uint8_t * buf, unsigned int len, unsigned int max)
+{
+  if (len > max)
+    len = max;
+  unsigned int i = 0;
+  for (; i+4 <= len; i += 4) {
+    uint32_t word;
+    memcpy(&word, &buf[i], sizeof(word));
+    // the lowest flagged byte is always the first zero one
+    uint32_t zeroes = (word - 0x01010101) & ~word & 0x80808080;
+    if (zeroes)
+      return i + (__builtin_ctz(zeroes) >> 3);
+  }
+  while (i < len && buf[i] != 0)
+    i++;
+  return i;
+}
+
+#endif // _RLC_H_
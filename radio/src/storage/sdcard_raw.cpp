@@ -22,6 +22,26 @@
 #include "modelslist.h"
 #include "conversions/conversions.h"
 
+// The periodic saves of the current model (trims, timers...) only append the
+// changed bytes to the model file, as records with a CRC. A torn record at the
+// end of the file is ignored when loading. The file is rewritten in full when
+// the journal is too big and on immediate saves (model switch, power off).
+
+#define JOURNAL_MAX_SIZE               1024
+#define JOURNAL_RECORD_MAX_SIZE        64
+#define JOURNAL_INVALID                0xFFFF
+
+PACK(struct JournalRecord {
+  uint16_t offset;
+  uint8_t size;
+  uint8_t crc;
+});
+
+// the current model as it is on the SD card (file + journal)
+ModelData storageModel __SDRAM;
+char storageModelFilename[LEN_MODEL_FILENAME];
+uint16_t storageModelJournalSize = JOURNAL_INVALID;
+
 void getModelPath(char * path, const char * filename)
 {
   strcpy(path, STR_MODELS_PATH);
@@ -67,7 +87,111 @@ const char * writeModel()
 {
   char path[256];
   getModelPath(path, g_eeGeneral.currModelFilename);
-  return writeFile(path, (uint8_t *)&g_model, sizeof(g_model));
+  const char * error = writeFile(path, (uint8_t *)&g_model, sizeof(g_model));
+  if (error) {
+    storageModelJournalSize = JOURNAL_INVALID;
+  }
+  else {
+    memcpy(&storageModel, &g_model, sizeof(storageModel));
+    memcpy(storageModelFilename, g_eeGeneral.currModelFilename, LEN_MODEL_FILENAME);
+    storageModelJournalSize = 0;
+  }
+  return error;
+}
+
+static uint8_t getJournalRecordCrc(const JournalRecord & record, const uint8_t * data)
+{
+  return crc8(data, record.size, crc8((const uint8_t *)&record, offsetof(JournalRecord, crc)));
+}
+
+// finds the next range of changed bytes, close ranges are merged in one record
+static bool getNextModelChange(uint16_t & offset, uint8_t & size)
+{
+  const uint8_t * data = (const uint8_t *)&g_model;
+  const uint8_t * previous = (const uint8_t *)&storageModel;
+
+  while (offset < sizeof(ModelData) && data[offset] == previous[offset])
+    offset++;
+
+  if (offset == sizeof(ModelData))
+    return false;
+
+  uint16_t last = offset;
+  for (uint16_t i=offset+1; i<sizeof(ModelData) && i-offset<JOURNAL_RECORD_MAX_SIZE; i++) {
+    if (data[i] != previous[i])
+      last = i;
+    else if (i - last > sizeof(JournalRecord))
+      break;
+  }
+
+  size = last + 1 - offset;
+  return true;
+}
+
+static const char * writeModelChanges()
+{
+  if (storageModelJournalSize == JOURNAL_INVALID || memcmp(storageModelFilename, g_eeGeneral.currModelFilename, LEN_MODEL_FILENAME)) {
+    return writeModel();
+  }
+
+  uint16_t journalSize = storageModelJournalSize;
+  uint16_t offset = 0;
+  uint8_t size;
+  while (getNextModelChange(offset, size)) {
+    journalSize += sizeof(JournalRecord) + size;
+    offset += size;
+  }
+
+  if (journalSize == storageModelJournalSize) {
+    return nullptr;
+  }
+
+  if (journalSize > JOURNAL_MAX_SIZE) {
+    TRACE("Model journal full");
+    return writeModel();
+  }
+
+  char path[256];
+  getModelPath(path, g_eeGeneral.currModelFilename);
+
+  FIL file;
+  FRESULT result = f_open(&file, path, FA_OPEN_EXISTING | FA_WRITE);
+  if (result != FR_OK) {
+    return writeModel();
+  }
+
+  // the file could have been modified behind our back
+  if (f_size(&file) != 8 + sizeof(ModelData) + storageModelJournalSize || f_lseek(&file, f_size(&file)) != FR_OK) {
+    f_close(&file);
+    return writeModel();
+  }
+
+  offset = 0;
+  while (getNextModelChange(offset, size)) {
+    JournalRecord record;
+    record.offset = offset;
+    record.size = size;
+    record.crc = getJournalRecordCrc(record, (const uint8_t *)&g_model + offset);
+
+    UINT written;
+    result = f_write(&file, &record, sizeof(record), &written);
+    if (result == FR_OK && written == sizeof(record)) {
+      result = f_write(&file, (const uint8_t *)&g_model + offset, size, &written);
+    }
+    if (result != FR_OK || written != size) {
+      f_close(&file);
+      storageModelJournalSize = JOURNAL_INVALID;
+      return SDCARD_ERROR(result);
+    }
+
+    memcpy((uint8_t *)&storageModel + offset, (const uint8_t *)&g_model + offset, size);
+    offset += size;
+  }
+
+  f_close(&file);
+  TRACE("Model journal %d bytes", journalSize);
+  storageModelJournalSize = journalSize;
+  return nullptr;
 }
 
 const char * openFile(const char * fullpath, FIL * file, uint16_t * size, uint8_t * version)
@@ -101,7 +225,43 @@ const char * openFile(const char * fullpath, FIL * file, uint16_t * size, uint8_
   return nullptr;
 }
 
-const char * loadFile(const char * fullpath, uint8_t * data, uint16_t maxsize, uint8_t * version)
+// data holds the bytes [start, start+count[ of the file data
+static bool applyJournalRecord(const JournalRecord & record, const uint8_t * buf, uint8_t * data, uint16_t size, uint16_t start, uint16_t count)
+{
+  if (record.size > JOURNAL_RECORD_MAX_SIZE || record.offset + record.size > size)
+    return false;
+  if (getJournalRecordCrc(record, buf) != record.crc)
+    return false;
+  uint16_t first = max<uint16_t>(record.offset, start);
+  uint16_t last = min<uint16_t>(record.offset + record.size, start + count);
+  if (first < last)
+    memcpy(&data[first - start], &buf[first - record.offset], last - first);
+  return true;
+}
+
+// applies the records appended after the data, returns the journal size
+// or JOURNAL_INVALID if a record is corrupted
+static uint16_t loadJournal(FIL * file, uint8_t * data, uint16_t size, uint16_t start, uint16_t count)
+{
+  uint16_t journalSize = 0;
+  JournalRecord record;
+  uint8_t buf[JOURNAL_RECORD_MAX_SIZE];
+  UINT read;
+
+  while (f_read(file, &record, sizeof(record), &read) == FR_OK && read > 0) {
+    if (read != sizeof(record) || record.size > JOURNAL_RECORD_MAX_SIZE)
+      return JOURNAL_INVALID;
+    if (f_read(file, buf, record.size, &read) != FR_OK || read != record.size)
+      return JOURNAL_INVALID;
+    if (!applyJournalRecord(record, buf, data, size, start, count))
+      return JOURNAL_INVALID;
+    journalSize += sizeof(record) + record.size;
+  }
+
+  return journalSize;
+}
+
+const char * loadFile(const char * fullpath, uint8_t * data, uint16_t maxsize, uint8_t * version, uint16_t * journalSize = nullptr)
 {
   FIL      file;
   UINT     read;
@@ -113,6 +273,7 @@ const char * loadFile(const char * fullpath, uint8_t * data, uint16_t maxsize, u
   if (err)
     return err;
 
+  uint16_t storedSize = size;
   size = min<uint16_t>(maxsize, size);
   FRESULT result = f_read(&file, data, size, &read);
   if (result != FR_OK || read != size) {
@@ -120,27 +281,84 @@ const char * loadFile(const char * fullpath, uint8_t * data, uint16_t maxsize, u
     return SDCARD_ERROR(result);
   }
 
+  // the journal is also applied when only the beginning of the data is read
+  uint16_t journal = JOURNAL_INVALID;
+  if (size == storedSize || f_lseek(&file, 8 + storedSize) == FR_OK) {
+    journal = loadJournal(&file, data, storedSize, 0, size);
+  }
+  if (journalSize) {
+    *journalSize = (storedSize == maxsize ? journal : JOURNAL_INVALID);
+  }
+
   f_close(&file);
   return nullptr;
 }
 
-const char * readModel(const char * filename, uint8_t * buffer, uint32_t size, uint8_t * version)
+const char * readModel(const char * filename, uint8_t * buffer, uint32_t size, uint8_t * version, uint16_t * journalSize)
 {
   char path[256];
   getModelPath(path, filename);
-  return loadFile(path, buffer, size, version);
+  return loadFile(path, buffer, size, version, journalSize);
+}
+
+// reads the bytes [offset, offset+size[ of a model data, with the changes of its journal
+const char * readModelData(const char * filename, uint16_t offset, uint8_t * data, uint16_t size, uint8_t * version)
+{
+  char path[256];
+  getModelPath(path, filename);
+
+  FIL file;
+  UINT read;
+  uint16_t storedSize;
+
+  const char * err = openFile(path, &file, &storedSize, version);
+  if (err)
+    return err;
+
+  if (offset + size > storedSize) {
+    f_close(&file);
+    return STR_INCOMPATIBLE;
+  }
+
+  FRESULT result = f_lseek(&file, 8 + offset);
+  if (result == FR_OK) {
+    result = f_read(&file, data, size, &read);
+  }
+  if (result != FR_OK || read != size) {
+    f_close(&file);
+    return SDCARD_ERROR(result);
+  }
+
+  if (f_lseek(&file, 8 + storedSize) == FR_OK) {
+    loadJournal(&file, data, storedSize, offset, size);
+  }
+
+  f_close(&file);
+  return nullptr;
 }
 
 const char * loadModel(const char * filename, bool alarms)
 {
   uint8_t version;
+  uint16_t journalSize;
 
   preModelLoad();
 
-  const char * error = readModel(filename, (uint8_t *)&g_model, sizeof(g_model), &version);
+  DEBUG_TIMER_START(debugTimerModelRead);
+  const char * error = readModel(filename, (uint8_t *)&g_model, sizeof(g_model), &version, &journalSize);
+  DEBUG_TIMER_STOP(debugTimerModelRead);
   if (error) {
     TRACE("loadModel error=%s", error);
   }
+  else if (version == EEPROM_VER && journalSize != JOURNAL_INVALID) {
+    memcpy(&storageModel, &g_model, sizeof(storageModel));
+    memcpy(storageModelFilename, filename, LEN_MODEL_FILENAME);
+    storageModelJournalSize = journalSize;
+  }
+  else {
+    // the next save will rewrite the whole file
+    storageModelJournalSize = JOURNAL_INVALID;
+  }
 
   if (error) {
     modelDefault(0) ;
@@ -148,7 +366,9 @@ const char * loadModel(const char * filename, bool alarms)
     alarms = false;
   }
   else if (version < EEPROM_VER) {
+    DEBUG_TIMER_START(debugTimerModelConvert);
     convertModelData(version);
+    DEBUG_TIMER_STOP(debugTimerModelConvert);
   }
 
   postModelLoad(alarms);
@@ -156,6 +376,61 @@ const char * loadModel(const char * filename, bool alarms)
   return error;
 }
 
+#if defined(SIMU)
+// converts a radio.bin or model file image (with its journal) to the
+// current version, used by the simulator library for batch conversions
+const char * convertFileImage(const uint8_t * src, uint32_t srcSize, uint8_t * dst, uint32_t * dstSize, bool radio)
+{
+  if (srcSize < 8 || *(uint32_t *)&src[0] != OTX_FOURCC || src[5] != 'M')
+    return STR_INCOMPATIBLE;
+
+  uint8_t version = src[4];
+  uint16_t size = *(uint16_t *)&src[6];
+  if (version < FIRST_CONV_EEPROM_VER || version > EEPROM_VER || 8 + size > srcSize)
+    return STR_INCOMPATIBLE;
+
+  uint8_t * data = (radio ? (uint8_t *)&g_eeGeneral : (uint8_t *)&g_model);
+  uint16_t maxsize = (radio ? sizeof(g_eeGeneral) : sizeof(g_model));
+  if (*dstSize < 8u + maxsize)
+    return STR_INCOMPATIBLE;
+
+  memclear(data, maxsize);
+  memcpy(data, &src[8], min<uint16_t>(size, maxsize));
+
+  // a torn record ends the journal, as in loadFile()
+  uint32_t offset = 8 + size;
+  while (offset + sizeof(JournalRecord) <= srcSize) {
+    JournalRecord record;
+    memcpy(&record, &src[offset], sizeof(record));
+    offset += sizeof(record);
+    if (offset + record.size > srcSize || !applyJournalRecord(record, &src[offset], data, size, 0, maxsize))
+      break;
+    offset += record.size;
+  }
+
+  // a file already at the current version keeps its stored size, so that
+  // it comes back unchanged when it has no journal
+  uint16_t dataSize = maxsize;
+  if (version < EEPROM_VER) {
+    if (radio)
+      convertRadioData(version);
+    else
+      convertModelData(version);
+  }
+  else {
+    dataSize = min<uint16_t>(size, maxsize);
+  }
+
+  *(uint32_t *)&dst[0] = OTX_FOURCC;
+  dst[4] = EEPROM_VER;
+  dst[5] = 'M';
+  *(uint16_t *)&dst[6] = dataSize;
+  memcpy(&dst[8], data, dataSize);
+  *dstSize = 8 + dataSize;
+  return nullptr;
+}
+#endif
+
 const char * loadRadioSettings(const char * path)
 {
   uint8_t version;
@@ -195,10 +470,15 @@ void storageCheck(bool immediately)
     }
   }
 
-  if (storageDirtyMsk & EE_MODEL) {
+  // the immediate saves (model switch, USB, power off) also compact the journal, so
+  // that the model file can be read by anything else than the firmware loader
+  bool compact = immediately && storageModelJournalSize != 0 && storageModelJournalSize != JOURNAL_INVALID &&
+                 !memcmp(storageModelFilename, g_eeGeneral.currModelFilename, LEN_MODEL_FILENAME);
+
+  if ((storageDirtyMsk & EE_MODEL) || compact) {
     TRACE("Storage write current model");
-    storageDirtyMsk -= EE_MODEL;
-    const char * error = writeModel();
+    storageDirtyMsk &= ~EE_MODEL;
+    const char * error = (immediately ? writeModel() : writeModelChanges());
     if (error) {
       TRACE("writeModel error=%s", error);
     }
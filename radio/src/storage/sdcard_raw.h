@@ -31,13 +31,18 @@ const char * openFile(const char * fullpath, FIL * file, uint16_t * size, uint8_
 
 void getModelPath(char * path, const char * filename);
 
-const char * readModel(const char * filename, uint8_t * buffer, uint32_t size, uint8_t * version);
+const char * readModel(const char * filename, uint8_t * buffer, uint32_t size, uint8_t * version, uint16_t * journalSize = nullptr);
+const char * readModelData(const char * filename, uint16_t offset, uint8_t * data, uint16_t size, uint8_t * version);
 const char * loadModel(const char * filename, bool alarms=true);
 const char * createModel();
 
 const char * loadRadioSettings(const char * path);
 const char * loadRadioSettings();
 
+#if defined(SIMU)
+const char * convertFileImage(const uint8_t * src, uint32_t srcSize, uint8_t * dst, uint32_t * dstSize, bool radio);
+#endif
+
 PACK(struct RamBackup {
   uint16_t size;
   uint8_t data[4094];
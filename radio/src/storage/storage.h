@@ -52,6 +52,18 @@ void storageFlushCurrentModel();
 void postRadioSettingsLoad();
 void preModelLoad();
 void postModelLoad(bool alarms);
+void postModelRestore();
+
+// the cosmetic post-load work (display, audio files) is done
+// from perMain(), one stage per call, once the model is flyable
+enum ModelLoadStages {
+  MODEL_LOAD_WIDGETS = (1 << 0), // first, the main view uses them
+  MODEL_LOAD_AUDIO = (1 << 1),
+  MODEL_LOAD_ALL_STAGES = MODEL_LOAD_WIDGETS | MODEL_LOAD_AUDIO
+};
+
+extern uint8_t modelLoadPendingStages;
+void modelLoadWakeup();
 void checkExternalAntenna();
 
 #if defined(EEPROM_RLC)
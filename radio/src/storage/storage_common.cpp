@@ -22,6 +22,7 @@
 
 uint8_t   storageDirtyMsk;
 tmr10ms_t storageDirtyTime10ms;
+uint8_t   modelLoadPendingStages;
 
 #if defined(RAMBACKUP)
 uint8_t   rambackupDirtyMsk;
@@ -43,6 +44,9 @@ void preModelLoad()
 {
   watchdogSuspend(500/*5s*/);
 
+  // the previous model stages must not run on the new model
+  modelLoadPendingStages = 0;
+
 #if defined(SDCARD)
   logsClose();
 #endif
@@ -113,8 +117,24 @@ void checkExternalAntenna()
 }
 #endif
 
+static void modelLoadTelemetry()
+{
+  for (int i=0; i<MAX_TELEMETRY_SENSORS; i++) {
+    TelemetrySensor & sensor = g_model.telemetrySensors[i];
+    if (sensor.type == TELEM_TYPE_CALCULATED && sensor.persistent) {
+      telemetryItems[i].value = sensor.persistentValue;
+      telemetryItems[i].timeout = 0; // make value visible even before the first new value is received)
+    }
+    else {
+      telemetryItems[i].timeout = TELEMETRY_SENSOR_TIMEOUT_UNAVAILABLE;
+    }
+  }
+}
+
 void postModelLoad(bool alarms)
 {
+  DEBUG_TIMER_START(debugTimerPostModelLoad);
+
 #if defined(PXX2)
   if (is_memclear(g_model.modelRegistrationID, PXX2_LEN_REGISTRATION_ID)) {
     memcpy(g_model.modelRegistrationID, g_eeGeneral.ownerRegistrationID, PXX2_LEN_REGISTRATION_ID);
@@ -138,19 +158,13 @@ void postModelLoad(bool alarms)
 
   restoreTimers();
 
-  for (int i=0; i<MAX_TELEMETRY_SENSORS; i++) {
-    TelemetrySensor & sensor = g_model.telemetrySensors[i];
-    if (sensor.type == TELEM_TYPE_CALCULATED && sensor.persistent) {
-      telemetryItems[i].value = sensor.persistentValue;
-      telemetryItems[i].timeout = 0; // make value visible even before the first new value is received)
-    }
-    else {
-      telemetryItems[i].timeout = TELEMETRY_SENSOR_TIMEOUT_UNAVAILABLE;
-    }
-  }
+  // the new model's mixes, logical switches and alarms must not see the previous model's values
+  modelLoadTelemetry();
 
   LOAD_MODEL_CURVES();
 
+  modelLoadPendingStages = MODEL_LOAD_ALL_STAGES;
+
   resumeMixerCalculations();
   if (pulsesStarted()) {
 #if defined(GUI)
@@ -162,18 +176,63 @@ void postModelLoad(bool alarms)
     resumePulses();
   }
 
-#if defined(SDCARD)
-  referenceModelAudioFiles();
-#endif
+  LOAD_MODEL_BITMAP();
+  LUA_LOAD_MODEL_SCRIPTS();
 
-#if defined(PCBHORUS)
-  loadCustomScreens();
-#endif
+  SEND_FAILSAFE_1S();
+
+  DEBUG_TIMER_STOP(debugTimerPostModelLoad);
+}
 
+// g_model and the model runtime state were replaced as a whole (simulator state
+// restore): rebuild what derives from them, without the resets of a model load
+void postModelRestore()
+{
+  // the modules start again with the restored settings, in normal mode
+  bool started = pulsesStarted();
+  for (uint8_t i=0; i<NUM_MODULES; i++) {
+    moduleState[i].mode = MODULE_MODE_NORMAL;
+    if (started) {
+      moduleState[i].protocol = PROTOCOL_CHANNELS_NONE;
+    }
+  }
+  SEND_FAILSAFE_1S();
+
+  telemetryCalculatedSensors.reset();
+  telemetrySnapshot.publish();
+
+  LOAD_MODEL_CURVES();
+  modelLoadPendingStages = MODEL_LOAD_ALL_STAGES;
   LOAD_MODEL_BITMAP();
   LUA_LOAD_MODEL_SCRIPTS();
+}
 
-  SEND_FAILSAFE_1S();
+void modelLoadWakeup()
+{
+  if (!modelLoadPendingStages)
+    return;
+
+  DEBUG_TIMER_START(debugTimerModelLoadStages);
+
+  // the lowest stage first
+  uint8_t stage = modelLoadPendingStages & -modelLoadPendingStages;
+  modelLoadPendingStages &= ~stage;
+
+  switch (stage) {
+    case MODEL_LOAD_WIDGETS:
+#if defined(PCBHORUS)
+      loadCustomScreens();
+#endif
+      break;
+
+    case MODEL_LOAD_AUDIO:
+#if defined(SDCARD)
+      referenceModelAudioFiles();
+#endif
+      break;
+  }
+
+  DEBUG_TIMER_STOP(debugTimerModelLoadStages);
 }
 
 void storageFlushCurrentModel()
@@ -40,17 +40,6 @@ enum LogicalSwitchContextState {
   SWITCH_ENABLE
 };
 
-PACK(struct LogicalSwitchContext {
-  uint8_t state:1;
-  uint8_t timerState:2;
-  uint8_t spare:5;
-  uint8_t timer;
-  int16_t lastValue;
-});
-
-PACK(struct LogicalSwitchesFlightModeContext {
-  LogicalSwitchContext lsw[MAX_LOGICAL_SWITCHES];
-});
 LogicalSwitchesFlightModeContext lswFm[MAX_FLIGHT_MODES];
 
 #define LS_LAST_VALUE(fm, idx) lswFm[fm].lsw[idx].lastValue
@@ -458,7 +447,7 @@ bool getSwitch(swsrc_t swtch, uint8_t flags)
     result = (inactivity.counter < 2);
   }
   else if (cs_idx >= SWSRC_FIRST_SENSOR) {
-    result = !telemetryItems[cs_idx-SWSRC_FIRST_SENSOR].isOld();
+    result = !telemetrySnapshot[cs_idx-SWSRC_FIRST_SENSOR].isOld();
   }
   else if (cs_idx == SWSRC_TELEMETRY_STREAMING) {
     result = TELEMETRY_STREAMING();
@@ -744,7 +733,7 @@ void checkSwitches()
       last_bad_switches = switches_states;
     }
 
-    if (keyDown())
+    if (keyDown() || IS_SIMU_HEADLESS())
       break;
 
 #if defined(PWR_BUTTON_PRESS)
@@ -565,6 +565,7 @@ void telemetryPortSetDirectionOutput();
 void sportSendByte(uint8_t byte);
 void sportSendBuffer(const uint8_t * buffer, uint32_t count);
 bool telemetryGetByte(uint8_t * byte);
+uint32_t telemetryGetBytes(uint8_t * buffer, uint32_t count);
 void telemetryClearFifo();
 extern uint32_t telemetryErrors;
 
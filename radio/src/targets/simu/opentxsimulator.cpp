@@ -18,8 +18,12 @@
 #include "opentx.h"
 #include "simulcd.h"
 
+#include <QCryptographicHash>
 #include <QDebug>
+#include <QDir>
+#include <QDirIterator>
 #include <QElapsedTimer>
+#include <QFileInfo>
 
 #if !defined(MAX_LOGICAL_SWITCHES) && defined(NUM_CSW)
   #define MAX_LOGICAL_SWITCHES    NUM_CSW
@@ -31,6 +35,8 @@
 
 int16_t g_anas[Analogs::NUM_ANALOGS];
 QVector<QIODevice *> OpenTxSimulator::tracebackDevices;
+QStringList OpenTxSimulator::audioEvents;
+QMutex OpenTxSimulator::audioEventsMutex;
 
 uint16_t anaIn(uint8_t chan)
 {
@@ -50,19 +56,29 @@ void firmwareTraceCb(const char * text)
   }
 }
 
+void firmwareAudioCb(const char * event)
+{
+  QMutexLocker lckr(&OpenTxSimulator::audioEventsMutex);
+  OpenTxSimulator::audioEvents.append(QString(event));
+}
+
 OpenTxSimulator::OpenTxSimulator() :
   SimulatorInterface(),
   m_timer10ms(nullptr),
   m_resetOutputsData(true),
-  m_stopRequested(false)
+  m_stopRequested(false),
+  m_sessionTests(false),
+  m_radioDataChanged(false)
 {
   tracebackDevices.clear();
   traceCallback = firmwareTraceCb;
+  simuAudioCallback = firmwareAudioCb;
 }
 
 OpenTxSimulator::~OpenTxSimulator()
 {
   traceCallback = nullptr;
+  simuAudioCallback = nullptr;
   tracebackDevices.clear();
 
   if (m_timer10ms)
@@ -75,6 +91,9 @@ OpenTxSimulator::~OpenTxSimulator()
     while (isRunning() && !tmout.hasExpired(1000))
       ;
   }
+
+  QMutexLocker lckr(&m_mtxSimuMain);
+  shutdownSuspended();
   //qDebug() << "Deleting OpenTxSimulator";
 }
 
@@ -86,7 +105,7 @@ QString OpenTxSimulator::name()
 bool OpenTxSimulator::isRunning()
 {
   QMutexLocker lckr(&m_mtxSimuMain);
-  return simuIsRunning();
+  return simuIsRunning() && !simuIsSuspended();
 }
 
 void OpenTxSimulator::init()
@@ -97,8 +116,9 @@ void OpenTxSimulator::init()
   OTXS_DBG;
 
   if (!m_timer10ms) {
-    // make sure we create & control the timer from current thread
-    m_timer10ms = new QTimer();
+    // make sure we create & control the timer from current thread,
+    // it follows the simulator when it is moved to another thread
+    m_timer10ms = new QTimer(this);
     m_timer10ms->setInterval(10);
     connect(m_timer10ms, &QTimer::timeout, this, &OpenTxSimulator::run);
     connect(this, SIGNAL(started()), m_timer10ms, SLOT(start()));
@@ -106,6 +126,7 @@ void OpenTxSimulator::init()
   }
 
   m_resetOutputsData = true;
+  m_outputsNotified.store(0);
   setStopRequested(false);
 
   QMutexLocker lckr(&m_mtxSimuMain);
@@ -126,6 +147,33 @@ void OpenTxSimulator::start(const char * filename, bool tests)
 
   QMutexLocker lckr(&m_mtxSimuMain);
   QMutexLocker slckr(&m_mtxSettings);
+
+  // the firmware suspended at the end of the previous session starts again
+  // from its boot state, it reads its storage again if it was changed
+  if (simuIsSuspended()) {
+    if (tests == m_sessionTests) {
+      bool reload = m_radioDataChanged || storageDigest(filename) != m_suspendedDigest;
+      m_radioDataChanged = false;
+      if (reload && m_sessionFile != QByteArray(filename)) {
+        StopEepromThread();
+        StartEepromThread(filename);
+        m_sessionFile = filename;
+      }
+      simuFatfsSetPaths(simuSdDirectory.toLatin1().constData(), simuSettingsDirectory.toLatin1().constData());
+      if (simuResume(reload)) {
+        OTXS_DBG << "resumed, storage reloaded:" << reload;
+        StartAudioThread(volumeGain);
+        emit started();
+        QTimer::singleShot(0, this, SLOT(run()));  // old style for Qt < 5.4
+        return;
+      }
+    }
+    shutdownSuspended();
+  }
+
+  m_sessionFile = filename;
+  m_sessionTests = tests;
+  m_radioDataChanged = false;
   StartEepromThread(filename);
   StartAudioThread(volumeGain);
   StartSimu(tests, simuSdDirectory.toLatin1().constData(), simuSettingsDirectory.toLatin1().constData());
@@ -134,6 +182,35 @@ void OpenTxSimulator::start(const char * filename, bool tests)
   QTimer::singleShot(0, this, SLOT(run()));  // old style for Qt < 5.4
 }
 
+void OpenTxSimulator::startHeadless(const char * filename)
+{
+  if (isRunning())
+    return;
+  OTXS_DBG << "file:" << filename;
+
+  QMutexLocker lckr(&m_mtxSimuMain);
+  QMutexLocker slckr(&m_mtxSettings);
+  shutdownSuspended();
+  StartEepromThread(filename);
+  StartSimu(false, simuSdDirectory.toLatin1().constData(), simuSettingsDirectory.toLatin1().constData(), true);
+}
+
+void OpenTxSimulator::step(unsigned int ms)
+{
+  if (!isRunning()) {
+    emit runtimeError(QString(getError()));
+    return;
+  }
+
+  m_mtxSimuMain.lock();
+  simuStep(ms);
+  m_mtxSimuMain.unlock();
+
+  checkLcdChanged();
+  checkOutputsChanged();
+  checkAudioEvents();
+}
+
 void OpenTxSimulator::stop()
 {
   if (!isRunning())
@@ -143,13 +220,75 @@ void OpenTxSimulator::stop()
   setStopRequested(true);
 
   QMutexLocker lckr(&m_mtxSimuMain);
+  bool headless = simu_headless;
+
+  // between two sessions the booted firmware stays suspended
+  if (!headless && simuSuspend()) {
+    StopAudioThread();
+    QMutexLocker slckr(&m_mtxSettings);
+    m_suspendedDigest = storageDigest(m_sessionFile);
+    emit stopped();
+    return;
+  }
+
   StopSimu();
-  StopAudioThread();
+  if (!headless)
+    StopAudioThread();
   StopEepromThread();
 
   emit stopped();
 }
 
+static void addFileInfo(QCryptographicHash & hash, const QFileInfo & info)
+{
+  hash.addData(info.absoluteFilePath().toUtf8());
+  hash.addData(QByteArray::number(info.size()));
+  hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+}
+
+// where the data the firmware storage works on are, with the size and the
+// modification time of their files: the storage is read again on resume if
+// they are not the ones it flushed when suspended; the changes of the eeprom
+// buffer are tracked by setRadioData()
+QByteArray OpenTxSimulator::storageDigest(const QByteArray & filename)
+{
+  QCryptographicHash hash(QCryptographicHash::Md5);
+  hash.addData(filename);
+  hash.addData(simuSdDirectory.toUtf8());
+  hash.addData(simuSettingsDirectory.toUtf8());
+
+#if defined(EEPROM_SIZE)
+  if (!filename.isEmpty()) {
+    addFileInfo(hash, QFileInfo(filename));
+  }
+#else
+  // the radio settings and the models files
+  QString dataPath = simuSettingsDirectory.isEmpty() ? simuSdDirectory : simuSettingsDirectory;
+  QStringList files;
+  foreach (const QString & folder, QStringList() << "RADIO" << "MODELS") {
+    QDirIterator it(QDir(dataPath).filePath(folder), QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext())
+      files << it.next();
+  }
+  files.sort();
+  foreach (const QString & name, files) {
+    addFileInfo(hash, QFileInfo(name));
+  }
+#endif
+
+  return hash.result();
+}
+
+// stops a suspended firmware for good, with m_mtxSimuMain locked
+void OpenTxSimulator::shutdownSuspended()
+{
+  if (!simuIsSuspended())
+    return;
+  OTXS_DBG;
+  StopSimu();
+  StopEepromThread();
+}
+
 void OpenTxSimulator::setSdPath(const QString & sdPath, const QString & settingsPath)
 {
   QMutexLocker lckr(&m_mtxSettings);
@@ -166,6 +305,17 @@ void OpenTxSimulator::setVolumeGain(const int value)
 void OpenTxSimulator::setRadioData(const QByteArray & data)
 {
 #if defined(EEPROM_SIZE)
+  {
+    // a suspended firmware keeps its storage if given the same data, it reads
+    // the new one when resumed otherwise
+    QMutexLocker lckr(&m_mtxSimuMain);
+    if (simuIsSuspended()) {
+      if (eeprom && !memcmp(eeprom, data.constData(), qMin<int>(EEPROM_SIZE, data.size())))
+        return;
+      m_radioDataChanged = true;
+    }
+  }
+
   QMutexLocker lckr(&m_mtxRadioData);
   eeprom = (uint8_t *)malloc(qMin<int>(EEPROM_SIZE, data.size()));
   memcpy(eeprom, data.data(), qMin<int>(EEPROM_SIZE, data.size()));
@@ -219,7 +369,6 @@ void OpenTxSimulator::setTrim(unsigned int idx, int value)
     timer->setSingleShot(true);
     connect(timer, &QTimer::timeout, [=]() {
       emit trimValueChange(idx, 0);
-      emit outputValueChange(OUTPUT_SRC_TRIM_VALUE, idx, 0);
       timer->deleteLater();
     });
     timer->start(350);
@@ -372,6 +521,58 @@ const int OpenTxSimulator::getCapability(Capability cap)
   return ret;
 }
 
+QString OpenTxSimulator::convertFile(const QByteArray & src, QByteArray & dst, bool radio)
+{
+#if defined(SDCARD) && !defined(EEPROM)
+  // the conversion is done in g_model / g_eeGeneral
+  QMutexLocker lckr(&m_mtxSimuMain);
+  if (simuIsRunning())
+    return QString("Simulator is running");
+
+  dst.resize(8 + (radio ? sizeof(RadioData) : sizeof(ModelData)));
+  uint32_t size = dst.size();
+  const char * error = convertFileImage((const uint8_t *)src.constData(), src.size(), (uint8_t *)dst.data(), &size, radio);
+  if (error) {
+    dst.clear();
+    return QString(error);
+  }
+  dst.resize(size);
+  return QString();
+#else
+  return QString("Not supported by this radio");
+#endif
+}
+
+bool OpenTxSimulator::getOutputs(TxOutputs & outputs)
+{
+  m_outputsNotified.store(0);
+  bool updated = m_outputs.update();
+  outputs = m_outputs.readBuffer();
+  return updated;
+}
+
+QByteArray OpenTxSimulator::saveState()
+{
+  QMutexLocker lckr(&m_mtxSimuMain);
+  QByteArray state(simuSaveState(nullptr, 0), 0);
+  if (simuSaveState((uint8_t *)state.data(), state.size()) != (uint32_t)state.size())
+    return QByteArray();
+  // the model and the telemetry items are mostly zeros
+  return qCompress(state);
+}
+
+bool OpenTxSimulator::restoreState(const QByteArray & state)
+{
+  QByteArray data = qUncompress(state);
+  QMutexLocker lckr(&m_mtxSimuMain);
+  if (!simuRestoreState((const uint8_t *)data.constData(), data.size())) {
+    OTXS_DBG << "invalid state snapshot, size:" << state.size();
+    return false;
+  }
+  m_resetOutputsData = true;
+  return true;
+}
+
 void OpenTxSimulator::setLuaStateReloadPermanentScripts()
 {
 #if defined(LUA)
@@ -426,9 +627,10 @@ void OpenTxSimulator::run()
   per10ms();
 
   checkLcdChanged();
+  checkOutputsChanged();
 
   if (!(loops % 5)) {
-    checkOutputsChanged();
+    checkAudioEvents();
   }
 
   if (!(loops % (SIMULATOR_INTERFACE_HEARTBEAT_PERIOD / 10))) {
@@ -458,6 +660,18 @@ bool OpenTxSimulator::checkLcdChanged()
   return false;
 }
 
+void OpenTxSimulator::checkAudioEvents()
+{
+  QStringList events;
+  audioEventsMutex.lock();
+  events.swap(audioEvents);
+  audioEventsMutex.unlock();
+
+  foreach (const QString & event, events) {
+    emit audioEvent(event);
+  }
+}
+
 void OpenTxSimulator::checkOutputsChanged()
 {
   static TxOutputs lastOutputs;
@@ -468,26 +682,18 @@ void OpenTxSimulator::checkOutputsChanged()
   const uint8_t phase = getFlightMode();  // opentx.cpp
   const uint8_t mode = getStickMode();
 
+  // all the fields are rewritten, the buffer holds an older snapshot
+  TxOutputs & outputs = m_outputs.writeBuffer();
+
+  outputs.chanLimit = (g_model.extendedLimits ? limit * LIMIT_EXT_PERCENT / 100 : limit);
+  outputs.mixLimit = limit * 2;
   for (i=0; i < chansDim; i++) {
-    if (lastOutputs.chans[i] != channelOutputs[i] || m_resetOutputsData) {
-      emit channelOutValueChange(i, channelOutputs[i], (g_model.extendedLimits ? limit * LIMIT_EXT_PERCENT / 100 : limit));
-      emit outputValueChange(OUTPUT_SRC_CHAN_OUT, i, channelOutputs[i]);
-      lastOutputs.chans[i] = channelOutputs[i];
-    }
-    if (lastOutputs.ex_chans[i] != ex_chans[i] || m_resetOutputsData) {
-      emit channelMixValueChange(i, ex_chans[i], limit * 2);
-      emit outputValueChange(OUTPUT_SRC_CHAN_MIX, i, ex_chans[i]);
-      lastOutputs.ex_chans[i] = ex_chans[i];
-    }
+    outputs.chans[i] = channelOutputs[i];
+    outputs.ex_chans[i] = ex_chans[i];
   }
 
   for (i=0; i < MAX_LOGICAL_SWITCHES; i++) {
-    tmpVal = (qint32)GET_SWITCH_BOOL(SWSRC_SW1+i);
-    if (lastOutputs.vsw[i] != (bool)tmpVal || m_resetOutputsData) {
-      emit virtualSwValueChange(i, tmpVal);
-      emit outputValueChange(OUTPUT_SRC_VIRTUAL_SW, i, tmpVal);
-      lastOutputs.vsw[i] = tmpVal;
-    }
+    outputs.vsw[i] = GET_SWITCH_BOOL(SWSRC_SW1+i);
   }
 
   for (i=0; i < Board::TRIM_AXIS_COUNT; i++) {
@@ -497,24 +703,21 @@ void OpenTxSimulator::checkOutputsChanged()
       idx = i;
 
     tmpVal = getTrimValue(getTrimFlightMode(phase, idx), idx);
+    outputs.trims[i] = tmpVal;
     if (lastOutputs.trims[i] != tmpVal || m_resetOutputsData) {
       emit trimValueChange(i, tmpVal);
-      emit outputValueChange(OUTPUT_SRC_TRIM_VALUE, i, tmpVal);
-      lastOutputs.trims[i] = tmpVal;
     }
   }
 
   tmpVal = g_model.extendedTrims ? TRIM_EXTENDED_MAX : TRIM_MAX;
+  outputs.trimRange = tmpVal;
   if (lastOutputs.trimRange != tmpVal || m_resetOutputsData) {
     emit trimRangeChange(Board::TRIM_AXIS_COUNT, -tmpVal, tmpVal);
-    emit outputValueChange(OUTPUT_SRC_TRIM_RANGE, Board::TRIM_AXIS_COUNT, tmpVal);
-    lastOutputs.trimRange = tmpVal;
   }
 
+  outputs.phase = phase;
   if (lastOutputs.phase != phase || m_resetOutputsData) {
     emit phaseChanged(phase, getCurrentPhaseName());
-    emit outputValueChange(OUTPUT_SRC_PHASE, 0, qint16(phase));
-    lastOutputs.phase = phase;
   }
 
 #if defined(GVAR_VALUE) && defined(GVARS)
@@ -525,16 +728,19 @@ void OpenTxSimulator::checkOutputsChanged()
     for (uint8_t fm=0; fm < MAX_FLIGHT_MODES; fm++) {
       gvar.mode = fm;
       gvar.value = (int16_t)GVAR_VALUE(gv, getGVarFlightMode(fm, gv));
-      tmpVal = gvar;
-      if (lastOutputs.gvars[fm][gv] != tmpVal || m_resetOutputsData) {
-        lastOutputs.gvars[fm][gv] = tmpVal;
-        emit gVarValueChange(gv, tmpVal);
-        emit outputValueChange(OUTPUT_SRC_GVAR, gv, tmpVal);
-      }
+      outputs.gvars[fm][gv] = gvar;
     }
   }
 #endif
 
+  // one notification per batch of changes, and none until the consumer read them
+  if (m_resetOutputsData || memcmp(&outputs, &lastOutputs, sizeof(TxOutputs))) {
+    memcpy(&lastOutputs, &outputs, sizeof(TxOutputs));
+    m_outputs.publish();
+    if (m_outputsNotified.testAndSetOrdered(0, 1))
+      emit outputsUpdated();
+  }
+
   m_resetOutputsData = false;
 }
 
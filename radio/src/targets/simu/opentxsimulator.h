@@ -18,9 +18,12 @@
 #define _OPENTX_SIMULATOR_H_
 
 #include "simulatorinterface.h"
+#include "triplebuffer.h"
 
+#include <QAtomicInt>
 #include <QMutex>
 #include <QObject>
+#include <QStringList>
 #include <QTimer>
 
 #if defined __GNUC__
@@ -45,13 +48,21 @@ class DLLEXPORT OpenTxSimulator : public SimulatorInterface
     virtual uint8_t getSensorInstance(uint16_t id, uint8_t defaultValue = 0);
     virtual uint16_t getSensorRatio(uint16_t id);
     virtual const int getCapability(Capability cap);
+    virtual QString convertFile(const QByteArray & src, QByteArray & dst, bool radio = false);
+    virtual bool getOutputs(TxOutputs & outputs);
+    virtual QByteArray saveState();
+    virtual bool restoreState(const QByteArray & state);
 
     static QVector<QIODevice *> tracebackDevices;
+    static QStringList audioEvents;
+    static QMutex audioEventsMutex;
 
   public slots:
 
     virtual void init();
     virtual void start(const char * filename = nullptr, bool tests = true);
+    virtual void startHeadless(const char * filename = nullptr);
+    virtual void step(unsigned int ms);
     virtual void stop();
     virtual void setSdPath(const QString & sdPath = "", const QString & settingsPath = "");
     virtual void setVolumeGain(const int value);
@@ -79,11 +90,14 @@ class DLLEXPORT OpenTxSimulator : public SimulatorInterface
     void setStopRequested(bool stop);
     bool checkLcdChanged();
     void checkOutputsChanged();
+    void checkAudioEvents();
     uint8_t getStickMode();
     const char * getPhaseName(unsigned int phase);
     const QString getCurrentPhaseName();
     const char * getError();
     const int voltageToAdc(const int volts);
+    QByteArray storageDigest(const QByteArray & filename);
+    void shutdownSuspended();
 
     QString simuSdDirectory;
     QString simuSettingsDirectory;
@@ -94,8 +108,14 @@ class DLLEXPORT OpenTxSimulator : public SimulatorInterface
     QMutex m_mtxSettings;
     QMutex m_mtxTbDevices;
     int volumeGain;
+    TripleBuffer<TxOutputs> m_outputs;
+    QAtomicInt m_outputsNotified;
     bool m_resetOutputsData;
     bool m_stopRequested;
+    QByteArray m_sessionFile;
+    bool m_sessionTests;
+    QByteArray m_suspendedDigest;
+    bool m_radioDataChanged;
 
 };
 
@@ -21,9 +21,16 @@
 #define SIMPGMSPC_USE_QT    0
 
 #include "opentx.h"
+#if !defined(EEPROM)
+#include "storage/modelslist.h"
+#endif
 #include <errno.h>
 #include <stdarg.h>
 #include <string>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <vector>
 
 #if !defined (_MSC_VER) || defined (__GNUC__)
   #include <chrono>
@@ -42,6 +49,15 @@ char * main_thread_error = nullptr;
 bool simu_shutdown = false;
 bool simu_running = false;
 
+// in headless mode the firmware tasks are run by simuStep(), on the
+// virtual clock
+bool simu_headless = false;
+
+// between two sessions the booted firmware is kept suspended, its tasks parked
+static bool simu_suspended = false;
+
+void (* simuAudioCallback)(const char * event) = nullptr;
+
 #if defined(STM32)
 GPIO_TypeDef gpioa, gpiob, gpioc, gpiod, gpioe, gpiof, gpiog, gpioh, gpioi, gpioj;
 TIM_TypeDef tim1, tim2, tim3, tim4, tim5, tim6, tim7, tim8, tim9, tim10;
@@ -73,7 +89,7 @@ void toplcdOff()
 {
 }
 
-uint64_t simuTimerMicros(void)
+uint64_t simuWallMicros()
 {
 #if SIMPGMSPC_USE_QT
   static QElapsedTimer ticker;
@@ -106,6 +122,67 @@ uint64_t simuTimerMicros(void)
 #endif
 }
 
+// the simulator clock: the host clock, or a virtual clock which only moves
+// when advanced by the thread which selected it (the stepping thread). The
+// mode and the value are switched together under the lock, which keeps the
+// time monotonic.
+static std::mutex simuClockMutex;
+static uint8_t simuClock = SIMU_CLOCK_WALL;
+static uint64_t simuClockMicros = 0;  // virtual time, or wall clock offset
+static std::thread::id simuClockThread;
+
+uint64_t simuTimerMicros(void)
+{
+  std::lock_guard<std::mutex> lock(simuClockMutex);
+  if (simuClock == SIMU_CLOCK_VIRTUAL)
+    return simuClockMicros;
+  else
+    return simuWallMicros() + simuClockMicros;
+}
+
+void simuClockSet(uint8_t clock)
+{
+  std::lock_guard<std::mutex> lock(simuClockMutex);
+  if (clock == SIMU_CLOCK_VIRTUAL)
+    simuClockThread = std::this_thread::get_id();
+
+  if (clock == simuClock)
+    return;
+
+  uint64_t wall = simuWallMicros();
+  if (clock == SIMU_CLOCK_VIRTUAL) {
+    simuClockMicros += wall;
+  }
+  else {
+    simuClockMicros = (simuClockMicros > wall ? simuClockMicros - wall : 0);
+  }
+  simuClock = clock;
+}
+
+uint8_t simuClockGet()
+{
+  std::lock_guard<std::mutex> lock(simuClockMutex);
+  return simuClock;
+}
+
+static bool simuClockIsStepper()
+{
+  std::lock_guard<std::mutex> lock(simuClockMutex);
+  return simuClockThread == std::this_thread::get_id();
+}
+
+uint32_t simuClockAdvance(uint64_t micros)
+{
+  std::lock_guard<std::mutex> lock(simuClockMutex);
+  if (simuClock != SIMU_CLOCK_VIRTUAL || simuClockThread != std::this_thread::get_id())
+    return 0;
+
+  // the number of 10ms periods crossed
+  uint64_t before = simuClockMicros;
+  simuClockMicros += micros;
+  return simuClockMicros / 10000 - before / 10000;
+}
+
 uint16_t getTmr16KHz()
 {
   return simuTimerMicros() * 2 / 125;
@@ -164,7 +241,79 @@ void simuSetSwitch(uint8_t swtch, int8_t state)
   switchesStates[swtch] = state;
 }
 
-void StartSimu(bool tests, const char * sdPath, const char * settingsPath)
+// the firmware tasks park at their safe point, between two iterations of their
+// loop, while the state is saved or restored: nothing else touches it then
+#define SIMU_TASKS_COUNT             3     // mixer, telemetry, menus
+#define SIMU_TASKS_STOP_TIMEOUT      1000  // ms
+
+static std::mutex simuTasksRequestMutex;  // one requester at a time
+static std::mutex simuTasksMutex;
+static std::condition_variable simuTasksCondition;
+static bool simuTasksHold = false;
+static int simuTasksParked = 0;
+
+bool simuTaskSafePoint()
+{
+  std::unique_lock<std::mutex> lock(simuTasksMutex);
+  if (!simuTasksHold)
+    return false;
+
+  simuTasksParked++;
+  simuTasksCondition.notify_all();
+  while (simuTasksHold && !simu_shutdown) {
+    simuTasksCondition.wait_for(lock, std::chrono::milliseconds(10));
+  }
+  simuTasksParked--;
+  simuTasksCondition.notify_all();
+  return simu_shutdown;
+}
+
+// parks the firmware tasks other than the calling one, false if they didn't
+// reach their safe point in time
+static bool simuTasksStop(int count)
+{
+  simuTasksRequestMutex.lock();
+  std::unique_lock<std::mutex> lock(simuTasksMutex);
+  simuTasksHold = true;
+  auto timeout = std::chrono::steady_clock::now() + std::chrono::milliseconds(SIMU_TASKS_STOP_TIMEOUT);
+  while (simuTasksParked < count && !simu_shutdown) {
+    if (simuTasksCondition.wait_until(lock, timeout) == std::cv_status::timeout)
+      break;
+  }
+  if (simuTasksParked < count) {
+    simuTasksHold = false;
+    lock.unlock();
+    simuTasksCondition.notify_all();
+    simuTasksRequestMutex.unlock();
+    return false;
+  }
+  return true;
+}
+
+static void simuTasksResume()
+{
+  std::unique_lock<std::mutex> lock(simuTasksMutex);
+  simuTasksHold = false;
+  simuTasksCondition.notify_all();
+  // a new request must not count the tasks still leaving their safe point
+  while (simuTasksParked > 0) {
+    simuTasksCondition.wait_for(lock, std::chrono::milliseconds(10));
+  }
+  lock.unlock();
+  simuTasksRequestMutex.unlock();
+}
+
+// the tests and the headless runs have no task running beside the caller, the
+// tasks of a suspended firmware are parked already
+static bool simuTasksRunning()
+{
+  return simu_running && !simu_headless && !simu_suspended;
+}
+
+// the state right after the boot, a suspended firmware is resumed from it
+static std::vector<uint8_t> simuBootState;
+
+void StartSimu(bool tests, const char * sdPath, const char * settingsPath, bool headless)
 {
   if (simu_running)
     return;
@@ -172,8 +321,15 @@ void StartSimu(bool tests, const char * sdPath, const char * settingsPath)
   stopPulses();
   menuLevel = 0;
 
-  simu_start_mode = (tests ? 0 : OPENTX_START_NO_SPLASH | OPENTX_START_NO_CALIBRATION | OPENTX_START_NO_CHECKS);
+  // the startup checks are run in headless mode, their alerts don't wait for a key
+  if (headless)
+    simu_start_mode = OPENTX_START_NO_SPLASH | OPENTX_START_NO_CALIBRATION;
+  else
+    simu_start_mode = (tests ? 0 : OPENTX_START_NO_SPLASH | OPENTX_START_NO_CALIBRATION | OPENTX_START_NO_CHECKS);
   simu_shutdown = false;
+  simu_headless = headless;
+  simuBootState.clear();
+  simuClockSet(headless ? SIMU_CLOCK_VIRTUAL : SIMU_CLOCK_WALL);
 
   simuFatfsSetPaths(sdPath, settingsPath);
 
@@ -220,12 +376,288 @@ void StopSimu()
 
   simu_shutdown = true;
 
-  pthread_join(mixerTaskId, nullptr);
-  pthread_join(menusTaskId, nullptr);
+  // the parked tasks of a suspended firmware leave without writing the
+  // storage, it was flushed when suspended
+  if (!simu_headless) {
+    pthread_join(mixerTaskId, nullptr);
+    pthread_join(telemetryTaskId, nullptr);
+    pthread_join(menusTaskId, nullptr);
+  }
+
+  if (simu_suspended) {
+    std::lock_guard<std::mutex> lock(simuTasksMutex);
+    simuTasksHold = false;
+    simu_suspended = false;
+  }
 
   simu_running = false;
 }
 
+void simuStep(uint32_t ms)
+{
+  for (uint32_t i = 0; i < ms && simu_running && !simu_shutdown; ++i) {
+    if (simuClockAdvance(1000)) {
+      per10ms();
+    }
+    tasksStep();
+  }
+}
+
+// firmware RAM state snapshots: a header followed by one section (id, size,
+// data) per variable, a snapshot can only be restored by the same firmware;
+// the inputs (sticks, switches, keys) are not part of the state
+#define SIMU_STATE_MAGIC      0x5358544F  // "OTXS"
+#define SIMU_STATE_VERSION    3
+
+// g_tmr10ms is not restored, it keeps running: the snapshot holds the time it
+// was taken at, and the timestamps it contains are moved by the time elapsed
+// since. The telemetry timeouts are countdowns, they need no change.
+static tmr10ms_t simuStateTime;
+
+struct SimuStateSection {
+  uint16_t id;
+  void * data;
+  uint32_t size;
+};
+
+static const SimuStateSection simuStateSections[] = {
+  { 1, &g_eeGeneral, sizeof(g_eeGeneral) },
+  { 2, &g_model, sizeof(g_model) },
+  { 3, &simuStateTime, sizeof(simuStateTime) },
+  { 4, timersStates, sizeof(timersStates) },
+  { 5, telemetryItems, sizeof(telemetryItems) },
+  { 6, lswFm, sizeof(lswFm) },
+  { 7, swOn, sizeof(swOn) },
+  { 8, act, sizeof(act) },
+  { 9, &mixerCurrentFlightMode, sizeof(mixerCurrentFlightMode) },
+  { 10, &lastFlightMode, sizeof(lastFlightMode) },
+  { 11, &modelFunctionsContext, sizeof(modelFunctionsContext) },
+  { 12, &globalFunctionsContext, sizeof(globalFunctionsContext) },
+  { 13, &flightModeTransitionTime, sizeof(flightModeTransitionTime) },
+  { 14, &flightModeTransitionLast, sizeof(flightModeTransitionLast) },
+  { 15, &telemetryStreaming, sizeof(telemetryStreaming) },
+  { 16, &telemetryState, sizeof(telemetryState) },
+};
+
+PACK(struct SimuStateHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t count;
+});
+
+PACK(struct SimuStateSectionHeader {
+  uint16_t id;
+  uint32_t size;
+});
+
+static uint32_t simuStateSize()
+{
+  uint32_t total = sizeof(SimuStateHeader);
+  for (unsigned i=0; i<DIM(simuStateSections); i++) {
+    total += sizeof(SimuStateSectionHeader) + simuStateSections[i].size;
+  }
+  return total;
+}
+
+static void simuStateSave(uint8_t * buffer)
+{
+  SimuStateHeader header = { SIMU_STATE_MAGIC, SIMU_STATE_VERSION, DIM(simuStateSections) };
+  memcpy(buffer, &header, sizeof(header));
+  uint8_t * pos = buffer + sizeof(header);
+
+  simuStateTime = get_tmr10ms();
+  for (unsigned i=0; i<DIM(simuStateSections); i++) {
+    const SimuStateSection & section = simuStateSections[i];
+    SimuStateSectionHeader sectionHeader = { section.id, section.size };
+    memcpy(pos, &sectionHeader, sizeof(sectionHeader));
+    pos += sizeof(sectionHeader);
+    memcpy(pos, section.data, section.size);
+    pos += section.size;
+  }
+}
+
+// checks the whole snapshot and finds its sections data
+static bool simuStateParse(const uint8_t * buffer, uint32_t size, const uint8_t * data[])
+{
+  SimuStateHeader header;
+  if (!buffer || size < sizeof(header))
+    return false;
+
+  memcpy(&header, buffer, sizeof(header));
+  if (header.magic != SIMU_STATE_MAGIC || header.version != SIMU_STATE_VERSION || header.count != DIM(simuStateSections))
+    return false;
+
+  const uint8_t * pos = buffer + sizeof(header);
+  const uint8_t * end = buffer + size;
+  for (unsigned i=0; i<DIM(simuStateSections); i++) {
+    SimuStateSectionHeader sectionHeader;
+    if (end - pos < (ptrdiff_t)sizeof(sectionHeader))
+      return false;
+    memcpy(&sectionHeader, pos, sizeof(sectionHeader));
+    pos += sizeof(sectionHeader);
+    if (sectionHeader.id != simuStateSections[i].id || sectionHeader.size != simuStateSections[i].size || end - pos < (ptrdiff_t)sectionHeader.size)
+      return false;
+    data[i] = pos;
+    pos += sectionHeader.size;
+  }
+
+  return true;
+}
+
+static void rebaseTimestamp(tmr10ms_t & timestamp, tmr10ms_t delta)
+{
+  // 0 means no timestamp
+  if (timestamp) {
+    timestamp += delta;
+    if (!timestamp)
+      timestamp = 1;
+  }
+}
+
+static void simuStateRestore(const uint8_t * data[])
+{
+  for (unsigned i=0; i<DIM(simuStateSections); i++) {
+    memcpy(simuStateSections[i].data, data[i], simuStateSections[i].size);
+  }
+
+  tmr10ms_t delta = get_tmr10ms() - simuStateTime;
+  for (int i=0; i<MAX_SPECIAL_FUNCTIONS; i++) {
+    rebaseTimestamp(modelFunctionsContext.lastFunctionTime[i], delta);
+    rebaseTimestamp(globalFunctionsContext.lastFunctionTime[i], delta);
+  }
+  rebaseTimestamp(flightModeTransitionTime, delta);
+
+  postModelRestore();
+}
+
+uint32_t simuSaveState(uint8_t * buffer, uint32_t size)
+{
+  uint32_t total = simuStateSize();
+  if (!buffer || size < total)
+    return total;
+
+  bool tasks = simuTasksRunning();
+  if (tasks && !simuTasksStop(SIMU_TASKS_COUNT))
+    return 0;
+  simuStateSave(buffer);
+  if (tasks)
+    simuTasksResume();
+
+  return total;
+}
+
+bool simuRestoreState(const uint8_t * buffer, uint32_t size)
+{
+  // check the whole snapshot before touching the firmware state
+  const uint8_t * data[DIM(simuStateSections)];
+  if (!simuStateParse(buffer, size, data))
+    return false;
+
+  bool tasks = simuTasksRunning();
+  if (tasks && !simuTasksStop(SIMU_TASKS_COUNT))
+    return false;
+  simuStateRestore(data);
+  if (tasks)
+    simuTasksResume();
+
+  return true;
+}
+
+void simuBooted()
+{
+  // the menus task parks the other ones
+  if (!simuTasksStop(SIMU_TASKS_COUNT - 1))
+    return;
+  simuBootState.resize(simuStateSize());
+  simuStateSave(simuBootState.data());
+  simuTasksResume();
+}
+
+bool simuSuspend()
+{
+  if (!simuTasksRunning() || simuBootState.empty())
+    return false;
+
+  if (!simuTasksStop(SIMU_TASKS_COUNT))
+    return false;
+
+#if defined(SDCARD)
+  logsClose();
+#endif
+  storageFlushCurrentModel();
+  storageCheck(true);
+  FlushEepromFile();
+
+  // the tasks stay parked until simuResume() or StopSimu()
+  simu_suspended = true;
+  simuTasksRequestMutex.unlock();
+  return true;
+}
+
+bool simuIsSuspended()
+{
+  return simu_suspended;
+}
+
+// reads the radio settings and the current model again, without the alerts
+// of a boot as the caller would wait for them
+static bool simuStorageReload()
+{
+#if defined(EEPROM)
+  if (!storageReadRadioSettings(false))
+    return false;
+  eeLoadModel(g_eeGeneral.currModel, false);
+#else
+  if (loadRadioSettings() != nullptr)
+    return false;
+  for (uint8_t i = 0; languagePacks[i] != nullptr; i++) {
+    if (!strncmp(g_eeGeneral.ttsLanguage, languagePacks[i]->id, 2)) {
+      currentLanguagePackIdx = i;
+      currentLanguagePack = languagePacks[i];
+    }
+  }
+  if (loadModel(g_eeGeneral.currModelFilename, false) != nullptr)
+    return false;
+  modelslist.clear();
+  modelslist.load();
+#endif
+  return true;
+}
+
+bool simuResume(bool reload)
+{
+  if (!simu_suspended)
+    return false;
+
+  const uint8_t * data[DIM(simuStateSections)];
+  if (!simuStateParse(simuBootState.data(), simuBootState.size(), data))
+    return false;
+
+  // the boot state only matches the storage if the radio settings and the
+  // model were not changed since the boot (section 1 and 2)
+  if (memcmp(data[0], &g_eeGeneral, sizeof(g_eeGeneral)) || memcmp(data[1], &g_model, sizeof(g_model)))
+    reload = true;
+
+  simuTasksRequestMutex.lock();
+  simuStateRestore(data);
+  if (reload && !simuStorageReload()) {
+    simuTasksRequestMutex.unlock();
+    return false;
+  }
+  AUDIO_FLUSH();
+#if defined(GUI)
+  CLEAR_POPUP();
+#endif
+  menuHandlers[0] = menuMainView;
+  menuLevel = 0;
+#if defined(RTCLOCK)
+  g_rtcTime = time(0);
+#endif
+  simu_suspended = false;
+  simuTasksResume();
+  return true;
+}
+
 struct SimulatorAudio {
   int volumeGain;
   int currentVolume;
@@ -242,6 +674,29 @@ bool simuIsRunning()
 
 uint8_t simuSleep(uint32_t ms)
 {
+  if (simuClockGet() == SIMU_CLOCK_VIRTUAL && !simuClockIsStepper()) {
+    // the other threads wait for the stepping thread to move the clock
+    uint64_t end = simuTimerMicros() + 1000 * (uint64_t)ms;
+    while (simuTimerMicros() < end) {
+      if (simu_shutdown)
+        return 1;
+      sleep(1);
+    }
+    return (simu_shutdown || !simu_running);
+  }
+
+  if (simuClockGet() == SIMU_CLOCK_VIRTUAL) {
+    uint32_t periods = simuClockAdvance(1000 * (uint64_t)ms);
+    // a headless firmware waits in the stepping thread, nothing else would
+    // move g_tmr10ms for the loops waiting on it
+    if (simu_headless) {
+      while (periods--) {
+        per10ms();
+      }
+    }
+    return (simu_shutdown || !simu_running);
+  }
+
   for (uint32_t i = 0; i < ms; ++i){
     if (simu_shutdown || !simu_running)
       return 1;
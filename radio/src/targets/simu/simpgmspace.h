@@ -231,6 +231,8 @@ extern uint32_t Master_frequency;
 
 extern uint8_t simu_start_mode;
 extern char * main_thread_error;
+extern bool simu_headless;
+extern void (* simuAudioCallback)(const char * event);
 
 #define OPENTX_START_DEFAULT_ARGS  simu_start_mode
 
@@ -238,18 +240,46 @@ inline void getADC() { }
 
 uint64_t simuTimerMicros(void);
 
+// the simulator time source, used by the RTOS shims and the firmware timers
+enum SimuClock {
+  SIMU_CLOCK_WALL,     // host clock, for interactive use
+  SIMU_CLOCK_VIRTUAL,  // only moves when advanced (tests, headless runs)
+};
+void simuClockSet(uint8_t clock);  // the calling thread becomes the one advancing the virtual clock
+uint8_t simuClockGet();
+uint32_t simuClockAdvance(uint64_t micros);  // returns the number of 10ms periods crossed, 0 in the other threads
+
 void simuInit();
-void StartSimu(bool tests=true, const char * sdPath = 0, const char * settingsPath = 0);
+void StartSimu(bool tests=true, const char * sdPath = 0, const char * settingsPath = 0, bool headless = false);
 void StopSimu();
 bool simuIsRunning();
+void simuStep(uint32_t ms);
 uint8_t simuSleep(uint32_t ms);  // returns true if thread shutdown requested
 
+// firmware RAM state snapshots (radio settings, current model, timers, telemetry,
+// logical switches, mixer delays and slow values, special functions); simuSaveState()
+// returns the size of the snapshot and only writes it if the buffer is large enough,
+// 0 if the firmware tasks could not be stopped. Both run with the tasks parked.
+uint32_t simuSaveState(uint8_t * buffer, uint32_t size);
+bool simuRestoreState(const uint8_t * buffer, uint32_t size);
+bool simuTaskSafePoint();  // called by the tasks between two iterations, returns true if shutdown requested meanwhile
+
+// a booted firmware can be suspended between two sessions (storage flushed, tasks
+// parked) and resumed as it was right after its boot; simuResume() reads the radio
+// settings and the model again if the storage changed meanwhile (reload) or if they
+// changed since the boot, StopSimu() stops it for good
+void simuBooted();  // called by the menus task once the boot is done
+bool simuSuspend();
+bool simuResume(bool reload);
+bool simuIsSuspended();
+
 void simuSetKey(uint8_t key, bool state);
 void simuSetTrim(uint8_t trim, bool state);
 void simuSetSwitch(uint8_t swtch, int8_t state);
 
 void StartEepromThread(const char *filename="eeprom.bin");
 void StopEepromThread();
+void FlushEepromFile();
 #if defined(SIMU_AUDIO)
   void StartAudioThread(int volumeGain = 10);
   void StopAudioThread(void);
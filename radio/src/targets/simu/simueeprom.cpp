@@ -173,6 +173,14 @@ void StopEepromThread()
   free(eeprom_write_sem);
 #endif
 
-  if (fp)
+  if (fp) {
     fclose(fp);
+    fp = nullptr;
+  }
+}
+
+void FlushEepromFile()
+{
+  if (fp)
+    fflush(fp);
 }
@@ -119,7 +119,7 @@ bool redirectToSettingsDirectory(const std::string & path)
     Decide if we use special simuSettingsDirectory path or normal path
 
     We use special path for:
-      * radio settings and models list in /RADIO directory
+      * radio settings, models list, models cache and thumbnails in /RADIO directory
       * model (*.bin) files in /MODELS directory
   */
   if (!simuSettingsDirectory.empty()) {
@@ -127,6 +127,10 @@ bool redirectToSettingsDirectory(const std::string & path)
     if (path == RADIO_MODELSLIST_PATH || path == RADIO_SETTINGS_PATH) {
       return true;
     }
+    // the models cache and thumbnails describe the models of the settings directory
+    if (path == RADIO_MODELSCACHE_PATH || startsWith(path, THUMBNAILS_PATH)) {
+      return true;
+    }
 #endif
     if (startsWith(path, "/MODELS") && endsWith(path, MODELS_EXT)) {
       return true;
@@ -285,6 +289,15 @@ std::string findTrueFileName(const std::string & path)
   return std::string(path);
 }
 
+void setFileInfo(FILINFO * fno, const struct stat & tmp)
+{
+  // convert to FatFs fdate/ftime
+  struct tm *ltime = localtime(&tmp.st_mtime);
+  fno->fdate = ((ltime->tm_year - 80) << 9) | ((ltime->tm_mon + 1) << 5) | ltime->tm_mday;
+  fno->ftime = (ltime->tm_hour << 11) | (ltime->tm_min << 5) | (ltime->tm_sec / 2);
+  fno->fsize = (DWORD)tmp.st_size;
+}
+
 FRESULT f_stat (const TCHAR * name, FILINFO *fno)
 {
   std::string path = convertToSimuPath(name);
@@ -298,11 +311,7 @@ FRESULT f_stat (const TCHAR * name, FILINFO *fno)
     TRACE_SIMPGMSPACE("f_stat(%s) = OK", path.c_str());
     if (fno) {
       fno->fattrib = (tmp.st_mode & S_IFDIR) ? AM_DIR : 0;
-      // convert to FatFs fdate/ftime
-      struct tm *ltime = localtime(&tmp.st_mtime);
-      fno->fdate = ((ltime->tm_year - 80) << 9) | ((ltime->tm_mon + 1) << 5) | ltime->tm_mday;
-      fno->ftime = (ltime->tm_hour << 11) | (ltime->tm_min << 5) | (ltime->tm_sec / 2);
-      fno->fsize = (DWORD)tmp.st_size;
+      setFileInfo(fno, tmp);
     }
     return FR_OK;
   }
@@ -412,12 +421,16 @@ FRESULT f_chdir (const TCHAR *name)
   return FR_OK;
 }
 
+// the opened directories paths, needed to get the files sizes and dates
+std::map<void *, std::string> openedDirectories;
+
 FRESULT f_opendir (DIR * rep, const TCHAR * name)
 {
   std::string path = convertToSimuPath(name);
   rep->obj.fs = (FATFS *)simu::opendir(path.c_str());
   if (rep->obj.fs) {
     TRACE_SIMPGMSPACE("f_opendir(%s) = OK", path.c_str());
+    openedDirectories[rep->obj.fs] = path;
     return FR_OK;
   }
   TRACE_SIMPGMSPACE("f_opendir(%s) = error %d (%s)", path.c_str(), errno, strerror(errno));
@@ -428,6 +441,7 @@ FRESULT f_closedir (DIR * rep)
 {
   TRACE_SIMPGMSPACE("f_closedir(%p)", rep);
   if (rep->obj.fs) {
+    openedDirectories.erase(rep->obj.fs);
     simu::closedir((simu::DIR *)rep->obj.fs);
   }
   return FR_OK;
@@ -458,6 +472,17 @@ FRESULT f_readdir (DIR * rep, FILINFO * fil)
   }
 #endif
 
+  fil->fsize = 0;
+  fil->fdate = 0;
+  fil->ftime = 0;
+  auto directory = openedDirectories.find(rep->obj.fs);
+  if (directory != openedDirectories.end()) {
+    struct stat tmp;
+    if (stat((directory->second + "/" + ent->d_name).c_str(), &tmp) == 0) {
+      setFileInfo(fil, tmp);
+    }
+  }
+
   memset(fil->fname, 0, _MAX_LFN);
   strcpy(fil->fname, ent->d_name);
   // TRACE_SIMPGMSPACE("f_readdir(): %s", fil->fname);
@@ -235,6 +235,23 @@ bool telemetryGetByte(uint8_t * byte)
 #endif
 }
 
+uint32_t telemetryGetBytes(uint8_t * buffer, uint32_t count)
+{
+#if defined(AUX_SERIAL)
+  if (telemetryProtocol == PROTOCOL_TELEMETRY_FRSKY_D_SECONDARY) {
+    if (auxSerialMode == UART_MODE_TELEMETRY)
+      return auxSerialRxFifo.read(buffer, count);
+    else
+      return 0;
+  }
+  else {
+    return telemetryFifo.read(buffer, count);
+  }
+#else
+  return telemetryFifo.read(buffer, count);
+#endif
+}
+
 void telemetryClearFifo()
 {
   telemetryFifo.clear();
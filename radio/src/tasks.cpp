@@ -26,6 +26,9 @@ RTOS_DEFINE_STACK(menusStack, MENUS_STACK_SIZE);
 RTOS_TASK_HANDLE mixerTaskId;
 RTOS_DEFINE_STACK(mixerStack, MIXER_STACK_SIZE);
 
+RTOS_TASK_HANDLE telemetryTaskId;
+RTOS_DEFINE_STACK(telemetryStack, TELEMETRY_STACK_SIZE);
+
 RTOS_TASK_HANDLE audioTaskId;
 RTOS_DEFINE_STACK(audioStack, AUDIO_STACK_SIZE);
 
@@ -35,6 +38,7 @@ RTOS_MUTEX_HANDLE mixerMutex;
 enum TaskIndex {
   MENU_TASK_INDEX,
   MIXER_TASK_INDEX,
+  TELEMETRY_TASK_INDEX,
   AUDIO_TASK_INDEX,
   CLI_TASK_INDEX,
   BLUETOOTH_TASK_INDEX,
@@ -46,6 +50,7 @@ void stackPaint()
 {
   menusStack.paint();
   mixerStack.paint();
+  telemetryStack.paint();
   audioStack.paint();
 #if defined(CLI)
   cliStack.paint();
@@ -101,30 +106,103 @@ void sendSynchronousPulses()
 }
 
 uint32_t nextMixerTime[NUM_MODULES];
+uint32_t mixerLastRunTime;
 
-TASK_FUNCTION(mixerTask)
+// runs the mixer when it is due, every 10ms or when a module needs new pulses
+void mixerTaskWakeup()
 {
-  static uint32_t lastRunTime;
-  s_pulses_paused = true;
+  uint32_t now = RTOS_GET_MS();
+  bool run = false;
 
-  while (true) {
+  if (now - mixerLastRunTime >= 10) {
+    // run at least every 10ms
+    run = true;
+  }
+
+#if defined(INTMODULE_USART) && defined(INTMODULE_HEARTBEAT)
+  if ((moduleState[INTERNAL_MODULE].protocol == PROTOCOL_CHANNELS_PXX2_HIGHSPEED || moduleState[INTERNAL_MODULE].protocol == PROTOCOL_CHANNELS_PXX1_SERIAL) && heartbeatCapture.valid && heartbeatCapture.timestamp > mixerLastRunTime) {
+    run = true;
+  }
+#endif
+
+  if (now == nextMixerTime[0]) {
+    run = true;
+  }
+
+#if NUM_MODULES >= 2
+  if (now == nextMixerTime[1]) {
+    run = true;
+  }
+#endif
+
+  if (!run) {
+    return;
+  }
+
+  mixerLastRunTime = now;
+
+  if (!s_pulses_paused) {
+    uint16_t t0 = getTmr2MHz();
+
+    DEBUG_TIMER_START(debugTimerMixer);
+    RTOS_LOCK_MUTEX(mixerMutex);
+    doMixerCalculations();
+    DEBUG_TIMER_START(debugTimerMixerCalcToUsage);
+    DEBUG_TIMER_SAMPLE(debugTimerMixerIterval);
+    RTOS_UNLOCK_MUTEX(mixerMutex);
+    DEBUG_TIMER_STOP(debugTimerMixer);
+
+#if defined(STM32) && !defined(SIMU)
+    if (getSelectedUsbMode() == USB_JOYSTICK_MODE) {
+      usbJoystickUpdate();
+    }
+#endif
+
+#if defined(PCBSKY9X) && !defined(SIMU)
+    usbJoystickUpdate();
+#endif
+
+    if (heartbeat == HEART_WDT_CHECK) {
+      wdt_reset();
+      heartbeat = 0;
+    }
+
+    t0 = getTmr2MHz() - t0;
+    if (t0 > maxMixerDuration)
+      maxMixerDuration = t0;
+
+    sendSynchronousPulses();
+  }
+}
+
+// the devices polled by the mixer task at each tick
+static void mixerTaskHooks()
+{
 #if defined(PCBTARANIS) && defined(SBUS)
-    // SBUS trainer
-    processSbusInput();
+  // SBUS trainer
+  processSbusInput();
 #endif
 
 #if defined(GYRO)
-    gyro.wakeup();
+  gyro.wakeup();
 #endif
 
 #if defined(BLUETOOTH)
-    bluetooth.wakeup();
+  bluetooth.wakeup();
 #endif
+}
+
+TASK_FUNCTION(mixerTask)
+{
+  s_pulses_paused = true;
+
+  while (true) {
+    mixerTaskHooks();
 
     RTOS_WAIT_TICKS(1);
 
 #if defined(SIMU)
-    if (pwrCheck() == e_power_off) {
+    if (pwrCheck() == e_power_off || simuTaskSafePoint()) {
       TASK_RETURN();
     }
 #else
@@ -133,71 +211,27 @@ TASK_FUNCTION(mixerTask)
     }
 #endif
 
-    uint32_t now = RTOS_GET_MS();
-    bool run = false;
-
-    if (now - lastRunTime >= 10) {
-      // run at least every 10ms
-      run = true;
-    }
-
-#if defined(INTMODULE_USART) && defined(INTMODULE_HEARTBEAT)
-    if ((moduleState[INTERNAL_MODULE].protocol == PROTOCOL_CHANNELS_PXX2_HIGHSPEED || moduleState[INTERNAL_MODULE].protocol == PROTOCOL_CHANNELS_PXX1_SERIAL) && heartbeatCapture.valid && heartbeatCapture.timestamp > lastRunTime) {
-      run = true;
-    }
-#endif
+    mixerTaskWakeup();
+  }
+}
 
-    if (now == nextMixerTime[0]) {
-      run = true;
-    }
+// telemetry decoding runs with a lower priority than the mixer, which reads the
+// sensors values from the snapshot published at the end of each telemetryWakeup()
+TASK_FUNCTION(telemetryTask)
+{
+  while (true) {
+    RTOS_WAIT_TICKS(1);
 
-#if NUM_MODULES >= 2
-    if (now == nextMixerTime[1]) {
-      run = true;
+#if defined(SIMU)
+    if (pwrCheck() == e_power_off || simuTaskSafePoint()) {
+      TASK_RETURN();
     }
 #endif
 
-    if (!run) {
-      continue;  // go back to sleep
-    }
-
-    lastRunTime = now;
-
     if (!s_pulses_paused) {
-      uint16_t t0 = getTmr2MHz();
-
-      DEBUG_TIMER_START(debugTimerMixer);
-      RTOS_LOCK_MUTEX(mixerMutex);
-      doMixerCalculations();
-      DEBUG_TIMER_START(debugTimerMixerCalcToUsage);
-      DEBUG_TIMER_SAMPLE(debugTimerMixerIterval);
-      RTOS_UNLOCK_MUTEX(mixerMutex);
-      DEBUG_TIMER_STOP(debugTimerMixer);
-
-#if defined(STM32) && !defined(SIMU)
-      if (getSelectedUsbMode() == USB_JOYSTICK_MODE) {
-        usbJoystickUpdate();
-      }
-#endif
-
-#if defined(PCBSKY9X) && !defined(SIMU)
-      usbJoystickUpdate();
-#endif
-
       DEBUG_TIMER_START(debugTimerTelemetryWakeup);
       telemetryWakeup();
       DEBUG_TIMER_STOP(debugTimerTelemetryWakeup);
-
-      if (heartbeat == HEART_WDT_CHECK) {
-        wdt_reset();
-        heartbeat = 0;
-      }
-
-      t0 = getTmr2MHz() - t0;
-      if (t0 > maxMixerDuration)
-        maxMixerDuration = t0;
-
-      sendSynchronousPulses();
     }
   }
 }
@@ -231,6 +265,10 @@ TASK_FUNCTION(menusTask)
 {
   opentxInit();
 
+#if defined(SIMU)
+  simuBooted();
+#endif
+
 #if defined(PWR_BUTTON_PRESS)
   while (true) {
     uint32_t pwr_check = pwrCheck();
@@ -263,6 +301,13 @@ TASK_FUNCTION(menusTask)
     }
 
     resetForcePowerOffRequest();
+
+#if defined(SIMU)
+    // a suspended simulator stops without closing, see StopSimu()
+    if (simuTaskSafePoint()) {
+      TASK_RETURN();
+    }
+#endif
   }
 
 #if defined(PCBX9E)
@@ -280,15 +325,48 @@ TASK_FUNCTION(menusTask)
   TASK_RETURN();
 }
 
+#if defined(SIMU)
+// headless simulation: there are no threads, the simulator runs the tasks
+// one tick at a time in its own thread
+void tasksStep()
+{
+  static uint32_t menusLastRunTime;
+
+  mixerTaskHooks();
+  mixerTaskWakeup();
+
+  if (!s_pulses_paused) {
+    telemetryWakeup();
+  }
+
+  uint32_t now = (uint32_t)RTOS_GET_TIME();
+  if (now - menusLastRunTime >= MENU_TASK_PERIOD_TICKS) {
+    menusLastRunTime = now;
+    perMain();
+  }
+}
+#endif
+
 void tasksStart()
 {
   RTOS_INIT();
 
+#if defined(SIMU)
+  if (simu_headless) {
+    s_pulses_paused = true;
+    RTOS_CREATE_MUTEX(audioMutex);
+    RTOS_CREATE_MUTEX(mixerMutex);
+    opentxInit();
+    return;
+  }
+#endif
+
 #if defined(CLI)
   cliStart();
 #endif
 
   RTOS_CREATE_TASK(mixerTaskId, mixerTask, "mixer", mixerStack, MIXER_STACK_SIZE, MIXER_TASK_PRIO);
+  RTOS_CREATE_TASK(telemetryTaskId, telemetryTask, "telemetry", telemetryStack, TELEMETRY_STACK_SIZE, TELEMETRY_TASK_PRIO);
   RTOS_CREATE_TASK(menusTaskId, menusTask, "menus", menusStack, MENUS_STACK_SIZE, MENUS_TASK_PRIO);
 
 #if !defined(SIMU)
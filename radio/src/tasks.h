@@ -26,10 +26,12 @@
 // stack sizes should be in multiples of 8 for better alignment
 #define MENUS_STACK_SIZE       2000
 #define MIXER_STACK_SIZE       400
+#define TELEMETRY_STACK_SIZE   400
 #define AUDIO_STACK_SIZE       400
 #define CLI_STACK_SIZE         1000  // only consumed with CLI build option
 
 #define MIXER_TASK_PRIO        5
+#define TELEMETRY_TASK_PRIO    6
 #define AUDIO_TASK_PRIO        7
 #define MENUS_TASK_PRIO        10
 #define CLI_TASK_PRIO          10
@@ -40,6 +42,9 @@ extern RTOS_DEFINE_STACK(menusStack, MENUS_STACK_SIZE);
 extern RTOS_TASK_HANDLE mixerTaskId;
 extern RTOS_DEFINE_STACK(mixerStack, MIXER_STACK_SIZE);
 
+extern RTOS_TASK_HANDLE telemetryTaskId;
+extern RTOS_DEFINE_STACK(telemetryStack, TELEMETRY_STACK_SIZE);
+
 extern RTOS_TASK_HANDLE audioTaskId;
 extern RTOS_DEFINE_STACK(audioStack, AUDIO_STACK_SIZE);
 
@@ -48,6 +53,9 @@ extern RTOS_FLAG_HANDLE openTxInitCompleteFlag;
 
 void stackPaint();
 void tasksStart();
+#if defined(SIMU)
+void tasksStep();
+#endif
 
 extern volatile uint16_t timeForcePowerOffPressed;
 inline void resetForcePowerOffRequest()
@@ -191,14 +191,19 @@ void processCrossfireTelemetryFrame()
   }
 }
 
-void processCrossfireTelemetryData(uint8_t data)
+void processCrossfireTelemetryBuffer()
 {
-#if defined(AUX_SERIAL)
-  if (g_eeGeneral.auxSerialMode == UART_MODE_TELEMETRY_MIRROR) {
-    auxSerialPutc(data);
+#if defined(BLUETOOTH)
+  if (g_eeGeneral.bluetoothMode == BLUETOOTH_TELEMETRY && bluetooth.state == BLUETOOTH_STATE_CONNECTED) {
+    bluetooth.write(telemetryRxBuffer, telemetryRxBufferCount);
   }
 #endif
+  processCrossfireTelemetryFrame();
+  telemetryRxBufferCount = 0;
+}
 
+void pushCrossfireTelemetryData(uint8_t data)
+{
   if (telemetryRxBufferCount == 0 && data != RADIO_ADDRESS) {
     TRACE("[XF] address 0x%02X error", data);
     return;
@@ -221,13 +226,59 @@ void processCrossfireTelemetryData(uint8_t data)
   if (telemetryRxBufferCount > 4) {
     uint8_t length = telemetryRxBuffer[1];
     if (length + 2 == telemetryRxBufferCount) {
-#if defined(BLUETOOTH)
-      if (g_eeGeneral.bluetoothMode == BLUETOOTH_TELEMETRY && bluetooth.state == BLUETOOTH_STATE_CONNECTED) {
-        bluetooth.write(telemetryRxBuffer, telemetryRxBufferCount);
-      }
+      processCrossfireTelemetryBuffer();
+    }
+  }
+}
+
+void processCrossfireTelemetryData(uint8_t data)
+{
+#if defined(AUX_SERIAL)
+  if (g_eeGeneral.auxSerialMode == UART_MODE_TELEMETRY_MIRROR) {
+    auxSerialPutc(data);
+  }
 #endif
-      processCrossfireTelemetryFrame();
-      telemetryRxBufferCount = 0;
+
+  pushCrossfireTelemetryData(data);
+}
+
+void processCrossfireTelemetryData(const uint8_t * data, uint32_t count)
+{
+#if defined(AUX_SERIAL)
+  if (g_eeGeneral.auxSerialMode == UART_MODE_TELEMETRY_MIRROR) {
+    for (uint32_t i=0; i<count; i++) {
+      auxSerialPutc(data[i]);
+    }
+  }
+#endif
+
+  const uint8_t * end = data + count;
+  while (data < end) {
+    if (telemetryRxBufferCount == 0) {
+      // frame sync: skip everything up to the next frame start
+      const uint8_t * start = (const uint8_t *)memchr(data, RADIO_ADDRESS, end - data);
+      if (start != data) {
+        TRACE("[XF] address error, %d bytes skipped", int((start ? start : end) - data));
+        if (!start) {
+          return;
+        }
+        data = start;
+      }
+    }
+
+    if (telemetryRxBufferCount < 2 || telemetryRxBuffer[1] < 3) {
+      // the frame header is checked byte by byte
+      pushCrossfireTelemetryData(*data++);
+    }
+    else {
+      // the frame payload is copied at once
+      uint32_t len = min<uint32_t>(telemetryRxBuffer[1] + 2 - telemetryRxBufferCount, end - data);
+      memcpy(&telemetryRxBuffer[telemetryRxBufferCount], data, len);
+      telemetryRxBufferCount += len;
+      data += len;
+      if (telemetryRxBufferCount == telemetryRxBuffer[1] + 2) {
+        processCrossfireTelemetryBuffer();
+      }
     }
   }
 }
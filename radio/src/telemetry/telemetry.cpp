@@ -27,6 +27,9 @@ uint8_t telemetryRxBufferCount = 0;
 
 uint8_t telemetryState = TELEMETRY_INIT;
 
+volatile uint8_t telemetryResetRequest = 0;
+volatile uint8_t telemetryItemResetRequests[MAX_TELEMETRY_SENSORS];
+
 TelemetryData telemetryData;
 
 uint8_t telemetryProtocol = 255;
@@ -62,6 +65,20 @@ void processTelemetryData(uint8_t data)
   processFrskyTelemetryData(data);
 }
 
+void processTelemetryData(const uint8_t * data, uint32_t count)
+{
+#if defined(CROSSFIRE)
+  if (telemetryProtocol == PROTOCOL_TELEMETRY_CROSSFIRE) {
+    processCrossfireTelemetryData(data, count);
+    return;
+  }
+#endif
+
+  for (uint32_t i=0; i<count; i++) {
+    processTelemetryData(data[i]);
+  }
+}
+
 inline bool isBadAntennaDetected()
 {
   if (!isRasValueValid())
@@ -76,8 +93,25 @@ inline bool isBadAntennaDetected()
   return false;
 }
 
+static void telemetryProcessResetRequests()
+{
+  if (telemetryResetRequest) {
+    telemetryResetRequest = 0;
+    telemetryReset();
+  }
+
+  for (uint8_t i=0; i<MAX_TELEMETRY_SENSORS; i++) {
+    if (telemetryItemResetRequests[i]) {
+      telemetryItemResetRequests[i] = 0;
+      telemetryItems[i].clear();
+    }
+  }
+}
+
 void telemetryWakeup()
 {
+  telemetryProcessResetRequests();
+
   uint8_t requiredTelemetryProtocol = modelTelemetryProtocol();
 
 #if defined(REVX)
@@ -116,13 +150,14 @@ void telemetryWakeup()
 #endif
 
 #if defined(STM32)
-  uint8_t data;
-  if (telemetryGetByte(&data)) {
+  uint8_t data[TELEMETRY_RX_CHUNK_SIZE];
+  uint32_t count = telemetryGetBytes(data, sizeof(data));
+  if (count > 0) {
     LOG_TELEMETRY_WRITE_START();
     do {
-      processTelemetryData(data);
-      LOG_TELEMETRY_WRITE_BYTE(data);
-    } while (telemetryGetByte(&data));
+      processTelemetryData(data, count);
+      LOG_TELEMETRY_WRITE_BYTES(data, count);
+    } while ((count = telemetryGetBytes(data, sizeof(data))) > 0);
   }
 #elif defined(PCBSKY9X)
   if (telemetryProtocol == PROTOCOL_TELEMETRY_FRSKY_D_SECONDARY) {
@@ -137,12 +172,7 @@ void telemetryWakeup()
   }
 #endif
 
-  for (int i=0; i<MAX_TELEMETRY_SENSORS; i++) {
-    const TelemetrySensor & sensor = g_model.telemetrySensors[i];
-    if (sensor.type == TELEM_TYPE_CALCULATED) {
-      telemetryItems[i].eval(sensor);
-    }
-  }
+  telemetryCalculatedSensors.wakeup();
 
 #if defined(VARIO)
   if (TELEMETRY_STREAMING() && !IS_FAI_ENABLED()) {
@@ -210,6 +240,8 @@ void telemetryWakeup()
       }
     }
   }
+
+  telemetrySnapshot.publish();
 }
 
 void telemetryInterrupt10ms()
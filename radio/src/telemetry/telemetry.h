@@ -44,6 +44,11 @@ enum TelemetryStates {
 };
 extern uint8_t telemetryState;
 
+// resets asked by the special functions (mixer task), done by the telemetry task
+// which is the only one writing telemetryItems
+extern volatile uint8_t telemetryResetRequest;
+extern volatile uint8_t telemetryItemResetRequests[MAX_TELEMETRY_SENSORS];
+
 constexpr uint8_t TELEMETRY_TIMEOUT10ms = 100; // 1 second
 
 #define TELEMETRY_SERIAL_DEFAULT       0
@@ -57,6 +62,8 @@ constexpr uint8_t TELEMETRY_TIMEOUT10ms = 100; // 1 second
 #define TELEMETRY_RX_PACKET_SIZE       19  // 9 bytes (full packet), worst case 18 bytes with byte-stuffing (+1)
 #endif
 
+#define TELEMETRY_RX_CHUNK_SIZE        32  // bytes read at once from the telemetry driver FIFO
+
 extern uint8_t telemetryRxBuffer[TELEMETRY_RX_PACKET_SIZE];
 extern uint8_t telemetryRxBufferCount;
 
@@ -145,9 +152,11 @@ void logTelemetryWriteStart();
 void logTelemetryWriteByte(uint8_t data);
 #define LOG_TELEMETRY_WRITE_START()    logTelemetryWriteStart()
 #define LOG_TELEMETRY_WRITE_BYTE(data) logTelemetryWriteByte(data)
+#define LOG_TELEMETRY_WRITE_BYTES(data, count) for (uint32_t i=0; i<(count); i++) logTelemetryWriteByte((data)[i])
 #else
 #define LOG_TELEMETRY_WRITE_START()
 #define LOG_TELEMETRY_WRITE_BYTE(data)
+#define LOG_TELEMETRY_WRITE_BYTES(data, count)
 #endif
 
 class OutputTelemetryBuffer {
@@ -23,6 +23,8 @@
 #include <math.h>
 
 TelemetryItem telemetryItems[MAX_TELEMETRY_SENSORS];
+TelemetrySnapshot telemetrySnapshot;
+TelemetryCalculatedSensors telemetryCalculatedSensors;
 uint8_t allowNewSensors;
 
 bool isFaiForbidden(source_t idx)
@@ -82,6 +84,8 @@ void TelemetryItem::setValue(const TelemetrySensor & sensor, int32_t val, uint32
 {
   int32_t newVal = val;
 
+  version++;
+
   if (unit == UNIT_CELLS) {
     uint32_t data = uint32_t(newVal);
     uint8_t cellsCount = (data >> 24);
@@ -460,6 +464,159 @@ void TelemetryItem::eval(const TelemetrySensor & sensor)
   }
 }
 
+uint8_t getCalculatedSensorSources(const TelemetrySensor & sensor, uint8_t * sources)
+{
+  uint8_t count = 0;
+
+  switch (sensor.formula) {
+    case TELEM_FORMULA_CELL:
+      if (sensor.cell.source)
+        sources[count++] = sensor.cell.source - 1;
+      break;
+
+    case TELEM_FORMULA_DIST:
+      if (sensor.dist.gps)
+        sources[count++] = sensor.dist.gps - 1;
+      if (sensor.dist.alt)
+        sources[count++] = sensor.dist.alt - 1;
+      break;
+
+    case TELEM_FORMULA_ADD:
+    case TELEM_FORMULA_AVERAGE:
+    case TELEM_FORMULA_MIN:
+    case TELEM_FORMULA_MAX:
+    case TELEM_FORMULA_MULTIPLY:
+    {
+      int maxitems = (sensor.formula == TELEM_FORMULA_MULTIPLY ? 2 : 4);
+      for (int i=0; i<maxitems; i++) {
+        int8_t source = sensor.calc.sources[i];
+        if (source && abs(source) <= MAX_TELEMETRY_SENSORS)
+          sources[count++] = abs(source) - 1;
+      }
+      break;
+    }
+
+    default:
+      break;
+  }
+
+  return count;
+}
+
+// totalize and consumption sensors are not evaluated here
+inline bool isEvaluatedSensor(const TelemetrySensor & sensor)
+{
+  return sensor.type == TELEM_TYPE_CALCULATED && sensor.formula != TELEM_FORMULA_TOTALIZE && sensor.formula != TELEM_FORMULA_CONSUMPTION;
+}
+
+bool TelemetryCalculatedSensors::isConfigurationChanged()
+{
+  for (int i=0; i<MAX_TELEMETRY_SENSORS; i++) {
+    const TelemetrySensor & sensor = g_model.telemetrySensors[i];
+    const SensorState & state = states[i];
+    if (isEvaluatedSensor(sensor)) {
+      if (!state.calculated || state.formula != sensor.formula || state.param != sensor.param)
+        return true;
+    }
+    else if (state.calculated) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void TelemetryCalculatedSensors::build()
+{
+  uint8_t sources[4];
+
+  for (int i=0; i<MAX_TELEMETRY_SENSORS; i++) {
+    const TelemetrySensor & sensor = g_model.telemetrySensors[i];
+    SensorState & state = states[i];
+    memclear(&state, sizeof(state));
+    if (isEvaluatedSensor(sensor)) {
+      state.calculated = 1;
+      state.formula = sensor.formula;
+      state.param = sensor.param;
+      state.dirty = 1;
+    }
+  }
+
+  // a sensor is ordered once all its calculated sources are ordered
+  count = 0;
+  bool progress = true;
+  while (progress) {
+    progress = false;
+    for (int i=0; i<MAX_TELEMETRY_SENSORS; i++) {
+      SensorState & state = states[i];
+      if (state.calculated && !state.ordered) {
+        bool ready = true;
+        uint8_t sourcesCount = getCalculatedSensorSources(g_model.telemetrySensors[i], sources);
+        for (uint8_t j=0; j<sourcesCount; j++) {
+          const SensorState & sourceState = states[sources[j]];
+          if (sources[j] != i && sourceState.calculated && !sourceState.ordered) {
+            ready = false;
+            break;
+          }
+        }
+        if (ready) {
+          state.ordered = 1;
+          order[count++] = i;
+          progress = true;
+        }
+      }
+    }
+  }
+
+  // the sensors in a dependencies loop are evaluated in their index order
+  for (int i=0; i<MAX_TELEMETRY_SENSORS; i++) {
+    SensorState & state = states[i];
+    if (state.calculated && !state.ordered) {
+      state.ordered = 1;
+      order[count++] = i;
+    }
+  }
+}
+
+void TelemetryCalculatedSensors::reset()
+{
+  memclear(states, sizeof(states));
+  count = 0;
+}
+
+void TelemetryCalculatedSensors::wakeup()
+{
+  uint8_t sources[4];
+
+  if (isConfigurationChanged()) {
+    build();
+  }
+
+  for (uint8_t n=0; n<count; n++) {
+    uint8_t index = order[n];
+    const TelemetrySensor & sensor = g_model.telemetrySensors[index];
+    TelemetryItem & item = telemetryItems[index];
+    SensorState & state = states[index];
+
+    uint16_t inputs = 0;
+    uint8_t sourcesCount = getCalculatedSensorSources(sensor, sources);
+    for (uint8_t j=0; j<sourcesCount; j++) {
+      inputs += telemetryItems[sources[j]].version;
+    }
+
+    if (state.dirty || inputs != state.inputs || item.timeout <= 0) {
+      uint8_t version = item.version;
+      item.eval(sensor);
+      state.dirty = 0;
+      state.inputs = inputs;
+      state.refreshed = (item.version != version && !item.isOld());
+    }
+    else if (state.refreshed) {
+      // same sources values, same result: the sensor only needs to be kept alive
+      item.setFresh();
+    }
+  }
+}
+
 void delTelemetryIndex(uint8_t index)
 {
   memclear(&g_model.telemetrySensors[index], sizeof(TelemetrySensor));
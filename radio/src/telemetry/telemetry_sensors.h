@@ -21,6 +21,7 @@
 #ifndef _TELEMETRY_SENSORS_H_
 #define _TELEMETRY_SENSORS_H_
 
+#include <atomic>
 #include "telemetry.h"
 
 constexpr int8_t TELEMETRY_SENSOR_TIMEOUT_UNAVAILABLE = -2;
@@ -46,6 +47,7 @@ class TelemetryItem
     };
 
     int8_t timeout; // for detection of sensor loss
+    uint8_t version; // incremented on each change, used by the calculated sensors evaluation
 
     union {
       struct {
@@ -77,15 +79,18 @@ class TelemetryItem
       char text[16];
     };
 
-    TelemetryItem()
+    TelemetryItem():
+      version(0)
     {
       clear();
     }
 
     void clear()
     {
+      uint8_t previousVersion = version;
       memset(reinterpret_cast<void*>(this), 0, sizeof(TelemetryItem));
       timeout = TELEMETRY_SENSOR_TIMEOUT_UNAVAILABLE;
+      version = previousVersion + 1;
     }
 
     void eval(const TelemetrySensor & sensor);
@@ -126,11 +131,106 @@ class TelemetryItem
     inline void setOld()
     {
       timeout = TELEMETRY_SENSOR_TIMEOUT_OLD;
+      version++;
     }
 };
 
 extern TelemetryItem telemetryItems[MAX_TELEMETRY_SENSORS];
 extern uint8_t allowNewSensors;
+
+// The sensors values used by the mixer, the menus and Lua, published by the telemetry task
+// at the end of each telemetryWakeup(). Both copies are written in turn and the sequence
+// tells the readers which one is stable: a reader preempting the publish (the mixer) reads
+// the copy not being written, a reader preempted by one or more publishes (the menus, Lua)
+// sees the sequence change and reads again
+class TelemetrySnapshot
+{
+  public:
+    struct Item {
+      int32_t value;
+      int32_t valueMin;
+      int32_t valueMax;
+      int8_t timeout;
+
+      inline bool isOld() const
+      {
+        return (timeout == TELEMETRY_SENSOR_TIMEOUT_OLD);
+      }
+    };
+
+    void publish()
+    {
+      sequence++;    // odd: the readers use items[1]
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      copy(items[0]);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      sequence++;    // even: the readers use items[0]
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      copy(items[1]);
+    }
+
+    Item operator [] (uint8_t index) const
+    {
+      Item result;
+      uint32_t seq;
+      do {
+        seq = sequence;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        result = items[seq & 1][index];
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+      } while (seq != sequence);
+      return result;
+    }
+
+  protected:
+    Item items[2][MAX_TELEMETRY_SENSORS];
+    volatile uint32_t sequence;
+
+    static void copy(Item * destination)
+    {
+      for (uint8_t i=0; i<MAX_TELEMETRY_SENSORS; i++) {
+        const TelemetryItem & item = telemetryItems[i];
+        destination[i].value = item.value;
+        destination[i].valueMin = item.valueMin;
+        destination[i].valueMax = item.valueMax;
+        destination[i].timeout = item.timeout;
+      }
+    }
+};
+
+extern TelemetrySnapshot telemetrySnapshot;
+
+// The calculated sensors are evaluated in the order of their dependencies (so that a chain
+// of calculated sensors settles in one pass), and only when one of their sources changed
+// since their last evaluation. The sensors configuration is compared to the one used to
+// build the order on each pass, so that any change done to the model is taken into account
+class TelemetryCalculatedSensors
+{
+  public:
+    void wakeup();
+    void reset();    // the next wakeup() builds the order again and evaluates every sensor
+
+  protected:
+    struct SensorState {
+      uint32_t param;
+      uint16_t inputs;         // sum of the sources versions at the last evaluation
+      uint8_t  formula;
+      uint8_t  calculated:1;
+      uint8_t  dirty:1;        // evaluation needed whatever the sources
+      uint8_t  refreshed:1;    // the last evaluation gave a value
+      uint8_t  ordered:1;
+      uint8_t  spare:4;
+    };
+
+    SensorState states[MAX_TELEMETRY_SENSORS];
+    uint8_t order[MAX_TELEMETRY_SENSORS];
+    uint8_t count;
+
+    bool isConfigurationChanged();
+    void build();
+};
+
+extern TelemetryCalculatedSensors telemetryCalculatedSensors;
 bool isFaiForbidden(source_t idx);
 
 #endif // _TELEMETRY_SENSORS_H_
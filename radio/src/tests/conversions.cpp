@@ -298,6 +298,49 @@ TEST(Conversions, ConversionX10From22)
 }
 #endif
 
+#if defined(PCBX10)
+TEST(Conversions, ConversionX10FileImage)
+{
+  static uint8_t src[8 + sizeof(ModelData)];
+  static uint8_t dst[8 + sizeof(ModelData)];
+  static uint8_t dst2[8 + sizeof(ModelData)];
+
+  FILE * f = fopen(TESTS_BUILD_PATH "/model_22_x10/MODELS/model1.bin", "rb");
+  ASSERT_NE(nullptr, f);
+  uint32_t srcSize = fread(src, 1, sizeof(src), f);
+  fclose(f);
+
+  uint32_t dstSize = sizeof(dst);
+  EXPECT_EQ(nullptr, convertFileImage(src, srcSize, dst, &dstSize, false));
+  EXPECT_EQ(8 + sizeof(ModelData), dstSize);
+  EXPECT_EQ(EEPROM_VER, dst[4]);
+
+  ModelData & model = *(ModelData *)&dst[8];
+  EXPECT_ZSTREQ("Test", model.header.name);
+  EXPECT_EQ(MIXSRC_FIRST_TRAINER, model.mixData[5].srcRaw);
+  EXPECT_EQ(SWSRC_TELEMETRY_STREAMING, model.mixData[5].swtch);
+  EXPECT_EQ(MODULE_TYPE_R9M_PXX1, model.moduleData[EXTERNAL_MODULE].type);
+  EXPECT_STREQ("Layout2P1", model.screenData[0].layoutName);
+
+  // an image already at the current version is not changed
+  uint32_t dst2Size = sizeof(dst2);
+  EXPECT_EQ(nullptr, convertFileImage(dst, dstSize, dst2, &dst2Size, false));
+  EXPECT_EQ(dstSize, dst2Size);
+  EXPECT_EQ(0, memcmp(dst, dst2, dstSize));
+
+  // nor is a smaller one, written by another build of the same version
+  *(uint16_t *)&dst[6] = sizeof(ModelData) - 16;
+  dst2Size = sizeof(dst2);
+  EXPECT_EQ(nullptr, convertFileImage(dst, dstSize - 16, dst2, &dst2Size, false));
+  EXPECT_EQ(dstSize - 16, dst2Size);
+  EXPECT_EQ(0, memcmp(dst, dst2, dst2Size));
+
+  // not a model file
+  dst2Size = sizeof(dst2);
+  EXPECT_NE(nullptr, convertFileImage(src, 4, dst2, &dst2Size, false));
+}
+#endif
+
 #if defined(PCBX12S)
 TEST(Conversions, ConversionX12SFrom22)
 {
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) OpenTX
+ *
+ * Based on code named
+ *   th9x - http://code.google.com/p/th9x 
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+
+#include <chrono>
+#include "gtests.h"
+
+static uint16_t crc16Bitwise1021(const uint8_t * buf, uint32_t len, uint16_t crc)
+{
+  for (uint32_t i=0; i<len; i++) {
+    crc ^= buf[i] << 8;
+    for (int bit=0; bit<8; bit++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+    }
+  }
+  return crc;
+}
+
+static uint16_t crc16Bytewise(uint8_t index, const uint8_t * buf, uint32_t len, uint16_t crc)
+{
+  const uint16_t * tab = (index == CRC_1021 ? crc16tab_1021[0] : crc16tab_1189[0]);
+  for (uint32_t i=0; i<len; i++) {
+    crc = (crc << 8) ^ tab[((crc >> 8) ^ buf[i]) & 0xFF];
+  }
+  return crc;
+}
+
+static uint8_t crc8Bitwise(const uint8_t * buf, uint32_t len, uint8_t crc)
+{
+  for (uint32_t i=0; i<len; i++) {
+    crc ^= buf[i];
+    for (int bit=0; bit<8; bit++) {
+      crc = (crc & 0x80) ? (crc << 1) ^ 0xD5 : (crc << 1);
+    }
+  }
+  return crc;
+}
+
+static uint8_t crc8Bytewise(const uint8_t * buf, uint32_t len, uint8_t crc)
+{
+  for (uint32_t i=0; i<len; i++) {
+    crc = crc8tab[0][crc ^ buf[i]];
+  }
+  return crc;
+}
+
+TEST(Crc, checkValues)
+{
+  const uint8_t check[] = "123456789";
+  EXPECT_EQ(0x31C3, crc16(CRC_1021, check, 9));
+  EXPECT_EQ(0xBC, crc8(check, 9));
+  EXPECT_EQ(0x1021, crc16tab_1021[0][1]);
+  EXPECT_EQ(0x1189, crc16tab_1189[0][1]);
+}
+
+TEST(Crc, slicedEqualsBytewise)
+{
+  uint8_t buffer[300];
+  srand(1234);
+  for (unsigned i=0; i<sizeof(buffer); i++) {
+    buffer[i] = rand();
+  }
+  for (int test=0; test<1000; test++) {
+    uint32_t offset = rand() % 8;
+    uint32_t len = rand() % (sizeof(buffer) - offset);
+    uint16_t start = rand();
+    const uint8_t * buf = &buffer[offset];
+    ASSERT_EQ(crc16Bitwise1021(buf, len, start), crc16(CRC_1021, buf, len, start));
+    ASSERT_EQ(crc16Bytewise(CRC_1021, buf, len, start), crc16(CRC_1021, buf, len, start));
+    ASSERT_EQ(crc16Bytewise(CRC_1189, buf, len, start), crc16(CRC_1189, buf, len, start));
+    ASSERT_EQ(crc8Bitwise(buf, len, start), crc8(buf, len, start));
+    ASSERT_EQ(crc8Bytewise(buf, len, start), crc8(buf, len, start));
+  }
+}
+
+TEST(Crc, streaming)
+{
+  uint8_t buffer[64];
+  for (unsigned i=0; i<sizeof(buffer); i++) {
+    buffer[i] = i * 7 + 3;
+  }
+
+  for (uint32_t split=0; split<=sizeof(buffer); split++) {
+    EXPECT_EQ(crc16(CRC_1189, buffer, sizeof(buffer)), crc16(CRC_1189, &buffer[split], sizeof(buffer) - split, crc16(CRC_1189, buffer, split)));
+    EXPECT_EQ(crc8(buffer, sizeof(buffer)), crc8(&buffer[split], sizeof(buffer) - split, crc8(buffer, split)));
+  }
+
+  uint16_t crc1021 = 0, crc1189 = 0;
+  uint8_t crc = 0;
+  for (unsigned i=0; i<sizeof(buffer); i+=4) {
+    uint32_t word = buffer[i] + (buffer[i+1] << 8) + (buffer[i+2] << 16) + (buffer[i+3] << 24);
+    crc1021 = crc16UpdateWord(CRC_1021, crc1021, word);
+    crc1189 = crc16Update(CRC_1189, crc16Update(CRC_1189, crc16Update(CRC_1189, crc16Update(CRC_1189, crc1189, word), word >> 8), word >> 16), word >> 24);
+    crc = (i & 4) ? crc8UpdateWord(crc, word) : crc8Update(crc8Update(crc8Update(crc8Update(crc, word), word >> 8), word >> 16), word >> 24);
+  }
+  EXPECT_EQ(crc16(CRC_1021, buffer, sizeof(buffer)), crc1021);
+  EXPECT_EQ(crc16(CRC_1189, buffer, sizeof(buffer)), crc1189);
+  EXPECT_EQ(crc8(buffer, sizeof(buffer)), crc);
+}
+
+// timings only, run with --gtest_also_run_disabled_tests
+TEST(Crc, DISABLED_benchmark)
+{
+  static uint8_t buffer[64*1024];
+  for (unsigned i=0; i<sizeof(buffer); i++) {
+    buffer[i] = i ^ (i >> 8);
+  }
+
+  uint16_t bytewise = 0, sliced = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i=0; i<16; i++) {
+    bytewise = crc16Bytewise(CRC_1021, buffer, sizeof(buffer), bytewise);
+  }
+  auto middle = std::chrono::steady_clock::now();
+  for (int i=0; i<16; i++) {
+    sliced = crc16(CRC_1021, buffer, sizeof(buffer), sliced);
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  EXPECT_EQ(bytewise, sliced);
+  printf("crc16 1MB: bytewise %dus, sliced by 4 %dus\n",
+         (int)std::chrono::duration_cast<std::chrono::microseconds>(middle - start).count(),
+         (int)std::chrono::duration_cast<std::chrono::microseconds>(end - middle).count());
+}
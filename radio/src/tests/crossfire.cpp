@@ -32,9 +32,25 @@ TEST(Crossfire, createCrossfireChannelsFrame)
     pulsesStart[i] = -1024 + (2048 / MAX_TRAINER_CHANNELS) * i;
   }
 
-  createCrossfireChannelsFrame(crossfire, pulsesStart);
+  uint8_t length = createCrossfireChannelsFrame(crossfire, pulsesStart);
 
-  // TODO check
+  EXPECT_EQ(length, 26);
+  EXPECT_EQ(crossfire[0], MODULE_ADDRESS);
+  EXPECT_EQ(crossfire[1], 24);
+  EXPECT_EQ(crossfire[2], CHANNELS_ID);
+
+  // 11 bits channels, LSB first
+  for (int i=0; i<CROSSFIRE_CHANNELS_COUNT; i++) {
+    uint32_t value = 0;
+    for (int bit=0; bit<11; bit++) {
+      int position = i*11 + bit;
+      if (crossfire[3 + position/8] & (1 << (position%8)))
+        value |= 1 << bit;
+    }
+    EXPECT_EQ(value, limit<uint32_t>(0, 0x3E0 + (pulsesStart[i] * 4) / 5, 2*0x3E0));
+  }
+
+  EXPECT_EQ(crossfire[25], crc8(&crossfire[2], 23));
 }
 
 TEST(Crossfire, crc8)
@@ -43,5 +59,36 @@ TEST(Crossfire, crc8)
   uint8_t crc = crc8(&frame[2], frame[1]-1);
   ASSERT_EQ(frame[frame[1]+1], crc);
 }
+
+TEST(Crossfire, processTelemetryDataChunks)
+{
+  MODEL_RESET();
+  TELEMETRY_RESET();
+  telemetryStreaming = TELEMETRY_TIMEOUT10ms;
+  allowNewSensors = true;
+
+  // garbage, then a vario frame, then a truncated frame
+  uint8_t data[] = { 0x00, 0x55, 0xEA, 0x04, CF_VARIO_ID, 0x01, 0x02, 0x00, 0xEA, 0x04, CF_VARIO_ID };
+  data[7] = crc8(&data[4], data[3]-1);
+
+  telemetryRxBufferCount = 0;
+  for (uint32_t i=0; i<sizeof(data); i++) {
+    processCrossfireTelemetryData(data[i]);
+  }
+  int32_t value = telemetryItems[0].value;
+  EXPECT_NE(value, 0);
+  EXPECT_EQ(telemetryRxBufferCount, 3);
+
+  // the same bytes, delivered in chunks of any size, must give the same result
+  for (uint32_t chunk=1; chunk<=sizeof(data); chunk++) {
+    telemetryItems[0].clear();
+    telemetryRxBufferCount = 0;
+    for (uint32_t i=0; i<sizeof(data); i+=chunk) {
+      processCrossfireTelemetryData(&data[i], min<uint32_t>(chunk, sizeof(data)-i));
+    }
+    EXPECT_EQ(telemetryItems[0].value, value);
+    EXPECT_EQ(telemetryRxBufferCount, 3);
+  }
+}
 #endif
 
@@ -18,7 +18,12 @@
  * GNU General Public License for more details.
  */
 
+#include <sys/stat.h>
 #include "gtests.h"
+#include "location.h"
+#if defined(PCBHORUS)
+#include "storage/modelslist.h"
+#endif
 
 extern const char * eepromFile;
 
@@ -42,8 +47,129 @@ TEST(Storage, BackupAndRestore)
   if (memcmp(&ramBackupUncompressed, &ramBackupRestored, sizeof(ramBackupUncompressed)) != 0)
     TRACE("ERROR restore");
 }
+
+extern uint16_t storageModelJournalSize;
+
+static long getModelFileSize()
+{
+  struct stat st;
+  if (stat(TESTS_BUILD_PATH "/journal/MODELS/model1.bin", &st))
+    return -1;
+  return st.st_size;
+}
+
+TEST(Storage, ModelJournal)
+{
+  mkdir(TESTS_BUILD_PATH "/journal", 0777);
+  simuFatfsSetPaths(TESTS_BUILD_PATH "/journal/", TESTS_BUILD_PATH "/journal/");
+  storageFormat();
+
+  modelDefault(0);
+  strcpy(g_eeGeneral.currModelFilename, "model1.bin");
+  storageDirty(EE_MODEL);
+  storageCheck(true);
+  EXPECT_EQ(8 + sizeof(ModelData), getModelFileSize());
+
+  // a trim change only appends a small record
+  g_model.flightModeData[0].trim[0].value = 10;
+  storageDirty(EE_MODEL);
+  storageCheck(false);
+  long size = getModelFileSize();
+  EXPECT_GT(size, (long)(8 + sizeof(ModelData)));
+  EXPECT_LE(size, (long)(8 + sizeof(ModelData) + 8));
+
+  strcpy(g_model.header.name, "JOURNAL");
+  g_model.timers[0].value = 1234;
+  storageDirty(EE_MODEL);
+  storageCheck(false);
+
+  static ModelData model;
+  uint8_t version;
+  uint16_t journalSize;
+  EXPECT_EQ(nullptr, readModel("model1.bin", (uint8_t *)&model, sizeof(model), &version, &journalSize));
+  EXPECT_EQ(getModelFileSize() - 8 - sizeof(ModelData), journalSize);
+  EXPECT_EQ(0, memcmp(&model, &g_model, sizeof(model)));
+
+  // a torn record is ignored, and the next save rewrites the whole file
+  FILE * f = fopen(TESTS_BUILD_PATH "/journal/MODELS/model1.bin", "ab");
+  fwrite("\x01\x00\x08", 1, 3, f);
+  fclose(f);
+  EXPECT_EQ(nullptr, readModel("model1.bin", (uint8_t *)&model, sizeof(model), &version, &journalSize));
+  EXPECT_EQ(0xFFFF, journalSize);
+  EXPECT_EQ(0, memcmp(&model, &g_model, sizeof(model)));
+  g_model.flightModeData[0].trim[0].value = 20;
+  storageDirty(EE_MODEL);
+  storageCheck(false);
+  EXPECT_EQ(8 + sizeof(ModelData), getModelFileSize());
+
+  // the journal is compacted when it gets too big
+  for (int i=0; i<200; i++) {
+    g_model.flightModeData[0].trim[0].value = i;
+    g_model.flightModeData[0].trim[1].value = -i;
+    storageDirty(EE_MODEL);
+    storageCheck(false);
+    EXPECT_LE(getModelFileSize(), (long)(8 + sizeof(ModelData) + 1024));
+  }
+  EXPECT_EQ(nullptr, readModel("model1.bin", (uint8_t *)&model, sizeof(model), &version));
+  EXPECT_EQ(0, memcmp(&model, &g_model, sizeof(model)));
+  EXPECT_NE(0xFFFF, storageModelJournalSize);
+}
+
+#if defined(PCBHORUS)
+TEST(Storage, ModelJournalReaders)
+{
+  mkdir(TESTS_BUILD_PATH "/journal", 0777);
+  simuFatfsSetPaths(TESTS_BUILD_PATH "/journal/", TESTS_BUILD_PATH "/journal/");
+  storageFormat();
+
+  modelDefault(0);
+  strcpy(g_eeGeneral.currModelFilename, "model1.bin");
+  storageDirty(EE_MODEL);
+  storageCheck(true);
+
+  g_model.header.modelId[INTERNAL_MODULE] = 12;
+  g_model.moduleData[EXTERNAL_MODULE].type = MODULE_TYPE_R9M_PXX1;
+  storageDirty(EE_MODEL);
+  storageCheck(false);
+  EXPECT_GT(getModelFileSize(), (long)(8 + sizeof(ModelData)));
+
+  // the models list reads the changes in the journal
+  ModelCell cell("model1.bin");
+  EXPECT_TRUE(cell.fetchRfData());
+  EXPECT_EQ(12, cell.modelId[INTERNAL_MODULE]);
+  EXPECT_EQ(MODULE_TYPE_R9M_PXX1, cell.moduleData[EXTERNAL_MODULE].type);
+
+  // an immediate save (model switch, USB, power off) compacts the journal
+  storageCheck(true);
+  EXPECT_EQ(8 + sizeof(ModelData), getModelFileSize());
+  EXPECT_TRUE(cell.fetchRfData());
+  EXPECT_EQ(12, cell.modelId[INTERNAL_MODULE]);
+  EXPECT_EQ(MODULE_TYPE_R9M_PXX1, cell.moduleData[EXTERNAL_MODULE].type);
+}
+#endif
 #endif
 
+TEST(Storage, ModelLoadStages)
+{
+  MODEL_RESET();
+  g_model.telemetrySensors[0].type = TELEM_TYPE_CALCULATED;
+  g_model.telemetrySensors[0].persistent = 1;
+  g_model.telemetrySensors[0].persistentValue = 1234;
+  telemetryItems[0].value = 0;
+
+  // the persistent sensors are restored before the mixer resumes
+  preModelLoad();
+  postModelLoad(false);
+  EXPECT_EQ(MODEL_LOAD_ALL_STAGES, modelLoadPendingStages);
+  EXPECT_EQ(1234, telemetryItems[0].value);
+
+  // one stage at a time
+  modelLoadWakeup();
+  EXPECT_EQ(MODEL_LOAD_AUDIO, modelLoadPendingStages);
+  modelLoadWakeup();
+  EXPECT_EQ(0, modelLoadPendingStages);
+}
+
 #if defined(EEPROM_RLC)
 TEST(Eeprom, 100_random_writes)
 {
@@ -182,3 +308,87 @@ TEST(Eeprom, rm)
   EXPECT_EQ(sz, 0);
 }
 #endif
+
+#if defined(EEPROM_RAW)
+extern EepromWriteRequest eepromCurrentRequest;
+extern EepromWriteRequest eepromWriteQueue[EEPROM_WRITE_QUEUE_SIZE];
+
+static void writeTestModel(uint8_t index, const char * name)
+{
+  memclear(&g_model, sizeof(g_model));
+  strcpy(g_model.header.name, name);
+  eepromWriteRequest(EEPROM_REQUEST_WRITE_MODEL, index);
+  eepromWriteWait();
+}
+
+static void checkModelName(uint8_t index, const char * name)
+{
+  ModelHeader header;
+  eeLoadModelHeader(index, &header);
+  EXPECT_STREQ(name, header.name);
+}
+
+TEST(Eeprom, queuedWrites)
+{
+  storageFormat();
+  writeTestModel(0, "MODEL1");
+  writeTestModel(1, "MODEL2");
+
+  // the models are seen as they will be once the queue is written
+  eepromWriteRequest(EEPROM_REQUEST_COPY_MODEL, 2, 0);
+  eepromWriteRequest(EEPROM_REQUEST_SWAP_MODELS, 0, 1);
+  eepromWriteRequest(EEPROM_REQUEST_DELETE_MODEL, 1, 0);
+  EXPECT_TRUE(eepromIsWriting());
+  checkModelName(0, "MODEL2");
+  checkModelName(2, "MODEL1");
+  EXPECT_FALSE(eeModelExists(1));
+
+  eepromWriteWait();
+  eepromOpen();
+  checkModelName(0, "MODEL2");
+  checkModelName(2, "MODEL1");
+  EXPECT_FALSE(eeModelExists(1));
+
+  // radio settings go before the models, the same model is written once
+  eepromWriteRequest(EEPROM_REQUEST_WRITE_MODEL, 0);
+  eepromWriteRequest(EEPROM_REQUEST_WRITE_MODEL, 0);
+  eepromWriteRequest(EEPROM_REQUEST_WRITE_GENERAL);
+  EXPECT_EQ(2, eepromWriteQueueCount);
+  EXPECT_EQ(EEPROM_REQUEST_WRITE_GENERAL, eepromWriteQueue[0].type);
+  EXPECT_EQ(EEPROM_REQUEST_WRITE_MODEL, eepromWriteQueue[1].type);
+  eepromWriteWait();
+}
+
+TEST(Eeprom, copyDoesNotBlock)
+{
+  storageFormat();
+  writeTestModel(0, "MODEL1");
+
+  // the source is read asynchronously, each step returns at once
+  eepromWriteRequest(EEPROM_REQUEST_COPY_MODEL, 1, 0);
+  eepromWriteProcess();
+  EXPECT_EQ(EEPROM_READING_COPY_HEADER, eepromWriteState);
+  eepromWriteWait(EEPROM_READING_BUFFER);
+  eepromWriteWait();
+
+  eepromOpen();
+  checkModelName(0, "MODEL1");
+  checkModelName(1, "MODEL1");
+}
+
+TEST(Eeprom, interruptedFatWrite)
+{
+  storageFormat();
+  writeTestModel(0, "MODEL1");
+
+  // power off before the FAT mark is written
+  eepromWriteRequest(EEPROM_REQUEST_DELETE_MODEL, 0);
+  eepromWriteWait(EEPROM_WRITE_FAT_MARK);
+  eepromWriteState = EEPROM_IDLE;
+  eepromCurrentRequest.type = EEPROM_REQUEST_NONE;
+
+  EXPECT_TRUE(eepromOpen());
+  EXPECT_TRUE(eeModelExists(0));
+  checkModelName(0, "MODEL1");
+}
+#endif
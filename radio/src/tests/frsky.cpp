@@ -18,6 +18,8 @@
  * GNU General Public License for more details.
  */
 
+#include <atomic>
+#include <thread>
 #include "gtests.h"
 
 void frskyDProcessPacket(const uint8_t *packet);
@@ -384,6 +386,65 @@ TEST(FrSkySPORT, frskySetCellVoltageTwoSensors)
   lcdClear();
 }
 
+TEST(FrSkySPORT, calculatedSensorsChain)
+{
+  uint8_t packet[FRSKY_SPORT_PACKET_SIZE];
+
+  MODEL_RESET();
+  TELEMETRY_RESET();
+  telemetryStreaming = TELEMETRY_TIMEOUT10ms;
+  telemetryData.telemetryValid = 0x07;
+  allowNewSensors = true;
+
+  generateSportCellPacket(packet, 3, 0, 418, 416); sportProcessTelemetryPacket(packet);
+  generateSportCellPacket(packet, 3, 2, 415,   0); sportProcessTelemetryPacket(packet);
+  generateSportCellPacket(packet, 4, 0, 410, 420, DATA_ID_FLVSS+1); sportProcessTelemetryPacket(packet);
+  generateSportCellPacket(packet, 4, 2, 400, 405, DATA_ID_FLVSS+1); sportProcessTelemetryPacket(packet);
+
+  // sensor 3 depends on sensors 4 and 5, which are declared after it
+  g_model.telemetrySensors[2].type = TELEM_TYPE_CALCULATED;
+  g_model.telemetrySensors[2].formula = TELEM_FORMULA_ADD;
+  g_model.telemetrySensors[2].unit = UNIT_VOLTS;
+  g_model.telemetrySensors[2].prec = 2;
+  g_model.telemetrySensors[2].calc.sources[0] = 4;
+  g_model.telemetrySensors[2].calc.sources[1] = 5;
+  g_model.telemetrySensors[3].type = TELEM_TYPE_CALCULATED;
+  g_model.telemetrySensors[3].formula = TELEM_FORMULA_CELL;
+  g_model.telemetrySensors[3].unit = UNIT_VOLTS;
+  g_model.telemetrySensors[3].prec = 2;
+  g_model.telemetrySensors[3].cell.source = 1;
+  g_model.telemetrySensors[3].cell.index = TELEM_CELL_INDEX_LOWEST;
+  g_model.telemetrySensors[4].type = TELEM_TYPE_CALCULATED;
+  g_model.telemetrySensors[4].formula = TELEM_FORMULA_CELL;
+  g_model.telemetrySensors[4].unit = UNIT_VOLTS;
+  g_model.telemetrySensors[4].prec = 2;
+  g_model.telemetrySensors[4].cell.source = 2;
+  g_model.telemetrySensors[4].cell.index = TELEM_CELL_INDEX_HIGHEST;
+
+  telemetryWakeup();
+
+  EXPECT_EQ(telemetryItems[3].value, 415);
+  EXPECT_EQ(telemetryItems[4].value, 420);
+  EXPECT_EQ(telemetryItems[2].value, 835);
+
+  // no new value: the sensors are not evaluated again, but they stay fresh
+  uint8_t version = telemetryItems[2].version;
+  telemetryItems[2].timeout = TELEMETRY_SENSOR_TIMEOUT_START - 2;
+  telemetryWakeup();
+  EXPECT_EQ(telemetryItems[2].version, version);
+  EXPECT_TRUE(telemetryItems[2].isFresh());
+
+  generateSportCellPacket(packet, 4, 0, 410, 425, DATA_ID_FLVSS+1); sportProcessTelemetryPacket(packet);
+  telemetryWakeup();
+  EXPECT_EQ(telemetryItems[2].value, 840);
+
+  // a change of configuration is taken into account on the next pass
+  g_model.telemetrySensors[4].cell.index = TELEM_CELL_INDEX_LOWEST;
+  telemetryWakeup();
+  EXPECT_EQ(telemetryItems[4].value, 400);
+  EXPECT_EQ(telemetryItems[2].value, 815);
+}
+
 void generateSportFasVoltagePacket(uint8_t * packet, uint32_t voltage)
 {
   packet[0] = 0x22; //DATA_ID_FAS
@@ -496,3 +557,55 @@ TEST(FrSkySPORT, frskyCurrent)
   EXPECT_EQ(telemetryItems[0].valueMax, 505);
 }
 
+
+TEST(Telemetry, snapshotPublish)
+{
+  TELEMETRY_RESET();
+  telemetrySnapshot.publish();
+
+  telemetryItems[0].value = 100;
+  telemetryItems[0].valueMin = 90;
+  telemetryItems[0].valueMax = 110;
+  telemetryItems[0].setFresh();
+  EXPECT_EQ(telemetrySnapshot[0].value, 0);
+
+  telemetrySnapshot.publish();
+  EXPECT_EQ(telemetrySnapshot[0].value, 100);
+  EXPECT_EQ(telemetrySnapshot[0].valueMin, 90);
+  EXPECT_EQ(telemetrySnapshot[0].valueMax, 110);
+  EXPECT_FALSE(telemetrySnapshot[0].isOld());
+
+  telemetryItems[0].setOld();
+  telemetrySnapshot.publish();
+  EXPECT_TRUE(telemetrySnapshot[0].isOld());
+}
+
+TEST(Telemetry, snapshotConcurrentRead)
+{
+  // the writer keeps value, valueMin and valueMax equal: a torn read would see them differ
+  TELEMETRY_RESET();
+  telemetrySnapshot.publish();
+
+  std::atomic<bool> running(true);
+  std::thread writer([&running]() {
+    for (int32_t value=1; running; value++) {
+      for (auto & telemetryItem: telemetryItems) {
+        telemetryItem.value = telemetryItem.valueMin = telemetryItem.valueMax = value;
+      }
+      telemetrySnapshot.publish();
+    }
+  });
+
+  int torn = 0;
+  for (int i=0; i<200000; i++) {
+    TelemetrySnapshot::Item item = telemetrySnapshot[i % MAX_TELEMETRY_SENSORS];
+    if (item.value != item.valueMin || item.value != item.valueMax) {
+      torn++;
+    }
+  }
+
+  running = false;
+  writer.join();
+  EXPECT_EQ(torn, 0);
+  TELEMETRY_RESET();
+}
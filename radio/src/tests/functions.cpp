@@ -57,6 +57,25 @@ TEST_F(SpecialFunctionsTest, FlightReset)
   EXPECT_EQ((bool)(mainRequestFlags & (1 << REQUEST_FLIGHT_RESET)), false);
 }
 
+TEST_F(SpecialFunctionsTest, TelemetrySensorReset)
+{
+  g_model.customFn[0].swtch = SWSRC_SA0;
+  g_model.customFn[0].func = FUNC_RESET;
+  g_model.customFn[0].all.val = FUNC_RESET_PARAM_FIRST_TELEM + 1;
+  g_model.customFn[0].active = true;
+
+  telemetryItems[1].value = 100;
+  telemetryItems[1].setFresh();
+
+  simuSetSwitch(0, -1);
+  evalFunctions(g_model.customFn, modelFunctionsContext);
+
+  // the reset is done by the telemetry task, not by the mixer
+  EXPECT_TRUE(telemetryItems[1].isAvailable());
+  telemetryWakeup();
+  EXPECT_FALSE(telemetryItems[1].isAvailable());
+}
+
 #if defined(GVARS)
 TEST_F(SpecialFunctionsTest, GvarsInc)
 {
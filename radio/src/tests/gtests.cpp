@@ -158,6 +158,7 @@ const char * nchar2string(const char * string, int size)
 int main(int argc, char **argv)
 {
   QCoreApplication app(argc, argv);
+  simuClockSet(SIMU_CLOCK_VIRTUAL);
   simuInit();
   StartEepromThread(nullptr);
 #if defined(EEPROM_SIZE)
@@ -80,6 +80,13 @@ inline void MIXER_RESET()
   logicalSwitchesReset();
 }
 
+// the tests run on the simulator virtual clock: time only moves when
+// advanced, the 10ms timer as its interrupt would
+inline void TIME_ADVANCE(uint32_t ms)
+{
+  g_tmr10ms += simuClockAdvance(1000 * (uint64_t)ms);
+}
+
 inline void TELEMETRY_RESET()
 {
   telemetryData.clear();
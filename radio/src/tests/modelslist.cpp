@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) OpenTX
+ *
+ * Based on code named
+ *   th9x - http://code.google.com/p/th9x
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <sys/stat.h>
+#include <utime.h>
+#include "gtests.h"
+
+#if defined(PCBHORUS)
+#include "location.h"
+#include "storage/modelslist.h"
+
+#define MODELS_TESTS_PATH    TESTS_BUILD_PATH "/models_cache"
+
+const char * writeFile(const char * filename, const uint8_t * data, uint16_t size);
+
+class ModelsListTest : public OpenTxTest
+{
+  protected:
+    void SetUp() override
+    {
+      OpenTxTest::SetUp();
+      mkdir(MODELS_TESTS_PATH, 0777);
+      simuFatfsSetPaths(MODELS_TESTS_PATH "/", MODELS_TESTS_PATH "/");
+      f_mkdir(RADIO_PATH);
+      f_mkdir(MODELS_PATH);
+      f_unlink(RADIO_MODELSCACHE_PATH);
+      strcpy(g_eeGeneral.currModelFilename, "model1.bin");
+    }
+
+    void TearDown() override
+    {
+      modelslist.clear();
+    }
+
+    void writeModel(const char * filename, const char * name, uint8_t moduleType = MODULE_TYPE_NONE)
+    {
+      char path[256];
+      MODEL_RESET();
+      str2zchar(g_model.header.name, name, LEN_MODEL_NAME);
+      g_model.moduleData[INTERNAL_MODULE].type = moduleType;
+      getModelPath(path, filename);
+      writeFile(path, (uint8_t *)&g_model, sizeof(g_model));
+    }
+
+    void writeModelsList(const char * content)
+    {
+      FIL file;
+      f_open(&file, RADIO_MODELSLIST_PATH, FA_CREATE_ALWAYS | FA_WRITE);
+      f_puts(content, &file);
+      f_close(&file);
+    }
+
+    void setModelTime(const char * filename, time_t modified)
+    {
+      struct utimbuf times = { modified, modified };
+      std::string path = std::string(MODELS_TESTS_PATH "/MODELS/") + filename;
+      utime(path.c_str(), &times);
+    }
+
+    void writeThumbnail(const char * filename)
+    {
+      FIL file;
+      char path[256];
+      f_mkdir(THUMBNAILS_PATH);
+      strcpy(path, THUMBNAILS_PATH "/");
+      strcat(path, filename);
+      f_open(&file, path, FA_CREATE_ALWAYS | FA_WRITE);
+      f_puts("OTXT", &file);
+      f_close(&file);
+    }
+
+    bool hasThumbnail(const char * filename)
+    {
+      FILINFO fno;
+      char path[256];
+      strcpy(path, THUMBNAILS_PATH "/");
+      strcat(path, filename);
+      return f_stat(path, &fno) == FR_OK;
+    }
+
+    const char * getModelName(const char * filename)
+    {
+      ModelCell * model = modelslist.findModel(filename);
+      return model ? model->modelName : nullptr;
+    }
+
+    void reload()
+    {
+      // g_model is the current model
+      writeModel("model1.bin", "One");
+      modelslist.clear();
+      modelslist.load();
+    }
+};
+
+TEST_F(ModelsListTest, cacheUsedWhenFileUnchanged)
+{
+  writeModel("model2.bin", "Two", MODULE_TYPE_XJT_PXX1);
+  setModelTime("model2.bin", 1000000000);
+  writeModelsList("[Models]\nmodel1.bin\nmodel2.bin\n");
+  reload();
+  EXPECT_STREQ("Two", getModelName("model2.bin"));
+  EXPECT_EQ(MODULE_TYPE_XJT_PXX1, modelslist.findModel("model2.bin")->moduleData[INTERNAL_MODULE].type);
+
+  FILINFO fno;
+  EXPECT_EQ(FR_OK, f_stat(RADIO_MODELSCACHE_PATH, &fno));
+
+  // same size, same date: the model file is not read again
+  writeModel("model2.bin", "Other");
+  setModelTime("model2.bin", 1000000000);
+  reload();
+  EXPECT_STREQ("Two", getModelName("model2.bin"));
+}
+
+TEST_F(ModelsListTest, cacheInvalidatedWhenFileEdited)
+{
+  writeModel("model2.bin", "Two");
+  setModelTime("model2.bin", 1000000000);
+  writeModelsList("[Models]\nmodel1.bin\nmodel2.bin\n");
+  reload();
+  EXPECT_STREQ("Two", getModelName("model2.bin"));
+
+  // edited outside the radio, the size didn't change
+  writeModel("model2.bin", "Edited", MODULE_TYPE_R9M_PXX1);
+  setModelTime("model2.bin", 1000000100);
+  reload();
+  EXPECT_STREQ("Edited", getModelName("model2.bin"));
+  EXPECT_EQ(MODULE_TYPE_R9M_PXX1, modelslist.findModel("model2.bin")->moduleData[INTERNAL_MODULE].type);
+
+  // the current model is taken from g_model
+  g_model.moduleData[INTERNAL_MODULE].type = MODULE_TYPE_XJT_PXX1;
+  modelslist.clear();
+  modelslist.load();
+  EXPECT_EQ(MODULE_TYPE_XJT_PXX1, modelslist.findModel("model1.bin")->moduleData[INTERNAL_MODULE].type);
+}
+
+TEST_F(ModelsListTest, cacheModelsAddedAndRemoved)
+{
+  writeModel("model2.bin", "Two");
+  writeModel("model3.bin", "Three");
+  setModelTime("model3.bin", 1000000000);
+  writeModelsList("[Models]\nmodel1.bin\nmodel2.bin\n");
+  reload();
+  EXPECT_STREQ("Two", getModelName("model2.bin"));
+  EXPECT_EQ(nullptr, getModelName("model3.bin"));
+
+  // added
+  writeModelsList("[Models]\nmodel1.bin\nmodel2.bin\nmodel3.bin\n");
+  reload();
+  EXPECT_STREQ("Three", getModelName("model3.bin"));
+
+  // removed: its cache entry goes away with it
+  writeModelsList("[Models]\nmodel1.bin\nmodel2.bin\n");
+  reload();
+  EXPECT_EQ(nullptr, getModelName("model3.bin"));
+
+  // so that a new file with the same name, size and date is read
+  writeModel("model3.bin", "New");
+  setModelTime("model3.bin", 1000000000);
+  writeModelsList("[Models]\nmodel1.bin\nmodel2.bin\nmodel3.bin\n");
+  reload();
+  EXPECT_STREQ("New", getModelName("model3.bin"));
+}
+
+TEST_F(ModelsListTest, cacheCorrupted)
+{
+  writeModel("model2.bin", "Two");
+  setModelTime("model2.bin", 1000000000);
+  writeModelsList("[Models]\nmodel2.bin\nmodel1.bin\n");
+  reload();
+  EXPECT_STREQ("Two", getModelName("model2.bin"));
+
+  // the model name of the first entry is changed in the cache
+  FILE * f = fopen(MODELS_TESTS_PATH "/RADIO/models.idx", "r+b");
+  ASSERT_NE(nullptr, f);
+  fseek(f, sizeof(ModelsCacheHeader) + LEN_MODEL_FILENAME, SEEK_SET);
+  fputc('X', f);
+  fclose(f);
+  reload();
+  EXPECT_STREQ("Two", getModelName("model2.bin"));
+
+  // truncated
+  f = fopen(MODELS_TESTS_PATH "/RADIO/models.idx", "wb");
+  ASSERT_NE(nullptr, f);
+  fwrite("OTXM", 1, 4, f);
+  fclose(f);
+  reload();
+  EXPECT_STREQ("Two", getModelName("model2.bin"));
+  EXPECT_STREQ("One", getModelName("model1.bin"));
+}
+
+TEST_F(ModelsListTest, thumbnailsRemoved)
+{
+  writeModel("model2.bin", "Two");
+  writeModel("model3.bin", "Three");
+  writeModelsList("[Models]\nmodel1.bin\nmodel2.bin\nmodel3.bin\n");
+  writeThumbnail("model2.bin");
+  writeThumbnail("model3.bin");
+  writeThumbnail("deleted.bin");
+  reload();
+
+  // deleted or renamed outside the radio
+  EXPECT_FALSE(hasThumbnail("deleted.bin"));
+  EXPECT_TRUE(hasThumbnail("model2.bin"));
+
+  // deleted from the model selector
+  modelslist.removeModel(modelslist.getCategories().front(), modelslist.findModel("model2.bin"));
+  EXPECT_FALSE(hasThumbnail("model2.bin"));
+
+  // deleted or renamed from the SD manager
+  removeModelThumbnail("/SOUNDS/model3.bin");
+  EXPECT_TRUE(hasThumbnail("model3.bin"));
+  removeModelThumbnail(MODELS_PATH "/model3.bin");
+  EXPECT_FALSE(hasThumbnail("model3.bin"));
+}
+#endif
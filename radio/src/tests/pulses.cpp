@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) OpenTX
+ *
+ * Based on code named
+ *   th9x - http://code.google.com/p/th9x 
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "gtests.h"
+
+class SumCrc {
+  public:
+    uint16_t value = 0;
+
+    void addToCrc(uint8_t byte)
+    {
+      value += byte;
+    }
+
+    void addWordToCrc(uint32_t word)
+    {
+      value += (word & 0xFF) + ((word >> 8) & 0xFF) + ((word >> 16) & 0xFF) + (word >> 24);
+    }
+};
+
+TEST(Pulses, channelsPacker12Bits)
+{
+  uint8_t frame[40];
+  uint16_t values[24];
+  SumCrc crc;
+
+  memset(frame, 0xAA, sizeof(frame));
+  ChannelsPacker<12, SumCrc> packer(frame, crc);
+  for (int i=0; i<24; i++) {
+    values[i] = (i * 367 + 11) & 0x7FF;
+    packer.addValue(values[i]);
+  }
+  EXPECT_EQ(packer.end(), &frame[36]);
+  EXPECT_EQ(frame[36], 0xAA);
+
+  // the PXX2 channels layout: 2 channels in 3 bytes
+  uint16_t sum = 0;
+  for (int i=0; i<24; i+=2) {
+    uint16_t low = values[i], high = values[i+1];
+    uint8_t * bytes = &frame[i/2*3];
+    EXPECT_EQ(bytes[0], uint8_t(low));
+    EXPECT_EQ(bytes[1], uint8_t(((low >> 8) & 0x0F) | (high << 4)));
+    EXPECT_EQ(bytes[2], uint8_t(high >> 4));
+    sum += bytes[0] + bytes[1] + bytes[2];
+  }
+  EXPECT_EQ(crc.value, sum);
+}
@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) OpenTX
+ *
+ * Based on code named
+ *   th9x - http://code.google.com/p/th9x 
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+
+#include "gtests.h"
+#include "storage/rlc.h"
+
+// the byte per byte encoder the word-wide one must stay bit-exact with
+static unsigned int compressReference(uint8_t * dst, const uint8_t * src, unsigned int srcsize)
+{
+  uint8_t * cur = dst;
+  bool    run0   = (src[0] == 0);
+  uint8_t cnt    = 1;
+  uint8_t cnt0   = 0;
+
+  for (unsigned int i=1; 1; i++) {
+    bool cur0 = (i < srcsize) ? (src[i] == 0) : false;
+    if (i==srcsize || cur0!=run0 || cnt==0x3f || (cnt0 && cnt==0xf)) {
+      if (run0) {
+        if (cnt<8 && i!=srcsize) {
+          cnt0 = cnt;
+        }
+        else {
+          *cur++ = (cnt | 0x40);
+        }
+      }
+      else {
+        if (cnt0) {
+          *cur++ = (0x80 | (cnt0<<4) | cnt);
+          cnt0 = 0;
+        }
+        else {
+          *cur++ = cnt;
+        }
+        for (int j=0; j<cnt; j++) {
+          *cur++ = src[i - cnt + j];
+        }
+      }
+      cnt = 0;
+      if (i==srcsize) break;
+      run0 = cur0;
+    }
+    cnt++;
+  }
+
+  return cur-dst;
+}
+
+static unsigned int fillRandom(uint8_t * buf, unsigned int size, int zeroes)
+{
+  unsigned int len = 1 + rand() % size;
+  for (unsigned int i=0; i<len; ) {
+    // runs of random lengths around the 8 / 15 / 63 bytes limits of the format
+    unsigned int run = 1 + rand() % 80;
+    bool zero = (rand() % 100) < zeroes;
+    for (unsigned int j=0; j<run && i<len; j++, i++) {
+      buf[i] = zero ? 0 : 1 + rand() % 255;
+    }
+  }
+  return len;
+}
+
+TEST(Rlc, countRuns)
+{
+  uint8_t buf[64];
+  for (unsigned int pos=0; pos<sizeof(buf); pos++) {
+    memset(buf, 0, sizeof(buf));
+    buf[pos] = 0x80;
+    EXPECT_EQ(pos, rlcCountZeroes(buf, sizeof(buf), 0xff));
+    EXPECT_EQ(min<unsigned int>(pos, 0x3f), rlcCountZeroes(buf, sizeof(buf), 0x3f));
+    memset(buf, 0x01, sizeof(buf));
+    buf[pos] = 0;
+    EXPECT_EQ(pos, rlcCountBytes(buf, sizeof(buf), 0xff));
+    EXPECT_EQ(min<unsigned int>(pos, 0x0f), rlcCountBytes(buf, sizeof(buf), 0x0f));
+    // 0x0100 patterns give false positives in the zero byte detection above the first zero
+    memset(buf, 0x01, sizeof(buf));
+    buf[pos] = 0;
+    if (pos+1 < sizeof(buf))
+      buf[pos+1] = 0x01;
+    EXPECT_EQ(pos, rlcCountBytes(buf, pos+1, 0xff));
+  }
+}
+
+#if defined(RAMBACKUP)
+TEST(Rlc, compressBitExact)
+{
+  uint8_t src[2000], dst[4000], ref[4000], out[2000];
+  srand(0x5a5a);
+  for (int test=0; test<2000; test++) {
+    unsigned int offset = test % 4;
+    unsigned int len = fillRandom(&src[offset], sizeof(src) - offset, test % 100);
+    unsigned int size = compress(dst, sizeof(dst), &src[offset], len);
+    ASSERT_EQ(compressReference(ref, &src[offset], len), size);
+    ASSERT_EQ(0, memcmp(dst, ref, size));
+    ASSERT_EQ(len, uncompress(out, sizeof(out), dst, size));
+    ASSERT_EQ(0, memcmp(out, &src[offset], len));
+  }
+}
+
+TEST(Rlc, sizeLimits)
+{
+  uint8_t src[200], dst[300], out[200];
+  for (unsigned int i=0; i<sizeof(src); i++) {
+    src[i] = 1 + i;
+  }
+  unsigned int size = compress(dst, sizeof(dst), src, sizeof(src));
+  EXPECT_EQ(0u, compress(dst, size - 1, src, sizeof(src)));
+  EXPECT_EQ(size, compress(dst, size, src, sizeof(src)));
+  EXPECT_EQ(0u, uncompress(out, sizeof(src) - 1, dst, size));
+  EXPECT_EQ(sizeof(src), uncompress(out, sizeof(src), dst, size));
+
+  // a truncated source gives the bytes decoded so far
+  EXPECT_EQ(10u, uncompress(out, sizeof(out), dst, 11));
+
+  // 0x00 and 0x80 are invalid codes
+  const uint8_t invalid[] = { 0x41, 0x80, 0x01 };
+  EXPECT_EQ(0u, uncompress(out, sizeof(out), invalid, sizeof(invalid)));
+}
+
+TEST(Rlc, uncompressFuzz)
+{
+  uint8_t src[300], out[1000];
+  srand(0xa5a5);
+  for (int test=0; test<5000; test++) {
+    unsigned int len = 1 + rand() % sizeof(src);
+    for (unsigned int i=0; i<len; i++) {
+      src[i] = rand();
+    }
+    unsigned int size = uncompress(out, sizeof(out), src, len);
+    ASSERT_LE(size, sizeof(out));
+  }
+}
+#endif
+
+#if defined(EEPROM_RLC)
+extern const char * eepromFile;
+
+TEST(Rlc, eepromBitExact)
+{
+  eepromFile = NULL; // in memory
+  RlcFile f;
+  uint8_t buf[800], ref[1600], raw[1600];
+
+  storageFormat();
+
+  srand(0x1234);
+  for (int test=0; test<200; test++) {
+    unsigned int len = fillRandom(buf, sizeof(buf), test % 100);
+    f.writeRlc(5, 5, buf, len, true);
+    unsigned int size = compressReference(ref, buf, len);
+    f.openRd(5);
+    unsigned int pos = 0;
+    while (uint8_t count = f.read(&raw[pos], 255)) {
+      pos += count;
+    }
+    ASSERT_EQ(size, pos);
+    ASSERT_EQ(0, memcmp(raw, ref, size));
+  }
+}
+#endif
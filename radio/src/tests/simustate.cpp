@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) OpenTX
+ *
+ * Based on code named
+ *   th9x - http://code.google.com/p/th9x 
+ *   er9x - http://code.google.com/p/er9x
+ *   gruvin9x - http://code.google.com/p/gruvin9x
+ *
+ * License GPLv2: http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <vector>
+#include "gtests.h"
+
+TEST(SimuState, saveRestore)
+{
+  SYSTEM_RESET();
+  MODEL_RESET();
+  g_eeGeneral.backlightMode = e_backlight_mode_keys;
+  strncpy(g_model.header.name, "SNAP", sizeof(g_model.header.name));
+
+  uint32_t size = simuSaveState(nullptr, 0);
+  std::vector<uint8_t> state(size);
+  EXPECT_EQ(size, simuSaveState(state.data(), size - 1));  // too small, nothing written
+  EXPECT_EQ(size, simuSaveState(state.data(), size));
+
+  g_eeGeneral.backlightMode = e_backlight_mode_on;
+  MODEL_RESET();
+  EXPECT_TRUE(simuRestoreState(state.data(), size));
+  EXPECT_EQ(e_backlight_mode_keys, g_eeGeneral.backlightMode);
+  EXPECT_EQ(0, memcmp(g_model.header.name, "SNAP", 4));
+}
+
+TEST(SimuState, invalidSnapshot)
+{
+  MODEL_RESET();
+  g_model.header.name[0] = 'A';
+
+  uint32_t size = simuSaveState(nullptr, 0);
+  std::vector<uint8_t> state(size);
+  simuSaveState(state.data(), size);
+  g_model.header.name[0] = 'B';
+
+  // truncated or corrupted snapshots are rejected and leave the state unchanged
+  EXPECT_FALSE(simuRestoreState(state.data(), size - 1));
+  EXPECT_FALSE(simuRestoreState(nullptr, size));
+  state[0] ^= 0xFF;
+  EXPECT_FALSE(simuRestoreState(state.data(), size));
+  EXPECT_EQ('B', g_model.header.name[0]);
+}
+
+TEST(SimuState, runtimeState)
+{
+  MODEL_RESET();
+  MIXER_RESET();
+  timersStates[0].val = 42;
+  act[1] = 1234;
+  swOn[1].delay = 50;
+  lswFm[0].lsw[2].lastValue = -100;
+  telemetryItems[3].value = 77;
+  mixerCurrentFlightMode = 2;
+
+  uint32_t size = simuSaveState(nullptr, 0);
+  std::vector<uint8_t> state(size);
+  simuSaveState(state.data(), size);
+
+  MIXER_RESET();
+  timersStates[0].val = 0;
+  telemetryItems[3].clear();
+
+  EXPECT_TRUE(simuRestoreState(state.data(), size));
+  EXPECT_EQ(42, timersStates[0].val);
+  EXPECT_EQ(1234, act[1]);
+  EXPECT_EQ(50, swOn[1].delay);
+  EXPECT_EQ(-100, lswFm[0].lsw[2].lastValue);
+  EXPECT_EQ(77, telemetryItems[3].value);
+  EXPECT_EQ(2, mixerCurrentFlightMode);
+
+  MIXER_RESET();
+  TELEMETRY_RESET();
+}
+
+TEST(SimuState, restoreKeepsTimeRunning)
+{
+  MODEL_RESET();
+  g_tmr10ms = 1000;
+  modelFunctionsContext.lastFunctionTime[0] = 990;
+  modelFunctionsContext.lastFunctionTime[1] = 0;
+
+  uint32_t size = simuSaveState(nullptr, 0);
+  std::vector<uint8_t> state(size);
+  simuSaveState(state.data(), size);
+
+  // the clock is not rewound, the timestamps are moved along
+  g_tmr10ms = 5000;
+  EXPECT_TRUE(simuRestoreState(state.data(), size));
+  EXPECT_EQ(5000, g_tmr10ms);
+  EXPECT_EQ(4990, modelFunctionsContext.lastFunctionTime[0]);
+  EXPECT_EQ(0, modelFunctionsContext.lastFunctionTime[1]);
+
+  memclear(&modelFunctionsContext, sizeof(modelFunctionsContext));
+}
+
+TEST(SimuState, restoreRefreshesDerivedState)
+{
+  MODEL_RESET();
+  TELEMETRY_RESET();
+  telemetryItems[3].value = 77;
+  telemetryItems[3].setFresh();
+
+  uint32_t size = simuSaveState(nullptr, 0);
+  std::vector<uint8_t> state(size);
+  simuSaveState(state.data(), size);
+
+  telemetryItems[3].clear();
+  telemetrySnapshot.publish();
+  moduleState[EXTERNAL_MODULE].mode = MODULE_MODE_BIND;
+
+  // the sensors values are published again and the modules leave the bind mode
+  EXPECT_TRUE(simuRestoreState(state.data(), size));
+  EXPECT_EQ(77, telemetrySnapshot[3].value);
+  EXPECT_EQ(MODULE_MODE_NORMAL, moduleState[EXTERNAL_MODULE].mode);
+
+  TELEMETRY_RESET();
+}
@@ -309,3 +309,36 @@ TEST(getSwitch, edgeRelease)
 
 }
 #endif // defined(PCBTARANIS)
+
+#if defined(PCBTARANIS) || defined(PCBHORUS)
+TEST(getSwitch, midPositionDelay)
+{
+  SYSTEM_RESET();
+  g_eeGeneral.switchesDelay = 0;
+  TIME_ADVANCE(10);
+
+  simuSetSwitch(0, -1);
+  getSwitchesPosition(true);
+  EXPECT_EQ(getSwitch(SWSRC_SA0, GETSWITCH_MIDPOS_DELAY), true);
+
+  // the middle position is only reported after the switches delay
+  simuSetSwitch(0, 0);
+  getSwitchesPosition(false);
+  EXPECT_EQ(getSwitch(SWSRC_SA0, GETSWITCH_MIDPOS_DELAY), true);
+  EXPECT_EQ(getSwitch(SWSRC_SA1, GETSWITCH_MIDPOS_DELAY), false);
+
+  TIME_ADVANCE(10 * SWITCHES_DELAY());
+  getSwitchesPosition(false);
+  EXPECT_EQ(getSwitch(SWSRC_SA1, GETSWITCH_MIDPOS_DELAY), false);
+
+  TIME_ADVANCE(10);
+  getSwitchesPosition(false);
+  EXPECT_EQ(getSwitch(SWSRC_SA0, GETSWITCH_MIDPOS_DELAY), false);
+  EXPECT_EQ(getSwitch(SWSRC_SA1, GETSWITCH_MIDPOS_DELAY), true);
+
+  // the end positions are reported immediately
+  simuSetSwitch(0, 1);
+  getSwitchesPosition(false);
+  EXPECT_EQ(getSwitch(SWSRC_SA2, GETSWITCH_MIDPOS_DELAY), true);
+}
+#endif
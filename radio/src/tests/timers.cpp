@@ -18,6 +18,8 @@
  * GNU General Public License for more details.
  */
 
+#include <atomic>
+#include <thread>
 #include "gtests.h"
 
 #define THR_100    128      // approximately 10% full throttle
@@ -192,3 +194,43 @@ TEST(Timers, timerThrottleTriggered)
   EXPECT_TRUE(evalTimersForNSecondsAndTest(10,         0, 0, TMR_NEGATIVE,-11));
   EXPECT_TRUE(evalTimersForNSecondsAndTest(100,        0, 0, TMR_STOPPED,-111));
 }
+
+TEST(Timers, virtualClock)
+{
+  ASSERT_EQ(SIMU_CLOCK_VIRTUAL, simuClockGet());
+
+  uint32_t ms = RTOS_GET_MS();
+  tmr10ms_t tmr10ms = get_tmr10ms();
+  EXPECT_EQ(ms, RTOS_GET_MS());
+
+  TIME_ADVANCE(25);
+  EXPECT_EQ(ms + 25, RTOS_GET_MS());
+  EXPECT_EQ(tmr10ms + ((ms % 10) + 25) / 10, get_tmr10ms());
+
+  // the RTOS waits advance the clock instead of sleeping
+  RTOS_WAIT_MS(1000);
+  EXPECT_EQ(ms + 1025, RTOS_GET_MS());
+  RTOS_WAIT_TICKS(5);
+  EXPECT_EQ(ms + 1025 + 5 * RTOS_MS_PER_TICK, RTOS_GET_MS());
+}
+
+TEST(Timers, virtualClockOtherThread)
+{
+  uint32_t ms = RTOS_GET_MS();
+  std::atomic<bool> done(false);
+
+  // only the stepping thread advances the clock, the others wait for it
+  std::thread waiter([&]() {
+    RTOS_WAIT_MS(20);
+    done = true;
+  });
+
+  usleep(50000);
+  EXPECT_FALSE(done);
+  EXPECT_EQ(ms, RTOS_GET_MS());
+
+  TIME_ADVANCE(20);
+  waiter.join();
+  EXPECT_TRUE(done);
+  EXPECT_EQ(ms + 20, RTOS_GET_MS());
+}